@@ -0,0 +1,94 @@
+#include <mn/Deque.h>
+#include <mn/Buf.h>
+#include <mn/Defer.h>
+
+#include <nanobench.h>
+
+#include <deque>
+
+// deque benchmark, it compares std::deque, mn::Deque and mn::Buf using
+// - scan: sums 1M elements with operator[] and with the deque segments which should be as fast as scanning a buf
+// - push/pop: pushes 1M elements to the back then pops all of them from the front one by one and in bulk
+
+constexpr size_t ELEMENTS_COUNT = 1'000'000;
+
+int
+main()
+{
+	auto input = mn::buf_with_count<uint32_t>(ELEMENTS_COUNT);
+	mn_defer{mn::buf_free(input);};
+	for (size_t i = 0; i < input.count; ++i)
+		input[i] = uint32_t(i * 2654435761U);
+
+	auto scan_bench = ankerl::nanobench::Bench().title("1M scan").unit("element").batch(input.count).relative(true).minEpochIterations(20);
+	auto push_pop_bench = ankerl::nanobench::Bench().title("1M push/pop").unit("element").batch(input.count).relative(true).minEpochIterations(10);
+
+	std::deque<uint32_t> std_deque(input.ptr, input.ptr + input.count);
+	auto deque = mn::deque_new<uint32_t>();
+	mn_defer{mn::deque_free(deque);};
+	mn::deque_push_back_n(deque, input);
+
+	scan_bench.run("mn::Buf", [&] {
+		uint64_t sum = 0;
+		for (auto v: input)
+			sum += v;
+		ankerl::nanobench::doNotOptimizeAway(sum);
+	});
+
+	scan_bench.run("std::deque", [&] {
+		uint64_t sum = 0;
+		for (auto v: std_deque)
+			sum += v;
+		ankerl::nanobench::doNotOptimizeAway(sum);
+	});
+
+	scan_bench.run("mn::Deque operator[]", [&] {
+		uint64_t sum = 0;
+		for (size_t i = 0; i < deque.count; ++i)
+			sum += deque[i];
+		ankerl::nanobench::doNotOptimizeAway(sum);
+	});
+
+	scan_bench.run("mn::Deque segments", [&] {
+		uint64_t sum = 0;
+		for (auto segment: mn::deque_segments(deque))
+			for (auto v: segment)
+				sum += v;
+		ankerl::nanobench::doNotOptimizeAway(sum);
+	});
+
+	push_pop_bench.run("std::deque", [&] {
+		std_deque.clear();
+		for (auto v: input)
+			std_deque.push_back(v);
+		uint64_t sum = 0;
+		while (std_deque.empty() == false)
+		{
+			sum += std_deque.front();
+			std_deque.pop_front();
+		}
+		ankerl::nanobench::doNotOptimizeAway(sum);
+	});
+
+	push_pop_bench.run("mn::Deque", [&] {
+		for (auto v: input)
+			mn::deque_push_back(deque, v);
+		uint64_t sum = 0;
+		while (deque.count > 0)
+		{
+			sum += mn::deque_front(deque);
+			mn::deque_pop_front(deque);
+		}
+		ankerl::nanobench::doNotOptimizeAway(sum);
+	});
+
+	auto output = mn::buf_with_count<uint32_t>(ELEMENTS_COUNT);
+	mn_defer{mn::buf_free(output);};
+	push_pop_bench.run("mn::Deque bulk", [&] {
+		mn::deque_push_back_n(deque, input);
+		mn::deque_pop_front_n(deque, output.ptr, output.count);
+		ankerl::nanobench::doNotOptimizeAway(output.ptr[output.count - 1]);
+	});
+
+	return 0;
+}
@@ -0,0 +1,104 @@
+#include <mn/Heap.h>
+#include <mn/Buf.h>
+#include <mn/Defer.h>
+
+#include <nanobench.h>
+
+#include <queue>
+#include <vector>
+#include <functional>
+#include <string>
+
+// priority queue benchmark, it compares std::priority_queue with the binary and 4-ary mn::Heap using
+// - push/pop all: pushes 1M random elements then pops all of them
+// - hold: keeps 1M elements in the heap and repeatedly pops the top and pushes a later one, which is the access
+//   pattern of timer queues and schedulers, the mn::Heap runs it twice with and without handles
+
+constexpr size_t ELEMENTS_COUNT = 1'000'000;
+
+inline static uint64_t
+xorshift(uint64_t& x)
+{
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	return x;
+}
+
+template<size_t ARITY>
+inline static void
+bench_mn_heap(ankerl::nanobench::Bench& push_pop_bench, ankerl::nanobench::Bench& hold_bench, const char* name, const mn::Buf<uint64_t>& input)
+{
+	auto heap = mn::heap_new<uint64_t, mn::Heap_Less<uint64_t>, ARITY>();
+	mn_defer{mn::heap_free(heap);};
+	mn::heap_reserve(heap, input.count);
+
+	push_pop_bench.run(name, [&] {
+		for (auto v: input)
+			mn::heap_push(heap, v);
+		uint64_t sum = 0;
+		while (mn::heap_empty(heap) == false)
+			sum += mn::heap_pop(heap);
+		ankerl::nanobench::doNotOptimizeAway(sum);
+	});
+
+	for (auto v: input)
+		mn::heap_push(heap, v);
+	size_t i = 0;
+	hold_bench.run(name, [&] {
+		auto top = mn::heap_pop(heap);
+		mn::heap_push(heap, top + input.ptr[i++ % input.count]);
+	});
+
+	mn::heap_clear(heap);
+	for (auto v: input)
+		mn::heap_push_handle(heap, v);
+	i = 0;
+	hold_bench.run(std::string(name) + " with handles", [&] {
+		auto top = mn::heap_pop(heap);
+		mn::heap_push_handle(heap, top + input.ptr[i++ % input.count]);
+	});
+}
+
+int
+main()
+{
+	uint64_t x = 0x9E3779B97F4A7C15ULL;
+
+	auto input = mn::buf_with_count<uint64_t>(ELEMENTS_COUNT);
+	mn_defer{mn::buf_free(input);};
+	for (auto& v: input)
+		v = xorshift(x) >> 24;
+
+	auto push_pop_bench = ankerl::nanobench::Bench().title("1M push/pop all").unit("element").batch(input.count).relative(true).epochs(3).epochIterations(1);
+	auto hold_bench = ankerl::nanobench::Bench().title("1M hold").unit("op").relative(true).minEpochIterations(1'000'000);
+
+	{
+		std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>> queue;
+		push_pop_bench.run("std::priority_queue", [&] {
+			for (auto v: input)
+				queue.push(v);
+			uint64_t sum = 0;
+			while (queue.empty() == false)
+			{
+				sum += queue.top();
+				queue.pop();
+			}
+			ankerl::nanobench::doNotOptimizeAway(sum);
+		});
+
+		for (auto v: input)
+			queue.push(v);
+		size_t i = 0;
+		hold_bench.run("std::priority_queue", [&] {
+			auto top = queue.top();
+			queue.pop();
+			queue.push(top + input.ptr[i++ % input.count]);
+		});
+	}
+
+	bench_mn_heap<2>(push_pop_bench, hold_bench, "Heap", input);
+	bench_mn_heap<4>(push_pop_bench, hold_bench, "Heap4", input);
+
+	return 0;
+}
@@ -0,0 +1,218 @@
+#include <mn/Map.h>
+#include <mn/Concurrent_Map.h>
+#include <mn/Thread.h>
+#include <mn/Str.h>
+#include <mn/Fmt.h>
+#include <mn/Defer.h>
+
+#include <nanobench.h>
+
+// hash map benchmark, it measures the hash map under the common operations with integer and string keys
+// - insert: inserting unique keys into an empty map
+// - lookup hit: looking up keys which exist in the map
+// - lookup miss: looking up keys which don't exist in the map
+// - remove: removing all the keys from the map
+// and it measures the concurrent map against a map guarded by a read-write mutex with multiple threads
+// - read heavy: 90% lookups and 10% inserts
+// - write heavy: 50% lookups and 50% inserts
+
+constexpr size_t KEYS_COUNT = 100000;
+constexpr size_t THREADS_COUNT = 4;
+constexpr size_t THREAD_OPS_COUNT = 100000;
+
+inline static uint64_t
+xorshift(uint64_t& x)
+{
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	return x;
+}
+
+template<typename TKey>
+inline static void
+bench_map(const char* title, const mn::Buf<TKey>& keys, const mn::Buf<TKey>& missing_keys)
+{
+	auto bench = ankerl::nanobench::Bench().title(title).unit("op").batch(keys.count).minEpochIterations(5);
+
+	bench.run("insert", [&] {
+		auto map = mn::map_new<TKey, size_t>();
+		for (size_t i = 0; i < keys.count; ++i)
+			mn::map_insert(map, keys[i], i);
+		ankerl::nanobench::doNotOptimizeAway(map.count);
+		mn::map_free(map);
+	});
+
+	auto map = mn::map_new<TKey, size_t>();
+	mn_defer{mn::map_free(map);};
+	for (size_t i = 0; i < keys.count; ++i)
+		mn::map_insert(map, keys[i], i);
+
+	bench.run("lookup hit", [&] {
+		size_t sum = 0;
+		for (const auto& key: keys)
+			sum += mn::map_lookup(map, key)->value;
+		ankerl::nanobench::doNotOptimizeAway(sum);
+	});
+
+	bench.run("lookup miss", [&] {
+		size_t found = 0;
+		for (const auto& key: missing_keys)
+			found += mn::map_lookup(map, key) != nullptr;
+		ankerl::nanobench::doNotOptimizeAway(found);
+	});
+
+	bench.run("remove", [&] {
+		auto copy = mn::map_memcpy_clone(map);
+		for (const auto& key: keys)
+			mn::map_remove(copy, key);
+		ankerl::nanobench::doNotOptimizeAway(copy.count);
+		mn::map_free(copy);
+	});
+}
+
+// a map guarded by a read-write mutex which is the baseline for the concurrent map
+struct Locked_Map
+{
+	mn::Mutex_RW mtx;
+	mn::Map<uint64_t, size_t> map;
+};
+
+inline static bool
+table_lookup(Locked_Map& self, uint64_t key, size_t& value)
+{
+	mn::mutex_read_lock(self.mtx);
+	auto it = mn::map_lookup(self.map, key);
+	if (it)
+		value = it->value;
+	mn::mutex_read_unlock(self.mtx);
+	return it != nullptr;
+}
+
+inline static void
+table_insert(Locked_Map& self, uint64_t key, size_t value)
+{
+	mn::mutex_write_lock(self.mtx);
+	mn::map_insert(self.map, key, value);
+	mn::mutex_write_unlock(self.mtx);
+}
+
+inline static bool
+table_lookup(mn::Concurrent_Map<uint64_t, size_t>& self, uint64_t key, size_t& value)
+{
+	return mn::concurrent_map_lookup(self, key, value);
+}
+
+inline static void
+table_insert(mn::Concurrent_Map<uint64_t, size_t>& self, uint64_t key, size_t value)
+{
+	mn::concurrent_map_insert(self, key, value);
+}
+
+template<typename TTable>
+struct Parallel_Run
+{
+	TTable* table;
+	const mn::Buf<uint64_t>* keys;
+	// out of 100 operations how many are inserts
+	size_t insert_percent;
+	uint64_t seed;
+};
+
+template<typename TTable>
+inline static void
+parallel_run(TTable& table, const mn::Buf<uint64_t>& keys, size_t insert_percent)
+{
+	Parallel_Run<TTable> runs[THREADS_COUNT];
+	mn::Thread threads[THREADS_COUNT];
+	for (size_t i = 0; i < THREADS_COUNT; ++i)
+	{
+		runs[i] = Parallel_Run<TTable>{&table, &keys, insert_percent, 0x9E3779B97F4A7C15ULL + i};
+		threads[i] = mn::thread_new([](void* arg) {
+			auto self = (Parallel_Run<TTable>*)arg;
+			size_t found = 0;
+			for (size_t j = 0; j < THREAD_OPS_COUNT; ++j)
+			{
+				auto r = xorshift(self->seed);
+				auto key = (*self->keys)[r % self->keys->count];
+				if ((r >> 32) % 100 < self->insert_percent)
+				{
+					table_insert(*self->table, key, j);
+				}
+				else
+				{
+					size_t value = 0;
+					found += table_lookup(*self->table, key, value);
+				}
+			}
+			ankerl::nanobench::doNotOptimizeAway(found);
+		}, &runs[i], "bench");
+	}
+	for (auto thread: threads)
+	{
+		mn::thread_join(thread);
+		mn::thread_free(thread);
+	}
+}
+
+inline static void
+bench_concurrent_map(const char* title, const mn::Buf<uint64_t>& keys, size_t insert_percent)
+{
+	auto bench = ankerl::nanobench::Bench().title(title).unit("op").batch(THREADS_COUNT * THREAD_OPS_COUNT).relative(true).minEpochIterations(5);
+
+	Locked_Map locked{mn::mutex_rw_new("Locked_Map"), mn::map_new<uint64_t, size_t>()};
+	mn_defer
+	{
+		mn::mutex_rw_free(locked.mtx);
+		mn::map_free(locked.map);
+	};
+	// half the keys exist at the start
+	for (size_t i = 0; i < keys.count; i += 2)
+		mn::map_insert(locked.map, keys[i], i);
+	bench.run("Mutex_RW + Map", [&] { parallel_run(locked, keys, insert_percent); });
+
+	auto concurrent = mn::concurrent_map_new<uint64_t, size_t>();
+	mn_defer{mn::concurrent_map_free(concurrent);};
+	for (size_t i = 0; i < keys.count; i += 2)
+		mn::concurrent_map_insert(concurrent, keys[i], i);
+	bench.run("Concurrent_Map", [&] { parallel_run(concurrent, keys, insert_percent); });
+}
+
+int
+main()
+{
+	uint64_t x = 0x9E3779B97F4A7C15ULL;
+
+	auto int_keys = mn::buf_new<uint64_t>();
+	auto int_missing_keys = mn::buf_new<uint64_t>();
+	mn_defer
+	{
+		mn::buf_free(int_keys);
+		mn::buf_free(int_missing_keys);
+	};
+	// odd keys are inserted and even keys are missing
+	for (size_t i = 0; i < KEYS_COUNT; ++i)
+	{
+		mn::buf_push(int_keys, xorshift(x) | 1);
+		mn::buf_push(int_missing_keys, xorshift(x) & ~1ULL);
+	}
+	bench_map("Map<uint64_t, size_t>", int_keys, int_missing_keys);
+	bench_concurrent_map("read heavy (4 threads)", int_keys, 10);
+	bench_concurrent_map("write heavy (4 threads)", int_keys, 50);
+
+	auto str_keys = mn::buf_new<mn::Str>();
+	auto str_missing_keys = mn::buf_new<mn::Str>();
+	mn_defer
+	{
+		destruct(str_keys);
+		destruct(str_missing_keys);
+	};
+	for (size_t i = 0; i < KEYS_COUNT; ++i)
+	{
+		mn::buf_push(str_keys, mn::strf("key_{}", xorshift(x) | 1));
+		mn::buf_push(str_missing_keys, mn::strf("key_{}", xorshift(x) & ~1ULL));
+	}
+	bench_map("Map<Str, size_t>", str_keys, str_missing_keys);
+
+	return 0;
+}
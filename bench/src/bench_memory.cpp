@@ -0,0 +1,315 @@
+#include <mn/Memory.h>
+#include <mn/memory/Leak.h>
+#include <mn/memory/Fast_Leak.h>
+#include <mn/Buf.h>
+#include <mn/Map.h>
+#include <mn/Pool.h>
+#include <mn/Thread.h>
+#include <mn/Fabric.h>
+#include <mn/Fmt.h>
+#include <mn/Defer.h>
+
+#include <nanobench.h>
+
+#if OS_LINUX
+#include <unistd.h>
+#include <stdio.h>
+#elif OS_MACOS
+#include <mach/mach.h>
+#elif OS_WINDOWS
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#include <Psapi.h>
+#endif
+
+// memory allocators benchmark, it measures the allocators under some realistic allocation patterns
+// - small object churn: a window of live small objects with random sizes where the oldest one is freed each time
+// - buf growth: pushing into a buf which keeps reallocating its memory
+// - map rehash: inserting into a map which keeps rehashing
+// - parallel churn: small object churn on multiple threads sharing the same allocator
+// - producer/consumer: one thread allocates and another thread frees
+// - buddy alloc/free: a burst of growing allocations which are freed afterwards, it compares the buddy allocator with
+//   the concurrent buddy allocator on a single thread to show the cost of its per order locks
+// only thread safe allocators are used in the multi-threaded patterns, and after each run we report the change in
+// the process resident set size (RSS) which the benchmark caused
+
+constexpr size_t CHURN_WINDOW = 256;
+constexpr size_t CHURN_OPS = 4096;
+constexpr size_t CHURN_MIN_SIZE = 16;
+constexpr size_t CHURN_MAX_SIZE = 256;
+constexpr size_t BUF_GROWTH_COUNT = 10000;
+constexpr size_t MAP_REHASH_COUNT = 10000;
+constexpr size_t THREADS_COUNT = 4;
+constexpr size_t PRODUCER_BATCH_SIZE = 256;
+constexpr size_t PRODUCER_BATCHES_COUNT = 64;
+constexpr size_t BUDDY_BURST_COUNT = 64;
+
+// resident set size of the process in bytes
+inline static size_t
+rss()
+{
+	#if OS_LINUX
+		auto f = ::fopen("/proc/self/statm", "rb");
+		if (f == nullptr)
+			return 0;
+		mn_defer{::fclose(f);};
+		size_t total = 0, resident = 0;
+		if (::fscanf(f, "%zu %zu", &total, &resident) != 2)
+			return 0;
+		return resident * size_t(::sysconf(_SC_PAGESIZE));
+	#elif OS_MACOS
+		mach_task_basic_info info{};
+		mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+		if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS)
+			return 0;
+		return info.resident_size;
+	#elif OS_WINDOWS
+		PROCESS_MEMORY_COUNTERS counters{};
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) == FALSE)
+			return 0;
+		return counters.WorkingSetSize;
+	#else
+		return 0;
+	#endif
+}
+
+inline static void
+rss_report(const char* name, size_t rss_before)
+{
+	auto rss_after = rss();
+	auto delta = rss_after > rss_before ? rss_after - rss_before : 0;
+	mn::print("  {}: rss {} KB (+{} KB)\n", name, rss_after / 1024, delta / 1024);
+}
+
+// the same random sizes sequence is used for all the allocators
+struct Sizes
+{
+	size_t values[CHURN_OPS];
+};
+
+inline static Sizes
+sizes_generate()
+{
+	Sizes self{};
+	uint64_t x = 0x9E3779B97F4A7C15ULL;
+	for (auto& size: self.values)
+	{
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		size = CHURN_MIN_SIZE + x % (CHURN_MAX_SIZE - CHURN_MIN_SIZE + 1);
+	}
+	return self;
+}
+
+static const Sizes SIZES = sizes_generate();
+
+struct Bench_Allocator
+{
+	const char* name;
+	mn::Allocator allocator;
+	// called after each run to reclaim the memory of allocators which don't free individual blocks (arena)
+	void (*reset)(mn::Allocator allocator);
+	bool thread_safe;
+};
+
+inline static void
+_arena_reset(mn::Allocator allocator)
+{
+	mn::allocator_arena_clear_all((mn::memory::Arena*)allocator);
+}
+
+inline static void
+churn(mn::Allocator allocator)
+{
+	mn::Block window[CHURN_WINDOW] = {};
+	for (size_t i = 0; i < CHURN_OPS; ++i)
+	{
+		auto& slot = window[i % CHURN_WINDOW];
+		if (slot.ptr)
+			mn::free_from(allocator, slot);
+		slot = mn::alloc_from(allocator, SIZES.values[i], alignof(size_t));
+		ankerl::nanobench::doNotOptimizeAway(slot.ptr);
+	}
+	for (auto& slot: window)
+		mn::free_from(allocator, slot);
+}
+
+inline static void
+buf_growth(mn::Allocator allocator)
+{
+	auto nums = mn::buf_with_allocator<size_t>(allocator);
+	for (size_t i = 0; i < BUF_GROWTH_COUNT; ++i)
+		mn::buf_push(nums, i);
+	ankerl::nanobench::doNotOptimizeAway(nums.ptr);
+	mn::buf_free(nums);
+}
+
+inline static void
+map_rehash(mn::Allocator allocator)
+{
+	auto map = mn::map_with_allocator<size_t, size_t>(allocator);
+	for (size_t i = 0; i < MAP_REHASH_COUNT; ++i)
+		mn::map_insert(map, i, i);
+	ankerl::nanobench::doNotOptimizeAway(map.count);
+	mn::map_free(map);
+}
+
+inline static void
+parallel_churn(mn::Allocator allocator)
+{
+	mn::Thread threads[THREADS_COUNT];
+	for (auto& thread: threads)
+		thread = mn::thread_new([](void* arg) { churn((mn::Allocator)arg); }, allocator, "churn");
+	for (auto thread: threads)
+	{
+		mn::thread_join(thread);
+		mn::thread_free(thread);
+	}
+}
+
+struct Producer_Batch
+{
+	mn::Block blocks[PRODUCER_BATCH_SIZE];
+};
+
+struct Producer_Consumer
+{
+	mn::Allocator allocator;
+	mn::Chan<Producer_Batch*> chan;
+};
+
+inline static void
+producer_consumer(mn::Allocator allocator)
+{
+	Producer_Consumer self{allocator, mn::chan_new<Producer_Batch*>(16)};
+
+	auto consumer = mn::thread_new([](void* arg) {
+		auto self = (Producer_Consumer*)arg;
+		for (auto batch: self->chan)
+		{
+			for (auto& block: batch->blocks)
+				mn::free_from(self->allocator, block);
+			mn::free_destruct_from(mn::memory::clib(), batch);
+		}
+	}, &self, "consumer");
+
+	for (size_t i = 0; i < PRODUCER_BATCHES_COUNT; ++i)
+	{
+		auto batch = mn::alloc_construct_from<Producer_Batch>(mn::memory::clib());
+		for (size_t j = 0; j < PRODUCER_BATCH_SIZE; ++j)
+			batch->blocks[j] = mn::alloc_from(allocator, SIZES.values[j], alignof(size_t));
+		mn::chan_send(self.chan, batch);
+	}
+	mn::chan_close(self.chan);
+
+	mn::thread_join(consumer);
+	mn::thread_free(consumer);
+	mn::chan_free(self.chan);
+}
+
+inline static void
+buddy_burst(mn::Allocator allocator)
+{
+	mn::Block blocks[BUDDY_BURST_COUNT];
+	for (size_t i = 0; i < BUDDY_BURST_COUNT; ++i)
+		blocks[i] = mn::alloc_from(allocator, (i + 1) * 8, alignof(char));
+	for (size_t i = 0; i < BUDDY_BURST_COUNT; ++i)
+		mn::free_from(allocator, blocks[i]);
+}
+
+template<typename TFunc>
+inline static void
+bench_pattern(const char* title, size_t ops, mn::Buf<Bench_Allocator>& allocators, bool multi_threaded, TFunc&& func)
+{
+	auto bench = ankerl::nanobench::Bench().title(title).unit("alloc").batch(ops).relative(true).minEpochIterations(10);
+	for (const auto& a: allocators)
+	{
+		if (multi_threaded && a.thread_safe == false)
+			continue;
+
+		auto rss_before = rss();
+		bench.run(a.name, [&] {
+			func(a.allocator);
+			if (a.reset)
+				a.reset(a.allocator);
+		});
+		rss_report(a.name, rss_before);
+	}
+}
+
+int
+main()
+{
+	auto arena = mn::allocator_arena_new(64ULL * 1024ULL);
+	auto stack = mn::allocator_stack_new(16ULL * 1024ULL * 1024ULL);
+	auto buddy = mn::allocator_buddy_new(64ULL * 1024ULL * 1024ULL);
+	auto concurrent_buddy = mn::allocator_concurrent_buddy_new(64ULL * 1024ULL * 1024ULL);
+	mn_defer
+	{
+		mn::allocator_free(concurrent_buddy);
+		mn::allocator_free(buddy);
+		mn::allocator_free(stack);
+		mn::allocator_free(arena);
+	};
+
+	// leak detectors report to stderr on exit, we free everything so there should be nothing to report
+	auto allocators = mn::buf_with_allocator<Bench_Allocator>(mn::memory::clib());
+	mn_defer{mn::buf_free(allocators);};
+	mn::buf_push(allocators, Bench_Allocator{"CLib", mn::memory::clib(), nullptr, true});
+	mn::buf_push(allocators, Bench_Allocator{"Arena", arena, _arena_reset, false});
+	mn::buf_push(allocators, Bench_Allocator{"Stack", stack, nullptr, false});
+	mn::buf_push(allocators, Bench_Allocator{"Buddy", buddy, nullptr, false});
+	mn::buf_push(allocators, Bench_Allocator{"Concurrent_Buddy", concurrent_buddy, nullptr, true});
+	mn::buf_push(allocators, Bench_Allocator{"Leak", mn::memory::leak(), nullptr, true});
+	mn::buf_push(allocators, Bench_Allocator{"Fast_Leak", mn::memory::fast_leak(), nullptr, true});
+
+	mn::print("small object churn\n");
+	bench_pattern("small object churn", CHURN_OPS, allocators, false, churn);
+
+	// pool is not an allocator interface, it's measured separately with fixed size objects
+	{
+		auto pool = mn::pool_new(CHURN_MAX_SIZE, 1024, mn::memory::clib());
+		mn_defer{mn::pool_free(pool);};
+
+		auto rss_before = rss();
+		ankerl::nanobench::Bench().title("small object churn").unit("alloc").batch(CHURN_OPS).minEpochIterations(10).run("Pool", [&]{
+			void* window[CHURN_WINDOW] = {};
+			for (size_t i = 0; i < CHURN_OPS; ++i)
+			{
+				auto& slot = window[i % CHURN_WINDOW];
+				if (slot)
+					mn::pool_put(pool, slot);
+				slot = mn::pool_get(pool);
+				ankerl::nanobench::doNotOptimizeAway(slot);
+			}
+			for (auto slot: window)
+				mn::pool_put(pool, slot);
+		});
+		rss_report("Pool", rss_before);
+	}
+
+	mn::print("\nbuf growth\n");
+	bench_pattern("buf growth", BUF_GROWTH_COUNT, allocators, false, buf_growth);
+
+	mn::print("\nmap rehash\n");
+	bench_pattern("map rehash", MAP_REHASH_COUNT, allocators, false, map_rehash);
+
+	mn::print("\nparallel churn ({} threads)\n", THREADS_COUNT);
+	bench_pattern("parallel churn", CHURN_OPS * THREADS_COUNT, allocators, true, parallel_churn);
+
+	mn::print("\nproducer/consumer cross thread frees\n");
+	bench_pattern("producer/consumer", PRODUCER_BATCH_SIZE * PRODUCER_BATCHES_COUNT, allocators, true, producer_consumer);
+
+	mn::print("\nbuddy alloc/free\n");
+	{
+		auto buddies = mn::buf_with_allocator<Bench_Allocator>(mn::memory::clib());
+		mn_defer{mn::buf_free(buddies);};
+		mn::buf_push(buddies, Bench_Allocator{"Buddy", buddy, nullptr, false});
+		mn::buf_push(buddies, Bench_Allocator{"Concurrent_Buddy", concurrent_buddy, nullptr, true});
+		bench_pattern("buddy alloc/free", BUDDY_BURST_COUNT, buddies, false, buddy_burst);
+	}
+
+	return 0;
+}
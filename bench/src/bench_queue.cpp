@@ -0,0 +1,91 @@
+#include <mn/Spsc_Ring.h>
+#include <mn/Fabric.h>
+#include <mn/Thread.h>
+#include <mn/Defer.h>
+
+#include <nanobench.h>
+
+// single producer single consumer queue benchmark, a producer thread sends 1M integers to the consumer (the calling
+// thread) using
+// - Chan: the mutex protected channel
+// - Spsc_Ring: the lock free ring using the blocking push and pop of a single value
+// - Spsc_Ring batch: the lock free ring using the blocking push and pop of 64 values at a time
+
+constexpr size_t ELEMENTS_COUNT = 1'000'000;
+constexpr size_t QUEUE_CAPACITY = 1024;
+constexpr size_t BATCH_SIZE = 64;
+
+int
+main()
+{
+	auto bench = ankerl::nanobench::Bench().title("1M spsc elements").unit("element").batch(ELEMENTS_COUNT).relative(true).epochs(3).epochIterations(1);
+
+	bench.run("Chan", [&] {
+		auto chan = mn::chan_new<size_t>(QUEUE_CAPACITY);
+		auto producer = mn::thread_new([](void* arg) {
+			auto chan = (mn::Chan<size_t>)arg;
+			for (size_t i = 0; i < ELEMENTS_COUNT; ++i)
+				mn::chan_send(chan, i);
+			mn::chan_close(chan);
+			mn::chan_free(chan);
+		}, mn::chan_new(chan), "producer");
+
+		size_t sum = 0;
+		for (auto value: chan)
+			sum += value;
+		ankerl::nanobench::doNotOptimizeAway(sum);
+
+		mn::thread_join(producer);
+		mn::thread_free(producer);
+		mn::chan_free(chan);
+	});
+
+	bench.run("Spsc_Ring", [&] {
+		auto ring = mn::spsc_ring_new<size_t>(QUEUE_CAPACITY);
+		auto producer = mn::thread_new([](void* arg) {
+			auto ring = (mn::Spsc_Ring<size_t>)arg;
+			for (size_t i = 0; i < ELEMENTS_COUNT; ++i)
+				mn::spsc_ring_push(ring, i);
+			mn::spsc_ring_close(ring);
+		}, ring, "producer");
+
+		size_t sum = 0;
+		size_t value = 0;
+		while (mn::spsc_ring_pop(ring, value))
+			sum += value;
+		ankerl::nanobench::doNotOptimizeAway(sum);
+
+		mn::thread_join(producer);
+		mn::thread_free(producer);
+		mn::spsc_ring_free(ring);
+	});
+
+	bench.run("Spsc_Ring batch", [&] {
+		auto ring = mn::spsc_ring_new<size_t>(QUEUE_CAPACITY);
+		auto producer = mn::thread_new([](void* arg) {
+			auto ring = (mn::Spsc_Ring<size_t>)arg;
+			size_t batch[BATCH_SIZE];
+			for (size_t i = 0; i < ELEMENTS_COUNT; i += BATCH_SIZE)
+			{
+				size_t count = ELEMENTS_COUNT - i < BATCH_SIZE ? ELEMENTS_COUNT - i : BATCH_SIZE;
+				for (size_t j = 0; j < count; ++j)
+					batch[j] = i + j;
+				mn::spsc_ring_push_n(ring, batch, count);
+			}
+			mn::spsc_ring_close(ring);
+		}, ring, "producer");
+
+		size_t sum = 0;
+		size_t batch[BATCH_SIZE];
+		while (size_t count = mn::spsc_ring_pop_n(ring, batch, BATCH_SIZE))
+			for (size_t i = 0; i < count; ++i)
+				sum += batch[i];
+		ankerl::nanobench::doNotOptimizeAway(sum);
+
+		mn::thread_join(producer);
+		mn::thread_free(producer);
+		mn::spsc_ring_free(ring);
+	});
+
+	return 0;
+}
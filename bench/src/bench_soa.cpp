@@ -0,0 +1,80 @@
+#include <mn/Soa_Buf.h>
+#include <mn/Buf.h>
+#include <mn/Defer.h>
+
+#include <nanobench.h>
+
+// struct of arrays benchmark, it compares a Buf of records with a Soa_Buf of the same fields using
+// - sum one field: sums the mass of 1M particles
+// - integrate: updates the positions from the velocities which touches 6 of the 8 fields
+
+constexpr size_t ELEMENTS_COUNT = 1'000'000;
+
+struct Particle
+{
+	float x, y, z;
+	float vx, vy, vz;
+	float mass;
+	uint32_t flags;
+};
+
+int
+main()
+{
+	auto aos = mn::buf_with_count<Particle>(ELEMENTS_COUNT);
+	mn_defer{mn::buf_free(aos);};
+	auto soa = mn::soa_buf_new<float, float, float, float, float, float, float, uint32_t>();
+	mn_defer{mn::soa_buf_free(soa);};
+	for (size_t i = 0; i < ELEMENTS_COUNT; ++i)
+	{
+		auto f = float(i);
+		aos[i] = Particle{f, f, f, 1.0f, 2.0f, 3.0f, f * 0.5f, uint32_t(i)};
+		mn::soa_buf_push(soa, f, f, f, 1.0f, 2.0f, 3.0f, f * 0.5f, uint32_t(i));
+	}
+
+	auto sum_bench = ankerl::nanobench::Bench().title("1M sum one field").unit("element").batch(ELEMENTS_COUNT).relative(true).minEpochIterations(20);
+	auto integrate_bench = ankerl::nanobench::Bench().title("1M integrate").unit("element").batch(ELEMENTS_COUNT).relative(true).minEpochIterations(20);
+
+	sum_bench.run("Buf<Particle>", [&] {
+		float sum = 0;
+		for (const auto& p: aos)
+			sum += p.mass;
+		ankerl::nanobench::doNotOptimizeAway(sum);
+	});
+
+	sum_bench.run("Soa_Buf", [&] {
+		auto mass = mn::soa_buf_field<6>(soa);
+		float sum = 0;
+		for (size_t i = 0; i < soa.count; ++i)
+			sum += mass[i];
+		ankerl::nanobench::doNotOptimizeAway(sum);
+	});
+
+	integrate_bench.run("Buf<Particle>", [&] {
+		for (auto& p: aos)
+		{
+			p.x += p.vx * 0.01f;
+			p.y += p.vy * 0.01f;
+			p.z += p.vz * 0.01f;
+		}
+		ankerl::nanobench::doNotOptimizeAway(aos.ptr);
+	});
+
+	integrate_bench.run("Soa_Buf", [&] {
+		auto x = mn::soa_buf_field<0>(soa);
+		auto y = mn::soa_buf_field<1>(soa);
+		auto z = mn::soa_buf_field<2>(soa);
+		auto vx = mn::soa_buf_field<3>(soa);
+		auto vy = mn::soa_buf_field<4>(soa);
+		auto vz = mn::soa_buf_field<5>(soa);
+		for (size_t i = 0; i < soa.count; ++i)
+		{
+			x[i] += vx[i] * 0.01f;
+			y[i] += vy[i] * 0.01f;
+			z[i] += vz[i] * 0.01f;
+		}
+		ankerl::nanobench::doNotOptimizeAway(x);
+	});
+
+	return 0;
+}
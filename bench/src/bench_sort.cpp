@@ -0,0 +1,85 @@
+#include <mn/Sort.h>
+#include <mn/Buf.h>
+#include <mn/Fabric.h>
+#include <mn/Fmt.h>
+#include <mn/Defer.h>
+
+#include <nanobench.h>
+
+#include <algorithm>
+
+// sorting benchmark, it sorts a buffer of 10M random elements using
+// - std::sort: the baseline which we used before buf_sort
+// - buf_sort: pattern defeating quick sort on the calling thread
+// - buf_radix_sort: LSD radix sort on the calling thread
+// - buf_sort_parallel: parallel sort on the fabric workers
+// each run copies the unsorted input into the buffer first which is a small fraction of the sort time
+
+constexpr size_t ELEMENTS_COUNT = 10'000'000;
+
+inline static uint64_t
+xorshift(uint64_t& x)
+{
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	return x;
+}
+
+template<typename T>
+inline static void
+bench_sort(const char* title, const mn::Buf<T>& input, mn::Fabric fabric)
+{
+	auto bench = ankerl::nanobench::Bench().title(title).unit("element").batch(input.count).relative(true).epochs(3).epochIterations(1);
+
+	auto nums = mn::buf_with_count<T>(input.count);
+	mn_defer{mn::buf_free(nums);};
+
+	bench.run("std::sort", [&] {
+		::memcpy(nums.ptr, input.ptr, input.count * sizeof(T));
+		std::sort(begin(nums), end(nums));
+		ankerl::nanobench::doNotOptimizeAway(nums.ptr[0]);
+	});
+
+	bench.run("buf_sort", [&] {
+		::memcpy(nums.ptr, input.ptr, input.count * sizeof(T));
+		mn::buf_sort(nums);
+		ankerl::nanobench::doNotOptimizeAway(nums.ptr[0]);
+	});
+
+	bench.run("buf_radix_sort", [&] {
+		::memcpy(nums.ptr, input.ptr, input.count * sizeof(T));
+		mn::buf_radix_sort(nums);
+		ankerl::nanobench::doNotOptimizeAway(nums.ptr[0]);
+	});
+
+	bench.run("buf_sort_parallel", [&] {
+		::memcpy(nums.ptr, input.ptr, input.count * sizeof(T));
+		mn::buf_sort_parallel(fabric, nums);
+		ankerl::nanobench::doNotOptimizeAway(nums.ptr[0]);
+	});
+}
+
+int
+main()
+{
+	auto fabric = mn::fabric_new({});
+	mn_defer{mn::fabric_free(fabric);};
+	mn::print("fabric workers: {}\n", mn::fabric_workers_count(fabric));
+
+	uint64_t x = 0x9E3779B97F4A7C15ULL;
+
+	auto ints = mn::buf_with_count<uint32_t>(ELEMENTS_COUNT);
+	mn_defer{mn::buf_free(ints);};
+	for (auto& v: ints)
+		v = uint32_t(xorshift(x));
+	bench_sort("10M uint32_t", ints, fabric);
+
+	auto doubles = mn::buf_with_count<double>(ELEMENTS_COUNT);
+	mn_defer{mn::buf_free(doubles);};
+	for (auto& v: doubles)
+		v = double(int64_t(xorshift(x))) / 1024.0;
+	bench_sort("10M double", doubles, fabric);
+
+	return 0;
+}
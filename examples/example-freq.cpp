@@ -1,5 +1,6 @@
 #include <mn/IO.h>
 #include <mn/Str.h>
+#include <mn/Small_Str.h>
 #include <mn/Map.h>
 #include <mn/Defer.h>
 
@@ -10,7 +11,8 @@ main()
 	auto line	 = mn::str_new();
 	mn_defer{mn::str_free(line);};
 
-	auto freq = mn::map_new<mn::Str, size_t>();
+	// words are short so we use small strings as keys which store them inline without allocating
+	auto freq = mn::map_new<mn::Small_Str, size_t>();
 	mn_defer{destruct(freq);};
 
 	// while we can read line
@@ -22,10 +24,11 @@ main()
 		{
 			// trim the word
 			mn::str_trim(word);
-			if (auto it = mn::map_lookup(freq, word))
+			auto key = mn::small_str_from_str(word, mn::memory::tmp());
+			if (auto it = mn::map_lookup(freq, key))
 				it->value++;
 			else
-				mn::map_insert(freq, clone(word), size_t(1));
+				mn::map_insert(freq, clone(key), size_t(1));
 		}
 		// free all the tmp memory
 		mn::memory::tmp()->clear_all();
@@ -0,0 +1,590 @@
+#pragma once
+
+#include "mn/Buf.h"
+#include "mn/Bits.h"
+#include "mn/Assert.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define MN_BITS_SSE2 1
+	#include <emmintrin.h>
+#else
+	#define MN_BITS_SSE2 0
+#endif
+
+namespace mn
+{
+	// the bits are stored most significant bit first in each 64 bit word (bit i is the bit 63 - i % 64 of word i / 64)
+	// which is the same layout of the buddy allocator bitmaps, this way the first set bit of a word is its count of
+	// leading zeros, and the unused bits of the last word are always kept cleared
+
+	// returns the count of words which holds the given count of bits
+	inline static size_t
+	_bits_words_count(size_t bits_count)
+	{
+		return (bits_count + 63) >> 6;
+	}
+
+	// returns the mask of the given bit inside its word
+	inline static uint64_t
+	_bits_mask(size_t index)
+	{
+		return (uint64_t(1) << 63) >> (index & 63);
+	}
+
+	// returns the count of set bits in the given word
+	inline static size_t
+	_bits_popcount(uint64_t v)
+	{
+		#if MN_COMPILER_CLANG || MN_COMPILER_GNU
+			return size_t(__builtin_popcountll(v));
+		#else
+			v = v - ((v >> 1) & 0x5555555555555555ULL);
+			v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+			v = (v + (v >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+			return size_t((v * 0x0101010101010101ULL) >> 56);
+		#endif
+	}
+
+	// returns the mask of the used bits of the last word, or all ones if the last word is fully used
+	inline static uint64_t
+	_bits_tail_mask(size_t bits_count)
+	{
+		auto rem = bits_count & 63;
+		return rem ? ~uint64_t(0) << (64 - rem) : ~uint64_t(0);
+	}
+
+	inline static size_t
+	_bits_count_ones(const uint64_t* words, size_t words_count)
+	{
+		// we use 4 accumulators so the popcounts of consecutive words don't depend on each other
+		size_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+		size_t i = 0;
+		for (; i + 4 <= words_count; i += 4)
+		{
+			c0 += _bits_popcount(words[i + 0]);
+			c1 += _bits_popcount(words[i + 1]);
+			c2 += _bits_popcount(words[i + 2]);
+			c3 += _bits_popcount(words[i + 3]);
+		}
+		for (; i < words_count; ++i)
+			c0 += _bits_popcount(words[i]);
+		return c0 + c1 + c2 + c3;
+	}
+
+	inline static size_t
+	_bits_find_first(const uint64_t* words, size_t bits_count, size_t start)
+	{
+		if (start >= bits_count)
+			return SIZE_MAX;
+
+		auto words_count = _bits_words_count(bits_count);
+		auto word_index = start >> 6;
+		// mask out the bits before the start in the first word
+		auto word = words[word_index] & (~uint64_t(0) >> (start & 63));
+		while (word == 0)
+		{
+			if (++word_index == words_count)
+				return SIZE_MAX;
+			word = words[word_index];
+		}
+		return (word_index << 6) + size_t(leading_zeros(word));
+	}
+
+	inline static size_t
+	_bits_find_first_zero(const uint64_t* words, size_t bits_count, size_t start)
+	{
+		if (start >= bits_count)
+			return SIZE_MAX;
+
+		auto words_count = _bits_words_count(bits_count);
+		auto word_index = start >> 6;
+		auto word = ~words[word_index] & (~uint64_t(0) >> (start & 63));
+		while (word == 0)
+		{
+			if (++word_index == words_count)
+				return SIZE_MAX;
+			word = ~words[word_index];
+		}
+		auto res = (word_index << 6) + size_t(leading_zeros(word));
+		// the cleared unused bits of the last word are not part of the bits
+		return res < bits_count ? res : SIZE_MAX;
+	}
+
+	inline static size_t
+	_bits_rank(const uint64_t* words, size_t index)
+	{
+		auto res = _bits_count_ones(words, index >> 6);
+		if (auto rem = index & 63)
+			res += _bits_popcount(words[index >> 6] >> (64 - rem));
+		return res;
+	}
+
+	inline static size_t
+	_bits_select(const uint64_t* words, size_t words_count, size_t rank)
+	{
+		for (size_t i = 0; i < words_count; ++i)
+		{
+			auto word = words[i];
+			auto count = _bits_popcount(word);
+			if (rank >= count)
+			{
+				rank -= count;
+				continue;
+			}
+
+			// skip whole bytes first then clear the leading set bits of the last byte
+			size_t offset = 0;
+			while (true)
+			{
+				auto byte_count = _bits_popcount(word >> 56);
+				if (rank < byte_count)
+					break;
+				rank -= byte_count;
+				word <<= 8;
+				offset += 8;
+			}
+			for (; rank > 0; --rank)
+				word &= ~(uint64_t(1) << (63 - leading_zeros(word)));
+			return (i << 6) + offset + size_t(leading_zeros(word));
+		}
+		return SIZE_MAX;
+	}
+
+	// bitwise operations over whole word arrays, they process 128 bits at a time when SSE2 is available
+	#if MN_BITS_SSE2
+		#define MN_BITS_OP(NAME, SSE_EXPR, SCALAR_EXPR)\
+		inline static void\
+		NAME(uint64_t* dst, const uint64_t* src, size_t words_count)\
+		{\
+			size_t i = 0;\
+			for (; i + 2 <= words_count; i += 2)\
+			{\
+				auto a = _mm_loadu_si128((const __m128i*)(dst + i));\
+				auto b = _mm_loadu_si128((const __m128i*)(src + i));\
+				_mm_storeu_si128((__m128i*)(dst + i), SSE_EXPR);\
+			}\
+			for (; i < words_count; ++i)\
+			{\
+				auto a = dst[i];\
+				auto b = src[i];\
+				dst[i] = SCALAR_EXPR;\
+			}\
+		}
+	#else
+		#define MN_BITS_OP(NAME, SSE_EXPR, SCALAR_EXPR)\
+		inline static void\
+		NAME(uint64_t* dst, const uint64_t* src, size_t words_count)\
+		{\
+			for (size_t i = 0; i < words_count; ++i)\
+			{\
+				auto a = dst[i];\
+				auto b = src[i];\
+				dst[i] = SCALAR_EXPR;\
+			}\
+		}
+	#endif
+
+	MN_BITS_OP(_bits_and, _mm_and_si128(a, b), a & b)
+	MN_BITS_OP(_bits_or, _mm_or_si128(a, b), a | b)
+	MN_BITS_OP(_bits_xor, _mm_xor_si128(a, b), a ^ b)
+	// note that _mm_andnot_si128 negates its first operand
+	MN_BITS_OP(_bits_andnot, _mm_andnot_si128(b, a), a & ~b)
+
+	#undef MN_BITS_OP
+
+	// a fixed size set of N bits which is stored inline, it should be zero initialized (e.g. `Bitset<128> visited{};`)
+	template<size_t N>
+	struct Bitset
+	{
+		static constexpr size_t WORDS_COUNT = (N + 63) / 64;
+		uint64_t words[WORDS_COUNT ? WORDS_COUNT : 1];
+	};
+
+	// returns the value of the given bit
+	template<size_t N>
+	inline static bool
+	bitset_get(const Bitset<N>& self, size_t index)
+	{
+		mn_assert(index < N);
+		return (self.words[index >> 6] & _bits_mask(index)) != 0;
+	}
+
+	// sets the given bit to the given value
+	template<size_t N>
+	inline static void
+	bitset_set(Bitset<N>& self, size_t index, bool value = true)
+	{
+		mn_assert(index < N);
+		auto mask = _bits_mask(index);
+		auto& word = self.words[index >> 6];
+		word = (word & ~mask) | ((uint64_t(0) - uint64_t(value)) & mask);
+	}
+
+	// clears the given bit
+	template<size_t N>
+	inline static void
+	bitset_unset(Bitset<N>& self, size_t index)
+	{
+		mn_assert(index < N);
+		self.words[index >> 6] &= ~_bits_mask(index);
+	}
+
+	// flips the given bit
+	template<size_t N>
+	inline static void
+	bitset_flip(Bitset<N>& self, size_t index)
+	{
+		mn_assert(index < N);
+		self.words[index >> 6] ^= _bits_mask(index);
+	}
+
+	// sets all the bits to the given value
+	template<size_t N>
+	inline static void
+	bitset_fill(Bitset<N>& self, bool value)
+	{
+		::memset(self.words, value ? 0xff : 0, sizeof(self.words));
+		if (value && N > 0)
+			self.words[Bitset<N>::WORDS_COUNT - 1] &= _bits_tail_mask(N);
+	}
+
+	// returns the count of set bits
+	template<size_t N>
+	inline static size_t
+	bitset_count_ones(const Bitset<N>& self)
+	{
+		return _bits_count_ones(self.words, Bitset<N>::WORDS_COUNT);
+	}
+
+	// returns whether any bit is set
+	template<size_t N>
+	inline static bool
+	bitset_any(const Bitset<N>& self)
+	{
+		uint64_t res = 0;
+		for (size_t i = 0; i < Bitset<N>::WORDS_COUNT; ++i)
+			res |= self.words[i];
+		return res != 0;
+	}
+
+	// returns the index of the first set bit starting from the given index, or SIZE_MAX if there's none
+	template<size_t N>
+	inline static size_t
+	bitset_find_first(const Bitset<N>& self, size_t start = 0)
+	{
+		return _bits_find_first(self.words, N, start);
+	}
+
+	// returns the index of the first cleared bit starting from the given index, or SIZE_MAX if there's none
+	template<size_t N>
+	inline static size_t
+	bitset_find_first_zero(const Bitset<N>& self, size_t start = 0)
+	{
+		return _bits_find_first_zero(self.words, N, start);
+	}
+
+	// returns the count of set bits before the given index
+	template<size_t N>
+	inline static size_t
+	bitset_rank(const Bitset<N>& self, size_t index)
+	{
+		mn_assert(index <= N);
+		return _bits_rank(self.words, index);
+	}
+
+	// returns the index of the set bit which has the given rank (count of set bits before it), or SIZE_MAX if there's
+	// none
+	template<size_t N>
+	inline static size_t
+	bitset_select(const Bitset<N>& self, size_t rank)
+	{
+		return _bits_select(self.words, Bitset<N>::WORDS_COUNT, rank);
+	}
+
+	// self = self & other
+	template<size_t N>
+	inline static void
+	bitset_and(Bitset<N>& self, const Bitset<N>& other)
+	{
+		_bits_and(self.words, other.words, Bitset<N>::WORDS_COUNT);
+	}
+
+	// self = self | other
+	template<size_t N>
+	inline static void
+	bitset_or(Bitset<N>& self, const Bitset<N>& other)
+	{
+		_bits_or(self.words, other.words, Bitset<N>::WORDS_COUNT);
+	}
+
+	// self = self ^ other
+	template<size_t N>
+	inline static void
+	bitset_xor(Bitset<N>& self, const Bitset<N>& other)
+	{
+		_bits_xor(self.words, other.words, Bitset<N>::WORDS_COUNT);
+	}
+
+	// self = self & ~other
+	template<size_t N>
+	inline static void
+	bitset_andnot(Bitset<N>& self, const Bitset<N>& other)
+	{
+		_bits_andnot(self.words, other.words, Bitset<N>::WORDS_COUNT);
+	}
+
+	template<size_t N>
+	inline static bool
+	operator==(const Bitset<N>& a, const Bitset<N>& b)
+	{
+		return ::memcmp(a.words, b.words, sizeof(a.words)) == 0;
+	}
+
+	template<size_t N>
+	inline static bool
+	operator!=(const Bitset<N>& a, const Bitset<N>& b)
+	{
+		return !(a == b);
+	}
+
+	// a dynamically sized array of bits which uses 1 bit per value instead of the 8 bits of Buf<bool>
+	struct Bit_Buf
+	{
+		Buf<uint64_t> words;
+		// count of bits
+		size_t count;
+	};
+
+	// creates a new bit buffer with the given allocator
+	inline static Bit_Buf
+	bit_buf_with_allocator(Allocator allocator)
+	{
+		Bit_Buf self{};
+		self.words = buf_with_allocator<uint64_t>(allocator);
+		return self;
+	}
+
+	// creates a new bit buffer
+	inline static Bit_Buf
+	bit_buf_new()
+	{
+		return bit_buf_with_allocator(allocator_top());
+	}
+
+	// creates a new bit buffer with the given count of cleared bits
+	inline static Bit_Buf
+	bit_buf_with_count(size_t count, Allocator allocator = allocator_top())
+	{
+		Bit_Buf self = bit_buf_with_allocator(allocator);
+		buf_resize_fill(self.words, _bits_words_count(count), uint64_t(0));
+		self.count = count;
+		return self;
+	}
+
+	// frees the given bit buffer
+	inline static void
+	bit_buf_free(Bit_Buf& self)
+	{
+		buf_free(self.words);
+		self.count = 0;
+	}
+
+	// destruct overload for bit buffer free
+	inline static void
+	destruct(Bit_Buf& self)
+	{
+		bit_buf_free(self);
+	}
+
+	// clones the given bit buffer
+	inline static Bit_Buf
+	bit_buf_clone(const Bit_Buf& other, Allocator allocator = allocator_top())
+	{
+		Bit_Buf self{};
+		self.words = buf_memcpy_clone(other.words, allocator);
+		self.count = other.count;
+		return self;
+	}
+
+	// clone overload for bit buffer
+	inline static Bit_Buf
+	clone(const Bit_Buf& other)
+	{
+		return bit_buf_clone(other);
+	}
+
+	// returns the value of the given bit
+	inline static bool
+	bit_buf_get(const Bit_Buf& self, size_t index)
+	{
+		mn_assert(index < self.count);
+		return (self.words.ptr[index >> 6] & _bits_mask(index)) != 0;
+	}
+
+	// sets the given bit to the given value
+	inline static void
+	bit_buf_set(Bit_Buf& self, size_t index, bool value = true)
+	{
+		mn_assert(index < self.count);
+		auto mask = _bits_mask(index);
+		auto& word = self.words.ptr[index >> 6];
+		word = (word & ~mask) | ((uint64_t(0) - uint64_t(value)) & mask);
+	}
+
+	// clears the given bit
+	inline static void
+	bit_buf_unset(Bit_Buf& self, size_t index)
+	{
+		mn_assert(index < self.count);
+		self.words.ptr[index >> 6] &= ~_bits_mask(index);
+	}
+
+	// flips the given bit
+	inline static void
+	bit_buf_flip(Bit_Buf& self, size_t index)
+	{
+		mn_assert(index < self.count);
+		self.words.ptr[index >> 6] ^= _bits_mask(index);
+	}
+
+	// resizes the bit buffer to the given count of bits, the new bits are cleared
+	inline static void
+	bit_buf_resize(Bit_Buf& self, size_t count)
+	{
+		if (count < self.count)
+		{
+			buf_resize(self.words, _bits_words_count(count));
+			if (count > 0)
+				self.words.ptr[self.words.count - 1] &= _bits_tail_mask(count);
+		}
+		else
+		{
+			buf_resize_fill(self.words, _bits_words_count(count), uint64_t(0));
+		}
+		self.count = count;
+	}
+
+	// pushes the given value to the end of the bit buffer
+	inline static void
+	bit_buf_push(Bit_Buf& self, bool value)
+	{
+		if ((self.count & 63) == 0)
+			buf_push(self.words, uint64_t(0));
+		self.words.ptr[self.count >> 6] |= (uint64_t(0) - uint64_t(value)) & _bits_mask(self.count);
+		++self.count;
+	}
+
+	// removes the last bit of the bit buffer and returns its value
+	inline static bool
+	bit_buf_pop(Bit_Buf& self)
+	{
+		mn_assert(self.count > 0);
+		auto res = bit_buf_get(self, self.count - 1);
+		bit_buf_resize(self, self.count - 1);
+		return res;
+	}
+
+	// removes all the bits of the bit buffer
+	inline static void
+	bit_buf_clear(Bit_Buf& self)
+	{
+		buf_clear(self.words);
+		self.count = 0;
+	}
+
+	// sets all the bits to the given value
+	inline static void
+	bit_buf_fill(Bit_Buf& self, bool value)
+	{
+		if (self.count == 0)
+			return;
+		buf_fill(self.words, value ? ~uint64_t(0) : uint64_t(0));
+		if (value)
+			self.words.ptr[self.words.count - 1] &= _bits_tail_mask(self.count);
+	}
+
+	// returns the count of set bits
+	inline static size_t
+	bit_buf_count_ones(const Bit_Buf& self)
+	{
+		return _bits_count_ones(self.words.ptr, self.words.count);
+	}
+
+	// returns the index of the first set bit starting from the given index, or SIZE_MAX if there's none
+	inline static size_t
+	bit_buf_find_first(const Bit_Buf& self, size_t start = 0)
+	{
+		return _bits_find_first(self.words.ptr, self.count, start);
+	}
+
+	// returns the index of the first cleared bit starting from the given index, or SIZE_MAX if there's none
+	inline static size_t
+	bit_buf_find_first_zero(const Bit_Buf& self, size_t start = 0)
+	{
+		return _bits_find_first_zero(self.words.ptr, self.count, start);
+	}
+
+	// returns the count of set bits before the given index, it scans the words so it's O(n), if you need many rank
+	// queries over the same bits you should keep a prefix count of each block of words
+	inline static size_t
+	bit_buf_rank(const Bit_Buf& self, size_t index)
+	{
+		mn_assert(index <= self.count);
+		return _bits_rank(self.words.ptr, index);
+	}
+
+	// returns the index of the set bit which has the given rank (count of set bits before it), or SIZE_MAX if there's
+	// none
+	inline static size_t
+	bit_buf_select(const Bit_Buf& self, size_t rank)
+	{
+		return _bits_select(self.words.ptr, self.words.count, rank);
+	}
+
+	// self = self & other, both bit buffers should have the same count of bits
+	inline static void
+	bit_buf_and(Bit_Buf& self, const Bit_Buf& other)
+	{
+		mn_assert(self.count == other.count);
+		_bits_and(self.words.ptr, other.words.ptr, self.words.count);
+	}
+
+	// self = self | other, both bit buffers should have the same count of bits
+	inline static void
+	bit_buf_or(Bit_Buf& self, const Bit_Buf& other)
+	{
+		mn_assert(self.count == other.count);
+		_bits_or(self.words.ptr, other.words.ptr, self.words.count);
+	}
+
+	// self = self ^ other, both bit buffers should have the same count of bits
+	inline static void
+	bit_buf_xor(Bit_Buf& self, const Bit_Buf& other)
+	{
+		mn_assert(self.count == other.count);
+		_bits_xor(self.words.ptr, other.words.ptr, self.words.count);
+	}
+
+	// self = self & ~other, both bit buffers should have the same count of bits
+	inline static void
+	bit_buf_andnot(Bit_Buf& self, const Bit_Buf& other)
+	{
+		mn_assert(self.count == other.count);
+		_bits_andnot(self.words.ptr, other.words.ptr, self.words.count);
+	}
+
+	inline static bool
+	operator==(const Bit_Buf& a, const Bit_Buf& b)
+	{
+		return a.count == b.count && (a.count == 0 || ::memcmp(a.words.ptr, b.words.ptr, a.words.count * sizeof(uint64_t)) == 0);
+	}
+
+	inline static bool
+	operator!=(const Bit_Buf& a, const Bit_Buf& b)
+	{
+		return !(a == b);
+	}
+}
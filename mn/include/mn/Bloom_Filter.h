@@ -0,0 +1,182 @@
+#pragma once
+
+#include "mn/Map.h"
+#include "mn/Memory.h"
+#include "mn/Assert.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace mn
+{
+	// count of bits which each key sets in its block, one bit in each 64 bit word of the block
+	constexpr size_t BLOOM_FILTER_BLOCK_WORDS = 8;
+
+	// a bloom filter block which is a single cache line
+	struct alignas(64) Bloom_Block
+	{
+		uint64_t words[BLOOM_FILTER_BLOCK_WORDS];
+	};
+
+	// a blocked bloom filter which is a probabilistic set, it can tell that a key is definitely not in the set or that
+	// it's probably in the set, each key maps to a single cache line sized block and sets one bit in each of its 8
+	// words, so a lookup touches exactly one cache line and the per word bit masks are computed independently from
+	// each other with a multiply and a shift which the compiler can vectorize, the keys are hashed with the stable hash
+	// functor by default so a persisted filter stays valid in processes which randomize the global hash seed
+	template<typename T, typename THash = Stable_Hash<T>>
+	struct Bloom_Filter
+	{
+		Allocator allocator;
+		// the allocated block which the bloom blocks are placed in after aligning them
+		Block memory;
+		Bloom_Block* blocks;
+		size_t blocks_count;
+	};
+
+	// odd multipliers which select the bit of each word in the block from the same 32 bit hash
+	constexpr uint32_t _BLOOM_FILTER_SALTS[BLOOM_FILTER_BLOCK_WORDS] = {
+		0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+		0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+	};
+
+	// mixes the given hash value into 64 well distributed bits, because the trivial hash functions return the value
+	// as is, the result should be stable across runs so the filters can be persisted
+	inline static uint64_t
+	_bloom_filter_mix(size_t hash)
+	{
+		return _wyhash_mix(uint64_t(hash) ^ 0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL);
+	}
+
+	// creates a bloom filter with the given count of blocks, all the bits are cleared
+	template<typename T, typename THash = Stable_Hash<T>>
+	inline static Bloom_Filter<T, THash>
+	_bloom_filter_with_blocks(Allocator allocator, size_t blocks_count)
+	{
+		mn_assert(blocks_count > 0 && blocks_count <= UINT32_MAX);
+
+		Bloom_Filter<T, THash> self{};
+		self.allocator = allocator;
+		self.blocks_count = blocks_count;
+		self.blocks = (Bloom_Block*)alloc_aligned_from(allocator, sizeof(Bloom_Block) * blocks_count, alignof(Bloom_Block), self.memory);
+		::memset(self.blocks, 0, sizeof(Bloom_Block) * blocks_count);
+		return self;
+	}
+
+	// creates a new bloom filter with the given allocator which is sized to hold the given count of keys with at most
+	// about the given false positive rate
+	template<typename T, typename THash = Stable_Hash<T>>
+	inline static Bloom_Filter<T, THash>
+	bloom_filter_with_allocator(Allocator allocator, size_t expected_count, double false_positive_rate = 0.01)
+	{
+		mn_assert(false_positive_rate > 0 && false_positive_rate < 1);
+
+		// the classic optimal bits count is -n * ln(p) / ln(2)^2, blocking the bits into cache lines and fixing the
+		// count of bits per key to 8 makes the keys distribution less uniform so we add a quarter more bits which keeps
+		// the measured rate under the requested one for rates between 10% and 0.1%
+		auto bits_per_key = -::log(false_positive_rate) / (0.6931471805599453 * 0.6931471805599453) * 1.25;
+		auto bits_count = double(expected_count ? expected_count : 1) * bits_per_key;
+		auto blocks_count = size_t(::ceil(bits_count / (sizeof(Bloom_Block) * 8)));
+		return _bloom_filter_with_blocks<T, THash>(allocator, blocks_count ? blocks_count : 1);
+	}
+
+	// creates a new bloom filter which is sized to hold the given count of keys with at most about the given false
+	// positive rate
+	template<typename T, typename THash = Stable_Hash<T>>
+	inline static Bloom_Filter<T, THash>
+	bloom_filter_new(size_t expected_count, double false_positive_rate = 0.01)
+	{
+		return bloom_filter_with_allocator<T, THash>(allocator_top(), expected_count, false_positive_rate);
+	}
+
+	// frees the given bloom filter
+	template<typename T, typename THash>
+	inline static void
+	bloom_filter_free(Bloom_Filter<T, THash>& self)
+	{
+		if (self.blocks == nullptr)
+			return;
+
+		free_from(self.allocator, self.memory);
+		self.memory = Block{};
+		self.blocks = nullptr;
+		self.blocks_count = 0;
+	}
+
+	// destruct overload for bloom filter free
+	template<typename T, typename THash>
+	inline static void
+	destruct(Bloom_Filter<T, THash>& self)
+	{
+		bloom_filter_free(self);
+	}
+
+	// clears all the keys from the given bloom filter
+	template<typename T, typename THash>
+	inline static void
+	bloom_filter_clear(Bloom_Filter<T, THash>& self)
+	{
+		::memset(self.blocks, 0, sizeof(Bloom_Block) * self.blocks_count);
+	}
+
+	// returns the size of the bloom filter bits in bytes
+	template<typename T, typename THash>
+	inline static size_t
+	bloom_filter_size(const Bloom_Filter<T, THash>& self)
+	{
+		return self.blocks_count * sizeof(Bloom_Block);
+	}
+
+	// inserts the given mixed hash into the bloom filter, the high 32 bits select the block and the low 32 bits select
+	// the bit of each word in it
+	template<typename T, typename THash>
+	inline static void
+	_bloom_filter_insert_hash(Bloom_Filter<T, THash>& self, uint64_t hash)
+	{
+		auto& block = self.blocks[((hash >> 32) * self.blocks_count) >> 32];
+		auto h = uint32_t(hash);
+		for (size_t i = 0; i < BLOOM_FILTER_BLOCK_WORDS; ++i)
+			block.words[i] |= uint64_t(1) << ((h * _BLOOM_FILTER_SALTS[i]) >> 26);
+	}
+
+	template<typename T, typename THash>
+	inline static bool
+	_bloom_filter_contains_hash(const Bloom_Filter<T, THash>& self, uint64_t hash)
+	{
+		const auto& block = self.blocks[((hash >> 32) * self.blocks_count) >> 32];
+		auto h = uint32_t(hash);
+		// we accumulate the missing bits instead of returning early so the loop has no branches
+		uint64_t missing = 0;
+		for (size_t i = 0; i < BLOOM_FILTER_BLOCK_WORDS; ++i)
+			missing |= ~block.words[i] & (uint64_t(1) << ((h * _BLOOM_FILTER_SALTS[i]) >> 26));
+		return missing == 0;
+	}
+
+	// inserts the given key into the bloom filter
+	template<typename T, typename THash>
+	inline static void
+	bloom_filter_insert(Bloom_Filter<T, THash>& self, const T& key)
+	{
+		_bloom_filter_insert_hash(self, _bloom_filter_mix(THash()(key)));
+	}
+
+	// returns false if the given key is definitely not in the bloom filter, and true if it's probably in it
+	template<typename T, typename THash>
+	inline static bool
+	bloom_filter_contains(const Bloom_Filter<T, THash>& self, const T& key)
+	{
+		return _bloom_filter_contains_hash(self, _bloom_filter_mix(THash()(key)));
+	}
+
+	// inserts all the keys of the other bloom filter into the given bloom filter, both filters should have the same size
+	template<typename T, typename THash>
+	inline static void
+	bloom_filter_union(Bloom_Filter<T, THash>& self, const Bloom_Filter<T, THash>& other)
+	{
+		mn_assert(self.blocks_count == other.blocks_count);
+
+		auto words = (uint64_t*)self.blocks;
+		auto other_words = (const uint64_t*)other.blocks;
+		for (size_t i = 0; i < self.blocks_count * BLOOM_FILTER_BLOCK_WORDS; ++i)
+			words[i] |= other_words[i];
+	}
+}
@@ -103,28 +103,6 @@ namespace mn
 		self.ptr = nullptr;
 	}
 
-	// a general destruct function overload which calls the destructor of the given value
-	template<typename T>
-	inline static void
-	destruct(T& value)
-	{
-		value.~T();
-	}
-
-	// default no-op destruct functions for the builtin types
-	inline static void destruct(char&) {}
-	inline static void destruct(uint8_t&) {}
-	inline static void destruct(uint16_t&) {}
-	inline static void destruct(uint32_t&) {}
-	inline static void destruct(uint64_t&) {}
-	inline static void destruct(int8_t&) {}
-	inline static void destruct(int16_t&) {}
-	inline static void destruct(int32_t&) {}
-	inline static void destruct(int64_t&) {}
-	inline static void destruct(float&) {}
-	inline static void destruct(double&) {}
-	inline static void destruct(long double&) {}
-
 	// a custom overload for buf which loops over all the elements and calls destruct, this is useful for destructing
 	// a big hierarchy without memory leaks, for example when you free mn::Buf<mn::Buf<int>> if you use mn::buf_free
 	// you'll only free the top level buf and won't free the small mn::Buf<int> inside, it's more appropriate to use
@@ -197,6 +175,18 @@ namespace mn
 		if (self.allocator == nullptr)
 			self.allocator = allocator_top();
 
+		// try to resize the current memory first, which avoids the copy in case the allocator can extend it
+		if (self.cap)
+		{
+			auto resized_block = self.allocator->realloc(Block{ self.ptr, self.cap * sizeof(T) }, new_count * sizeof(T), alignof(T));
+			if (resized_block.ptr)
+			{
+				self.ptr = (T*)resized_block.ptr;
+				self.cap = new_count;
+				return;
+			}
+		}
+
 		auto new_block = self.allocator->alloc(new_count * sizeof(T), alignof(T));
 
 		if(self.count)
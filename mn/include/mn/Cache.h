@@ -0,0 +1,331 @@
+#pragma once
+
+#include "mn/Map.h"
+#include "mn/Buf.h"
+#include "mn/Task.h"
+#include "mn/Assert.h"
+
+namespace mn
+{
+	// cache construction settings
+	template<typename TKey, typename TValue>
+	struct Cache_Settings
+	{
+		// max total cost of the entries in the cache, once an insert exceeds it the least recently used entries are
+		// evicted until the total cost fits again
+		size_t budget;
+		// returns the cost of the given entry (usually in bytes), it's called once when the entry is inserted
+		// default: sizeof(TKey) + sizeof(TValue)
+		Task<size_t(const TKey&, const TValue&)> cost;
+		// called with each entry which leaves the cache (evicted, replaced, removed, cleared, or destructed), the cache
+		// owns its keys and values so this function is responsible for freeing them
+		// default: calls destruct on the key and the value
+		Task<void(TKey&, TValue&)> on_evict;
+		// default: allocator_top()
+		Allocator allocator;
+	};
+
+	// a least recently used cache with a cost budget, the entries live in a slab buffer and are chained into an
+	// intrusive doubly linked list by slot index which is ordered from the most recently used (head) to the least
+	// recently used (tail), and a hash map indexes the keys to their slots, so lookup, insert, and evict are all O(1)
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	struct Cache
+	{
+		// marks the end of the list
+		static constexpr size_t NIL = ~size_t(0);
+
+		struct Entry
+		{
+			TKey key;
+			TValue value;
+			size_t cost;
+			// when the entry is in the free list only next is used
+			size_t prev;
+			size_t next;
+		};
+
+		// maps each key to the slot of its entry, the map key is a shallow copy of the entry key
+		Map<TKey, size_t, THash> index;
+		Buf<Entry> entries;
+		size_t free_head;
+		size_t head;
+		size_t tail;
+		size_t total_cost;
+		size_t budget;
+		Task<size_t(const TKey&, const TValue&)> cost;
+		Task<void(TKey&, TValue&)> on_evict;
+	};
+
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	_cache_unlink(Cache<TKey, TValue, THash>& self, size_t slot)
+	{
+		using Cache_Type = Cache<TKey, TValue, THash>;
+
+		auto& entry = self.entries[slot];
+		if (entry.prev != Cache_Type::NIL)
+			self.entries[entry.prev].next = entry.next;
+		else
+			self.head = entry.next;
+
+		if (entry.next != Cache_Type::NIL)
+			self.entries[entry.next].prev = entry.prev;
+		else
+			self.tail = entry.prev;
+	}
+
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	_cache_link_front(Cache<TKey, TValue, THash>& self, size_t slot)
+	{
+		using Cache_Type = Cache<TKey, TValue, THash>;
+
+		auto& entry = self.entries[slot];
+		entry.prev = Cache_Type::NIL;
+		entry.next = self.head;
+		if (self.head != Cache_Type::NIL)
+			self.entries[self.head].prev = slot;
+		else
+			self.tail = slot;
+		self.head = slot;
+	}
+
+	// hands the entry in the given slot to the eviction function and puts the slot in the free list, the entry should
+	// be already unlinked from the list and removed from the index
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	_cache_release(Cache<TKey, TValue, THash>& self, size_t slot)
+	{
+		auto& entry = self.entries[slot];
+		self.total_cost -= entry.cost;
+		if (self.on_evict)
+		{
+			self.on_evict(entry.key, entry.value);
+		}
+		else
+		{
+			destruct(entry.key);
+			destruct(entry.value);
+		}
+		entry.next = self.free_head;
+		self.free_head = slot;
+	}
+
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	_cache_evict_slot(Cache<TKey, TValue, THash>& self, size_t slot)
+	{
+		_cache_unlink(self, slot);
+		map_remove(self.index, self.entries[slot].key);
+		_cache_release(self, slot);
+	}
+
+	// creates a cache which uses the given tasks without owning them, it's used to share the same tasks between the
+	// shards of a concurrent cache
+	template<typename TKey, typename TValue, typename THash>
+	inline static Cache<TKey, TValue, THash>
+	_cache_with_tasks(Allocator allocator, size_t budget, const Task<size_t(const TKey&, const TValue&)>& cost, const Task<void(TKey&, TValue&)>& on_evict)
+	{
+		using Cache_Type = Cache<TKey, TValue, THash>;
+
+		Cache_Type self{};
+		self.index = map_with_allocator<TKey, size_t, THash>(allocator);
+		self.entries = buf_with_allocator<typename Cache_Type::Entry>(allocator);
+		self.free_head = Cache_Type::NIL;
+		self.head = Cache_Type::NIL;
+		self.tail = Cache_Type::NIL;
+		self.budget = budget;
+		self.cost = cost;
+		self.on_evict = on_evict;
+		return self;
+	}
+
+	// frees the memory of the given cache without calling the eviction function nor freeing its tasks
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	_cache_free_memory(Cache<TKey, TValue, THash>& self)
+	{
+		map_free(self.index);
+		buf_free(self.entries);
+		self.free_head = Cache<TKey, TValue, THash>::NIL;
+		self.head = Cache<TKey, TValue, THash>::NIL;
+		self.tail = Cache<TKey, TValue, THash>::NIL;
+		self.total_cost = 0;
+	}
+
+	// creates a new cache with the given settings, the cache takes ownership of the settings tasks
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	inline static Cache<TKey, TValue, THash>
+	cache_new(Cache_Settings<TKey, TValue> settings)
+	{
+		auto allocator = settings.allocator ? settings.allocator : allocator_top();
+		return _cache_with_tasks<TKey, TValue, THash>(allocator, settings.budget, settings.cost, settings.on_evict);
+	}
+
+	// creates a new cache with the given budget and the default cost and eviction functions
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	inline static Cache<TKey, TValue, THash>
+	cache_new(size_t budget)
+	{
+		Cache_Settings<TKey, TValue> settings{};
+		settings.budget = budget;
+		return cache_new<TKey, TValue, THash>(settings);
+	}
+
+	// frees the given cache and its tasks, note this doesn't call the eviction function on the remaining entries
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	cache_free(Cache<TKey, TValue, THash>& self)
+	{
+		_cache_free_memory(self);
+		task_free(self.cost);
+		task_free(self.on_evict);
+	}
+
+	// clears the given cache, the eviction function is called on all of its entries starting from the least recently
+	// used one
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	cache_clear(Cache<TKey, TValue, THash>& self)
+	{
+		using Cache_Type = Cache<TKey, TValue, THash>;
+
+		for (auto slot = self.tail; slot != Cache_Type::NIL;)
+		{
+			auto prev = self.entries[slot].prev;
+			_cache_release(self, slot);
+			slot = prev;
+		}
+		map_clear(self.index);
+		buf_clear(self.entries);
+		self.free_head = Cache_Type::NIL;
+		self.head = Cache_Type::NIL;
+		self.tail = Cache_Type::NIL;
+		mn_assert(self.total_cost == 0);
+	}
+
+	// destruct overload for cache, it calls the eviction function on all the entries then frees the cache
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	destruct(Cache<TKey, TValue, THash>& self)
+	{
+		cache_clear(self);
+		cache_free(self);
+	}
+
+	// returns the count of entries in the cache
+	template<typename TKey, typename TValue, typename THash>
+	inline static size_t
+	cache_count(const Cache<TKey, TValue, THash>& self)
+	{
+		return self.index.count;
+	}
+
+	// returns the total cost of the entries in the cache
+	template<typename TKey, typename TValue, typename THash>
+	inline static size_t
+	cache_cost(const Cache<TKey, TValue, THash>& self)
+	{
+		return self.total_cost;
+	}
+
+	// evicts the least recently used entries until the total cost of the cache fits in the given budget, it's useful
+	// to shrink the cache on memory pressure
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	cache_trim(Cache<TKey, TValue, THash>& self, size_t budget)
+	{
+		while (self.total_cost > budget && self.tail != Cache<TKey, TValue, THash>::NIL)
+			_cache_evict_slot(self, self.tail);
+	}
+
+	// searches for the given key in the cache and marks it as the most recently used entry, it returns a pointer to
+	// its value or nullptr if it doesn't exist, the pointer is valid until the next insert into the cache
+	template<typename TKey, typename TValue, typename THash>
+	inline static TValue*
+	cache_lookup(Cache<TKey, TValue, THash>& self, const TKey& key)
+	{
+		auto it = map_lookup(self.index, key);
+		if (it == nullptr)
+			return nullptr;
+
+		auto slot = it->value;
+		if (slot != self.head)
+		{
+			_cache_unlink(self, slot);
+			_cache_link_front(self, slot);
+		}
+		return &self.entries[slot].value;
+	}
+
+	// searches for the given key in the cache without changing its usage order, it returns a pointer to its value or
+	// nullptr if it doesn't exist
+	template<typename TKey, typename TValue, typename THash>
+	inline static const TValue*
+	cache_peek(const Cache<TKey, TValue, THash>& self, const TKey& key)
+	{
+		if (auto it = map_lookup(self.index, key))
+			return &self.entries[it->value].value;
+		return nullptr;
+	}
+
+	// inserts the given key and value into the cache as the most recently used entry and returns a pointer to the
+	// stored value, the cache takes ownership of the key and the value, if the key already exists its old entry is
+	// evicted first, then the least recently used entries are evicted until the total cost fits in the budget, an
+	// entry which costs more than the whole budget is still inserted but it evicts all the other entries
+	template<typename TKey, typename TValue, typename THash>
+	inline static TValue*
+	cache_insert(Cache<TKey, TValue, THash>& self, const TKey& key, const TValue& value)
+	{
+		using Cache_Type = Cache<TKey, TValue, THash>;
+
+		if (auto it = map_lookup(self.index, key))
+			_cache_evict_slot(self, it->value);
+
+		size_t cost = self.cost ? self.cost(key, value) : sizeof(TKey) + sizeof(TValue);
+
+		size_t slot = self.free_head;
+		if (slot != Cache_Type::NIL)
+		{
+			self.free_head = self.entries[slot].next;
+			self.entries[slot] = typename Cache_Type::Entry{key, value, cost, Cache_Type::NIL, Cache_Type::NIL};
+		}
+		else
+		{
+			slot = self.entries.count;
+			buf_push(self.entries, typename Cache_Type::Entry{key, value, cost, Cache_Type::NIL, Cache_Type::NIL});
+		}
+
+		_cache_link_front(self, slot);
+		map_insert(self.index, key, slot);
+		self.total_cost += cost;
+
+		while (self.total_cost > self.budget && self.tail != slot)
+			_cache_evict_slot(self, self.tail);
+
+		return &self.entries[slot].value;
+	}
+
+	// removes the given key from the cache and calls the eviction function on its entry, it returns whether it found
+	// and removed the key
+	template<typename TKey, typename TValue, typename THash>
+	inline static bool
+	cache_remove(Cache<TKey, TValue, THash>& self, const TKey& key)
+	{
+		auto it = map_lookup(self.index, key);
+		if (it == nullptr)
+			return false;
+		_cache_evict_slot(self, it->value);
+		return true;
+	}
+
+	// calls the given function with each key and value (`void(const TKey&, TValue&)`) in the cache ordered from the
+	// most recently used to the least recently used without changing the usage order
+	template<typename TKey, typename TValue, typename THash, typename TFunc>
+	inline static void
+	cache_each(Cache<TKey, TValue, THash>& self, TFunc&& func)
+	{
+		for (auto slot = self.head; slot != Cache<TKey, TValue, THash>::NIL; slot = self.entries[slot].next)
+			func((const TKey&)self.entries[slot].key, self.entries[slot].value);
+	}
+}
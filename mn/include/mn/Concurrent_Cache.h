@@ -0,0 +1,217 @@
+#pragma once
+
+#include "mn/Cache.h"
+#include "mn/Thread.h"
+#include "mn/Memory.h"
+
+namespace mn
+{
+	// default count of shards in a concurrent cache
+	constexpr size_t CONCURRENT_CACHE_DEFAULT_SHARDS_COUNT = 16;
+
+	// a thread safe least recently used cache which is useful to share a cache between multiple threads (e.g. fabric
+	// workers), the keys are distributed over a power of two count of shards where each shard is a cache with its own
+	// mutex and an equal slice of the budget, so the eviction order is least recently used per shard not globally,
+	// a lookup updates the usage order so it takes the shard's exclusive lock, and the values are returned as clones
+	// made while holding the lock because the entry might be evicted by another thread once the lock is released
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	struct Concurrent_Cache
+	{
+		struct alignas(64) Shard
+		{
+			Mutex mtx;
+			Cache<TKey, TValue, THash> cache;
+		};
+
+		Allocator allocator;
+		// the allocated block which the shards are placed in after aligning them
+		Block memory;
+		Shard* shards;
+		size_t shards_count;
+		// the shards use these tasks without owning them, they might be called from multiple threads at the same time
+		Task<size_t(const TKey&, const TValue&)> cost;
+		Task<void(TKey&, TValue&)> on_evict;
+	};
+
+	// returns the shard which the given key belongs to
+	template<typename TKey, typename TValue, typename THash>
+	inline static typename Concurrent_Cache<TKey, TValue, THash>::Shard&
+	_concurrent_cache_shard(const Concurrent_Cache<TKey, TValue, THash>& self, const TKey& key)
+	{
+		return self.shards[hash_shard_index(THash()(key), self.shards_count)];
+	}
+
+	// creates a new concurrent cache with the given settings and count of shards (rounded up to a power of two), the
+	// budget is divided equally between the shards, and the concurrent cache takes ownership of the settings tasks
+	// which should be safe to call from multiple threads
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	inline static Concurrent_Cache<TKey, TValue, THash>
+	concurrent_cache_new(Cache_Settings<TKey, TValue> settings, size_t shards_count = CONCURRENT_CACHE_DEFAULT_SHARDS_COUNT)
+	{
+		using Shard = typename Concurrent_Cache<TKey, TValue, THash>::Shard;
+
+		size_t count = 1;
+		while (count < shards_count)
+			count <<= 1;
+
+		Concurrent_Cache<TKey, TValue, THash> self{};
+		self.allocator = settings.allocator ? settings.allocator : allocator_top();
+		self.shards_count = count;
+		self.cost = settings.cost;
+		self.on_evict = settings.on_evict;
+		self.shards = (Shard*)alloc_aligned_from(self.allocator, sizeof(Shard) * count, alignof(Shard), self.memory);
+		for (size_t i = 0; i < count; ++i)
+		{
+			self.shards[i].mtx = mutex_new("Concurrent_Cache");
+			self.shards[i].cache = _cache_with_tasks<TKey, TValue, THash>(self.allocator, settings.budget / count, self.cost, self.on_evict);
+		}
+		return self;
+	}
+
+	// creates a new concurrent cache with the given budget, count of shards, and the default cost and eviction functions
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	inline static Concurrent_Cache<TKey, TValue, THash>
+	concurrent_cache_new(size_t budget, size_t shards_count = CONCURRENT_CACHE_DEFAULT_SHARDS_COUNT)
+	{
+		Cache_Settings<TKey, TValue> settings{};
+		settings.budget = budget;
+		return concurrent_cache_new<TKey, TValue, THash>(settings, shards_count);
+	}
+
+	// frees the given concurrent cache and its tasks, note this doesn't call the eviction function on the remaining
+	// entries
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	concurrent_cache_free(Concurrent_Cache<TKey, TValue, THash>& self)
+	{
+		if (self.shards == nullptr)
+			return;
+
+		for (size_t i = 0; i < self.shards_count; ++i)
+		{
+			mutex_free(self.shards[i].mtx);
+			_cache_free_memory(self.shards[i].cache);
+		}
+		free_from(self.allocator, self.memory);
+		self.memory = Block{};
+		self.shards = nullptr;
+		self.shards_count = 0;
+		task_free(self.cost);
+		task_free(self.on_evict);
+	}
+
+	// clears the given concurrent cache, the eviction function is called on all of its entries
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	concurrent_cache_clear(Concurrent_Cache<TKey, TValue, THash>& self)
+	{
+		for (size_t i = 0; i < self.shards_count; ++i)
+		{
+			mutex_lock(self.shards[i].mtx);
+			cache_clear(self.shards[i].cache);
+			mutex_unlock(self.shards[i].mtx);
+		}
+	}
+
+	// destruct overload for concurrent cache, it calls the eviction function on all the entries then frees the
+	// concurrent cache
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	destruct(Concurrent_Cache<TKey, TValue, THash>& self)
+	{
+		concurrent_cache_clear(self);
+		concurrent_cache_free(self);
+	}
+
+	// inserts the given key and value into the concurrent cache, the cache takes ownership of the key and the value,
+	// if the key already exists its old entry is evicted first, then the least recently used entries of the key's shard
+	// are evicted until the shard fits in its budget, the eviction function is called while holding the shard's lock
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	concurrent_cache_insert(Concurrent_Cache<TKey, TValue, THash>& self, const TKey& key, const TValue& value)
+	{
+		auto& shard = _concurrent_cache_shard(self, key);
+		mutex_lock(shard.mtx);
+		cache_insert(shard.cache, key, value);
+		mutex_unlock(shard.mtx);
+	}
+
+	// searches for the given key in the concurrent cache and marks it as the most recently used entry of its shard, if
+	// it exists it clones its value into the given value and returns true, otherwise it returns false, the clone is
+	// made while holding the shard's lock and the caller owns it, so it stays valid if the entry gets evicted
+	template<typename TKey, typename TValue, typename THash>
+	inline static bool
+	concurrent_cache_lookup(Concurrent_Cache<TKey, TValue, THash>& self, const TKey& key, TValue& value)
+	{
+		auto& shard = _concurrent_cache_shard(self, key);
+		mutex_lock(shard.mtx);
+		auto it = cache_lookup(shard.cache, key);
+		if (it)
+			value = clone(*it);
+		mutex_unlock(shard.mtx);
+		return it != nullptr;
+	}
+
+	// returns a clone of the value of the given key, if the key doesn't exist it calls the given constructor function
+	// to create its value and inserts it with a clone of the key, so the key is always borrowed and the caller owns the
+	// returned value, the constructor function is called with the key (`TValue(const TKey&)`) while holding the lock
+	// of the key's shard so it shouldn't access the same concurrent cache
+	template<typename TKey, typename TValue, typename THash, typename TFunc>
+	inline static TValue
+	concurrent_cache_get_or_insert(Concurrent_Cache<TKey, TValue, THash>& self, const TKey& key, TFunc&& make)
+	{
+		auto& shard = _concurrent_cache_shard(self, key);
+		mutex_lock(shard.mtx);
+		auto it = cache_lookup(shard.cache, key);
+		if (it == nullptr)
+			it = cache_insert(shard.cache, clone(key), TValue(make(key)));
+		TValue res = clone(*it);
+		mutex_unlock(shard.mtx);
+		return res;
+	}
+
+	// removes the given key from the concurrent cache and calls the eviction function on its entry, it returns whether
+	// it found and removed the key
+	template<typename TKey, typename TValue, typename THash>
+	inline static bool
+	concurrent_cache_remove(Concurrent_Cache<TKey, TValue, THash>& self, const TKey& key)
+	{
+		auto& shard = _concurrent_cache_shard(self, key);
+		mutex_lock(shard.mtx);
+		auto res = cache_remove(shard.cache, key);
+		mutex_unlock(shard.mtx);
+		return res;
+	}
+
+	// returns the count of entries in the concurrent cache, the count might be stale by the time it returns if other
+	// threads are modifying the cache
+	template<typename TKey, typename TValue, typename THash>
+	inline static size_t
+	concurrent_cache_count(const Concurrent_Cache<TKey, TValue, THash>& self)
+	{
+		size_t res = 0;
+		for (size_t i = 0; i < self.shards_count; ++i)
+		{
+			mutex_lock(self.shards[i].mtx);
+			res += cache_count(self.shards[i].cache);
+			mutex_unlock(self.shards[i].mtx);
+		}
+		return res;
+	}
+
+	// returns the total cost of the entries in the concurrent cache, the cost might be stale by the time it returns if
+	// other threads are modifying the cache
+	template<typename TKey, typename TValue, typename THash>
+	inline static size_t
+	concurrent_cache_cost(const Concurrent_Cache<TKey, TValue, THash>& self)
+	{
+		size_t res = 0;
+		for (size_t i = 0; i < self.shards_count; ++i)
+		{
+			mutex_lock(self.shards[i].mtx);
+			res += cache_cost(self.shards[i].cache);
+			mutex_unlock(self.shards[i].mtx);
+		}
+		return res;
+	}
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+#include "mn/Map.h"
+#include "mn/Thread.h"
+#include "mn/Memory.h"
+#include "mn/Assert.h"
+
+namespace mn
+{
+	// default count of shards in a concurrent map
+	constexpr size_t CONCURRENT_MAP_DEFAULT_SHARDS_COUNT = 64;
+
+	// a thread safe hash map which is useful to share lookup tables between multiple threads (e.g. fabric workers),
+	// the keys are distributed over a power of two count of shards where each shard is a hash map with its own
+	// read-write mutex, so threads which touch different shards don't contend with each other, and each shard grows
+	// on its own under its own lock which means a resize blocks only the keys of this shard and not the whole map
+	// insert takes ownership of the given key and value like map_insert, the other functions borrow the given key, and
+	// the values are returned as clones made while holding the shard's lock which the caller owns, because the entry
+	// might be removed or moved by a rehash once the lock is released
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	struct Concurrent_Map
+	{
+		struct alignas(64) Shard
+		{
+			Mutex_RW mtx;
+			Map<TKey, TValue, THash> map;
+		};
+
+		Allocator allocator;
+		// the allocated block which the shards are placed in after aligning them
+		Block memory;
+		Shard* shards;
+		size_t shards_count;
+	};
+
+	// returns the shard which the given key belongs to
+	template<typename TKey, typename TValue, typename THash>
+	inline static typename Concurrent_Map<TKey, TValue, THash>::Shard&
+	_concurrent_map_shard(const Concurrent_Map<TKey, TValue, THash>& self, const TKey& key)
+	{
+		return self.shards[hash_shard_index(THash()(key), self.shards_count)];
+	}
+
+	// creates a new concurrent map with the given allocator and count of shards (rounded up to a power of two)
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	inline static Concurrent_Map<TKey, TValue, THash>
+	concurrent_map_with_allocator(Allocator allocator, size_t shards_count = CONCURRENT_MAP_DEFAULT_SHARDS_COUNT)
+	{
+		using Shard = typename Concurrent_Map<TKey, TValue, THash>::Shard;
+
+		size_t count = 1;
+		while (count < shards_count)
+			count <<= 1;
+
+		Concurrent_Map<TKey, TValue, THash> self{};
+		self.allocator = allocator;
+		self.shards_count = count;
+		self.shards = (Shard*)alloc_aligned_from(allocator, sizeof(Shard) * count, alignof(Shard), self.memory);
+		for (size_t i = 0; i < count; ++i)
+		{
+			self.shards[i].mtx = mutex_rw_new("Concurrent_Map");
+			self.shards[i].map = map_with_allocator<TKey, TValue, THash>(allocator);
+		}
+		return self;
+	}
+
+	// creates a new concurrent map with the given count of shards (rounded up to a power of two)
+	template<typename TKey, typename TValue, typename THash = Hash<TKey>>
+	inline static Concurrent_Map<TKey, TValue, THash>
+	concurrent_map_new(size_t shards_count = CONCURRENT_MAP_DEFAULT_SHARDS_COUNT)
+	{
+		return concurrent_map_with_allocator<TKey, TValue, THash>(allocator_top(), shards_count);
+	}
+
+	// frees the given concurrent map, note this doesn't free any complex data structure stored in it
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	concurrent_map_free(Concurrent_Map<TKey, TValue, THash>& self)
+	{
+		if (self.shards == nullptr)
+			return;
+
+		for (size_t i = 0; i < self.shards_count; ++i)
+		{
+			mutex_rw_free(self.shards[i].mtx);
+			map_free(self.shards[i].map);
+		}
+		free_from(self.allocator, self.memory);
+		self.memory = Block{};
+		self.shards = nullptr;
+		self.shards_count = 0;
+	}
+
+	// destruct overload for concurrent map, it calls destruct on each key and value then frees the concurrent map
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	destruct(Concurrent_Map<TKey, TValue, THash>& self)
+	{
+		if (self.shards == nullptr)
+			return;
+
+		for (size_t i = 0; i < self.shards_count; ++i)
+		{
+			destruct(self.shards[i].map);
+			self.shards[i].map = map_with_allocator<TKey, TValue, THash>(self.allocator);
+		}
+		concurrent_map_free(self);
+	}
+
+	// inserts the given key and value into the concurrent map, if the key already exists its value is overwritten
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	concurrent_map_insert(Concurrent_Map<TKey, TValue, THash>& self, const TKey& key, const TValue& value)
+	{
+		auto& shard = _concurrent_map_shard(self, key);
+		mutex_write_lock(shard.mtx);
+		map_insert(shard.map, key, value);
+		mutex_write_unlock(shard.mtx);
+	}
+
+	// searches for the given key in the concurrent map, if it exists it clones its value into the given value and
+	// returns true, otherwise it returns false, the clone is made while holding the shard's lock and the caller owns it
+	template<typename TKey, typename TValue, typename THash>
+	inline static bool
+	concurrent_map_lookup(const Concurrent_Map<TKey, TValue, THash>& self, const TKey& key, TValue& value)
+	{
+		auto& shard = _concurrent_map_shard(self, key);
+		mutex_read_lock(shard.mtx);
+		auto it = map_lookup(shard.map, key);
+		if (it)
+			value = clone(it->value);
+		mutex_read_unlock(shard.mtx);
+		return it != nullptr;
+	}
+
+	// returns whether the given key exists in the concurrent map
+	template<typename TKey, typename TValue, typename THash>
+	inline static bool
+	concurrent_map_contains(const Concurrent_Map<TKey, TValue, THash>& self, const TKey& key)
+	{
+		auto& shard = _concurrent_map_shard(self, key);
+		mutex_read_lock(shard.mtx);
+		auto res = map_lookup(shard.map, key) != nullptr;
+		mutex_read_unlock(shard.mtx);
+		return res;
+	}
+
+	// removes the given key from the concurrent map, and returns whether it found and removed the key, note this
+	// doesn't free any complex data structure stored in the key or the value
+	template<typename TKey, typename TValue, typename THash>
+	inline static bool
+	concurrent_map_remove(Concurrent_Map<TKey, TValue, THash>& self, const TKey& key)
+	{
+		auto& shard = _concurrent_map_shard(self, key);
+		mutex_write_lock(shard.mtx);
+		auto res = map_remove(shard.map, key);
+		mutex_write_unlock(shard.mtx);
+		return res;
+	}
+
+	// returns a clone of the value of the given key, if the key doesn't exist it calls the given constructor function
+	// to create its value and inserts it with a clone of the key, so the key is always borrowed and the caller owns the
+	// returned value, the constructor function is called with the key (`TValue(const TKey&)`) at most once per key
+	// while holding the write lock of the key's shard so it shouldn't access the same concurrent map
+	template<typename TKey, typename TValue, typename THash, typename TFunc>
+	inline static TValue
+	concurrent_map_get_or_insert(Concurrent_Map<TKey, TValue, THash>& self, const TKey& key, TFunc&& make)
+	{
+		auto& shard = _concurrent_map_shard(self, key);
+
+		// fast path, most calls find the key so we only need a read lock
+		mutex_read_lock(shard.mtx);
+		if (auto it = map_lookup(shard.map, key))
+		{
+			TValue res = clone(it->value);
+			mutex_read_unlock(shard.mtx);
+			return res;
+		}
+		mutex_read_unlock(shard.mtx);
+
+		// slow path, another thread might have inserted the key before we acquire the write lock so we search again
+		mutex_write_lock(shard.mtx);
+		auto it = map_lookup(shard.map, key);
+		if (it == nullptr)
+			it = map_insert(shard.map, clone(key), TValue(make(key)));
+		TValue res = clone(it->value);
+		mutex_write_unlock(shard.mtx);
+		return res;
+	}
+
+	// returns the count of keys in the concurrent map, the count might be stale by the time it returns if other threads
+	// are modifying the map
+	template<typename TKey, typename TValue, typename THash>
+	inline static size_t
+	concurrent_map_count(const Concurrent_Map<TKey, TValue, THash>& self)
+	{
+		size_t res = 0;
+		for (size_t i = 0; i < self.shards_count; ++i)
+		{
+			mutex_read_lock(self.shards[i].mtx);
+			res += self.shards[i].map.count;
+			mutex_read_unlock(self.shards[i].mtx);
+		}
+		return res;
+	}
+
+	// clears the given concurrent map content, note this doesn't free any complex data structure stored in it
+	template<typename TKey, typename TValue, typename THash>
+	inline static void
+	concurrent_map_clear(Concurrent_Map<TKey, TValue, THash>& self)
+	{
+		for (size_t i = 0; i < self.shards_count; ++i)
+		{
+			mutex_write_lock(self.shards[i].mtx);
+			map_clear(self.shards[i].map);
+			mutex_write_unlock(self.shards[i].mtx);
+		}
+	}
+
+	// calls the given function with each key and value (`void(const TKey&, TValue&)`) in the concurrent map, each shard
+	// is write locked while its keys are visited so the function shouldn't access the same concurrent map
+	template<typename TKey, typename TValue, typename THash, typename TFunc>
+	inline static void
+	concurrent_map_each(Concurrent_Map<TKey, TValue, THash>& self, TFunc&& func)
+	{
+		for (size_t i = 0; i < self.shards_count; ++i)
+		{
+			mutex_write_lock(self.shards[i].mtx);
+			for (auto& [key, value]: self.shards[i].map)
+				func(key, value);
+			mutex_write_unlock(self.shards[i].mtx);
+		}
+	}
+}
@@ -19,14 +19,22 @@ namespace mn
 	struct Context
 	{
 		//allocators data
-		inline static constexpr size_t ALLOCATOR_CAPACITY = 1024;
-		Allocator _allocator_stack[ALLOCATOR_CAPACITY];
+		// the allocator stack starts in the inline storage and grows into a heap allocated one on demand
+		inline static constexpr size_t ALLOCATOR_INLINE_CAPACITY = 16;
+		Allocator _allocator_stack_inline[ALLOCATOR_INLINE_CAPACITY];
+		Allocator* _allocator_stack;
 		size_t _allocator_stack_count;
+		size_t _allocator_stack_capacity;
 
 		//tmp allocator
-		memory::Arena _allocator_tmp = {4ULL * 1024ULL * 1024ULL, memory::clib()};
+		// it's allocated lazily on the first call to memory::tmp()
+		inline static constexpr size_t TMP_DEFAULT_BLOCK_SIZE = 4ULL * 1024ULL * 1024ULL;
+		memory::Arena* _allocator_tmp;
+		size_t _allocator_tmp_block_size;
+		size_t _allocator_tmp_spare_mem_cap;
 
 		//Local tmp stream
+		// it's allocated lazily on the first call to reader_tmp()
 		Reader reader_tmp;
 	};
 
@@ -45,9 +53,15 @@ namespace mn
 	MN_EXPORT Context*
 	context_local(Context* new_context = nullptr);
 
+	// sets the default block size of the tmp allocator of the contexts which will be initialized after this call, the
+	// default is 4MB, you can lower it in case you have a lot of short lived threads which use little tmp memory
+	MN_EXPORT void
+	context_tmp_block_size_default_set(size_t block_size);
+
 	// allocators are organized in a per thread stack so that you can default/top used allocator by calling
 	// mn::allocator_push and mn::allocator_pop, at the base of the stack is the clib allocator and it can't be popped
-	// it returns the current default/top allocator of the calling thread
+	// it returns the current default/top allocator of the calling thread, the top allocator is cached in a thread local
+	// variable so the common path is a single thread local load
 	MN_EXPORT Allocator
 	allocator_top();
 
@@ -64,6 +78,16 @@ namespace mn
 		// returns the current thread's tmp memory allocator
 		MN_EXPORT Arena*
 		tmp();
+
+		// sets the block size of the current thread's tmp memory allocator, it takes effect on the next block the
+		// tmp allocator grows into
+		MN_EXPORT void
+		tmp_block_size_set(size_t block_size);
+
+		// sets the count of bytes which the current thread's tmp memory allocator retains for reuse when it's restored
+		// to a checkpoint, it's applied to the tmp allocator once it's created if it doesn't exist yet
+		MN_EXPORT void
+		tmp_spare_mem_cap_set(size_t spare_mem_cap);
 	}
 
 	// returns the current thread's tmp reader, useful for quick parsing of string
@@ -0,0 +1,296 @@
+#pragma once
+
+#include "mn/Map.h"
+#include "mn/Buf.h"
+#include "mn/Assert.h"
+
+namespace mn
+{
+	// count of fingerprints in each cuckoo filter bucket
+	constexpr size_t CUCKOO_FILTER_BUCKET_SIZE = 4;
+
+	// max count of relocations an insert performs before it declares the filter full
+	constexpr size_t CUCKOO_FILTER_MAX_KICKS = 500;
+
+	// a cuckoo filter which is a probabilistic set like the bloom filter but it also supports removing keys, each key
+	// is reduced to a 16 bit fingerprint which is stored in one of two candidate buckets of 4 fingerprints, each bucket
+	// is packed into a single 64 bit word so a lookup checks all the fingerprints of a bucket at once, and the alternate
+	// bucket is computed from the fingerprint alone so the fingerprints can be relocated without the original keys,
+	// the false positive rate is about 0.01% and the filter can be filled up to ~95% of its capacity, the keys are
+	// hashed with the stable hash functor by default so a persisted filter stays valid in processes which randomize
+	// the global hash seed
+	template<typename T, typename THash = Stable_Hash<T>>
+	struct Cuckoo_Filter
+	{
+		// each bucket packs its 4 fingerprints into 16 bit lanes, 0 marks an empty lane
+		Buf<uint64_t> buckets;
+		size_t count;
+		// when an insert runs out of relocations the last evicted fingerprint is kept here, 0 means there's no victim,
+		// and the filter is considered full while it has a victim
+		uint16_t victim_fingerprint;
+		size_t victim_index;
+		// state of the random generator which picks the fingerprints to relocate
+		uint64_t random_state;
+	};
+
+	// returns the bucket index and fingerprint of the given hash, the fingerprint is never 0
+	inline static void
+	_cuckoo_filter_split(size_t hash, size_t mask, size_t& index, uint16_t& fingerprint)
+	{
+		auto mixed = _wyhash_mix(uint64_t(hash) ^ 0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL);
+		index = size_t(mixed) & mask;
+		fingerprint = uint16_t(mixed >> 48);
+		if (fingerprint == 0)
+			fingerprint = 1;
+	}
+
+	// returns the other bucket of the given fingerprint, it's an involution so it can be applied to either bucket
+	inline static size_t
+	_cuckoo_filter_alt_index(size_t index, uint16_t fingerprint, size_t mask)
+	{
+		return (index ^ size_t(uint64_t(fingerprint) * 0x5bd1e995ULL)) & mask;
+	}
+
+	// returns whether the given bucket contains the given fingerprint, it xors the fingerprint with all the lanes then
+	// checks for a zero lane using the classic has-zero bit trick
+	inline static bool
+	_cuckoo_filter_bucket_has(uint64_t bucket, uint16_t fingerprint)
+	{
+		auto x = bucket ^ (uint64_t(fingerprint) * 0x0001000100010001ULL);
+		return ((x - 0x0001000100010001ULL) & ~x & 0x8000800080008000ULL) != 0;
+	}
+
+	inline static uint16_t
+	_cuckoo_filter_lane(uint64_t bucket, size_t lane)
+	{
+		return uint16_t(bucket >> (lane * 16));
+	}
+
+	inline static void
+	_cuckoo_filter_lane_set(uint64_t& bucket, size_t lane, uint16_t fingerprint)
+	{
+		bucket &= ~(uint64_t(0xffff) << (lane * 16));
+		bucket |= uint64_t(fingerprint) << (lane * 16);
+	}
+
+	// puts the given fingerprint in an empty lane of the given bucket, and returns false if the bucket is full
+	inline static bool
+	_cuckoo_filter_bucket_add(uint64_t& bucket, uint16_t fingerprint)
+	{
+		for (size_t lane = 0; lane < CUCKOO_FILTER_BUCKET_SIZE; ++lane)
+		{
+			if (_cuckoo_filter_lane(bucket, lane) == 0)
+			{
+				_cuckoo_filter_lane_set(bucket, lane, fingerprint);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// removes a single copy of the given fingerprint from the given bucket, and returns whether it found it
+	inline static bool
+	_cuckoo_filter_bucket_remove(uint64_t& bucket, uint16_t fingerprint)
+	{
+		for (size_t lane = 0; lane < CUCKOO_FILTER_BUCKET_SIZE; ++lane)
+		{
+			if (_cuckoo_filter_lane(bucket, lane) == fingerprint)
+			{
+				_cuckoo_filter_lane_set(bucket, lane, 0);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// creates a cuckoo filter with the given count of buckets (should be a power of two), all the buckets are empty
+	template<typename T, typename THash = Stable_Hash<T>>
+	inline static Cuckoo_Filter<T, THash>
+	_cuckoo_filter_with_buckets(Allocator allocator, size_t buckets_count)
+	{
+		mn_assert(buckets_count > 0 && (buckets_count & (buckets_count - 1)) == 0);
+
+		Cuckoo_Filter<T, THash> self{};
+		self.buckets = buf_with_allocator<uint64_t>(allocator);
+		buf_resize_fill(self.buckets, buckets_count, uint64_t(0));
+		self.random_state = 0x9e3779b97f4a7c15ULL;
+		return self;
+	}
+
+	// creates a new cuckoo filter with the given allocator which can hold at least the given count of keys
+	template<typename T, typename THash = Stable_Hash<T>>
+	inline static Cuckoo_Filter<T, THash>
+	cuckoo_filter_with_allocator(Allocator allocator, size_t capacity)
+	{
+		// we aim for a 90% load factor at the requested capacity which leaves room for the relocations to succeed
+		auto min_buckets_count = (capacity * 10 / 9 + CUCKOO_FILTER_BUCKET_SIZE - 1) / CUCKOO_FILTER_BUCKET_SIZE;
+		size_t buckets_count = 1;
+		while (buckets_count < min_buckets_count)
+			buckets_count <<= 1;
+		return _cuckoo_filter_with_buckets<T, THash>(allocator, buckets_count);
+	}
+
+	// creates a new cuckoo filter which can hold at least the given count of keys
+	template<typename T, typename THash = Stable_Hash<T>>
+	inline static Cuckoo_Filter<T, THash>
+	cuckoo_filter_new(size_t capacity)
+	{
+		return cuckoo_filter_with_allocator<T, THash>(allocator_top(), capacity);
+	}
+
+	// frees the given cuckoo filter
+	template<typename T, typename THash>
+	inline static void
+	cuckoo_filter_free(Cuckoo_Filter<T, THash>& self)
+	{
+		buf_free(self.buckets);
+		self.count = 0;
+		self.victim_fingerprint = 0;
+	}
+
+	// destruct overload for cuckoo filter free
+	template<typename T, typename THash>
+	inline static void
+	destruct(Cuckoo_Filter<T, THash>& self)
+	{
+		cuckoo_filter_free(self);
+	}
+
+	// clears all the keys from the given cuckoo filter
+	template<typename T, typename THash>
+	inline static void
+	cuckoo_filter_clear(Cuckoo_Filter<T, THash>& self)
+	{
+		buf_fill(self.buckets, uint64_t(0));
+		self.count = 0;
+		self.victim_fingerprint = 0;
+	}
+
+	// returns the count of keys in the cuckoo filter
+	template<typename T, typename THash>
+	inline static size_t
+	cuckoo_filter_count(const Cuckoo_Filter<T, THash>& self)
+	{
+		return self.count;
+	}
+
+	// returns the count of keys the cuckoo filter can hold when it's completely full
+	template<typename T, typename THash>
+	inline static size_t
+	cuckoo_filter_capacity(const Cuckoo_Filter<T, THash>& self)
+	{
+		return self.buckets.count * CUCKOO_FILTER_BUCKET_SIZE;
+	}
+
+	// puts the given fingerprint in one of its two buckets relocating other fingerprints if needed, if it runs out of
+	// relocations the last evicted fingerprint becomes the victim
+	template<typename T, typename THash>
+	inline static void
+	_cuckoo_filter_add(Cuckoo_Filter<T, THash>& self, size_t index, uint16_t fingerprint)
+	{
+		auto mask = self.buckets.count - 1;
+		auto alt_index = _cuckoo_filter_alt_index(index, fingerprint, mask);
+		if (_cuckoo_filter_bucket_add(self.buckets[index], fingerprint) ||
+			_cuckoo_filter_bucket_add(self.buckets[alt_index], fingerprint))
+		{
+			return;
+		}
+
+		// both buckets are full so we kick a random fingerprint out of one of them to its other bucket, and keep going
+		// from the bucket it lands in until one of them finds an empty lane
+		if (self.random_state & 1)
+			index = alt_index;
+		for (size_t kick = 0; kick < CUCKOO_FILTER_MAX_KICKS; ++kick)
+		{
+			// xorshift64
+			self.random_state ^= self.random_state << 13;
+			self.random_state ^= self.random_state >> 7;
+			self.random_state ^= self.random_state << 17;
+
+			auto lane = size_t(self.random_state & (CUCKOO_FILTER_BUCKET_SIZE - 1));
+			auto kicked = _cuckoo_filter_lane(self.buckets[index], lane);
+			_cuckoo_filter_lane_set(self.buckets[index], lane, fingerprint);
+			fingerprint = kicked;
+
+			index = _cuckoo_filter_alt_index(index, fingerprint, mask);
+			if (_cuckoo_filter_bucket_add(self.buckets[index], fingerprint))
+				return;
+		}
+
+		self.victim_fingerprint = fingerprint;
+		self.victim_index = index;
+	}
+
+	// inserts the given key into the cuckoo filter, and returns false if the filter is full, note that inserting the
+	// same key multiple times stores multiple copies of its fingerprint
+	template<typename T, typename THash>
+	inline static bool
+	cuckoo_filter_insert(Cuckoo_Filter<T, THash>& self, const T& key)
+	{
+		if (self.victim_fingerprint != 0)
+			return false;
+
+		size_t index = 0;
+		uint16_t fingerprint = 0;
+		_cuckoo_filter_split(THash()(key), self.buckets.count - 1, index, fingerprint);
+		_cuckoo_filter_add(self, index, fingerprint);
+		++self.count;
+		return true;
+	}
+
+	// returns false if the given key is definitely not in the cuckoo filter, and true if it's probably in it
+	template<typename T, typename THash>
+	inline static bool
+	cuckoo_filter_contains(const Cuckoo_Filter<T, THash>& self, const T& key)
+	{
+		auto mask = self.buckets.count - 1;
+		size_t index = 0;
+		uint16_t fingerprint = 0;
+		_cuckoo_filter_split(THash()(key), mask, index, fingerprint);
+		auto alt_index = _cuckoo_filter_alt_index(index, fingerprint, mask);
+
+		if (_cuckoo_filter_bucket_has(self.buckets[index], fingerprint) ||
+			_cuckoo_filter_bucket_has(self.buckets[alt_index], fingerprint))
+		{
+			return true;
+		}
+
+		return self.victim_fingerprint == fingerprint && (self.victim_index == index || self.victim_index == alt_index);
+	}
+
+	// removes the given key from the cuckoo filter, and returns whether it found it, note that you should only remove
+	// keys which were inserted into the filter, otherwise you might remove another key which shares its fingerprint
+	template<typename T, typename THash>
+	inline static bool
+	cuckoo_filter_remove(Cuckoo_Filter<T, THash>& self, const T& key)
+	{
+		auto mask = self.buckets.count - 1;
+		size_t index = 0;
+		uint16_t fingerprint = 0;
+		_cuckoo_filter_split(THash()(key), mask, index, fingerprint);
+		auto alt_index = _cuckoo_filter_alt_index(index, fingerprint, mask);
+
+		if (self.victim_fingerprint == fingerprint && (self.victim_index == index || self.victim_index == alt_index))
+		{
+			self.victim_fingerprint = 0;
+			--self.count;
+			return true;
+		}
+
+		if (_cuckoo_filter_bucket_remove(self.buckets[index], fingerprint) ||
+			_cuckoo_filter_bucket_remove(self.buckets[alt_index], fingerprint))
+		{
+			--self.count;
+			// now that there's a free lane we give the victim another chance
+			if (self.victim_fingerprint != 0)
+			{
+				auto victim_fingerprint = self.victim_fingerprint;
+				self.victim_fingerprint = 0;
+				_cuckoo_filter_add(self, self.victim_index, victim_fingerprint);
+			}
+			return true;
+		}
+
+		return false;
+	}
+}
@@ -1,12 +1,16 @@
 #pragma once
 
 #include "mn/Memory.h"
+#include "mn/Buf.h"
 #include "mn/Assert.h"
 
 #include <string.h>
 
 namespace mn
 {
+	// the target size of a deque bucket in bytes
+	constexpr size_t DEQUE_BUCKET_BYTES = 4096;
+
 	struct Deque_Index
 	{
 		// index of the bucket in array
@@ -15,7 +19,8 @@ namespace mn
 		size_t element_index;
 	};
 
-	// a double ended queue which allows you to push to either sides of the array
+	// a double ended queue which allows you to push to either sides of the array, the elements are stored in fixed size
+	// buckets which never move, the bucket size is a power of two so locating an element is a shift and a mask
 	template<typename T>
 	struct Deque
 	{
@@ -27,56 +32,101 @@ namespace mn
 		size_t bucket_cap;
 		Deque_Index front;
 		Deque_Index back;
+		// count of elements in each bucket, it's a power of two
 		size_t bucket_size;
+		// log2(bucket_size)
+		size_t bucket_shift;
+		// bucket_size - 1
+		size_t bucket_mask;
 
 		T&
 		operator[](size_t ix)
 		{
 			mn_assert(ix < count);
-			size_t bucket_index = ix / bucket_size;
-			size_t element_index = ix % bucket_size;
-
-			bucket_index += front.bucket_index;
-			element_index += front.element_index;
-
-			bucket_index += element_index / bucket_size;
-			element_index = element_index % bucket_size;
-			return buckets[bucket_index][element_index];
+			size_t position = (front.bucket_index << bucket_shift) + front.element_index + ix;
+			return buckets[position >> bucket_shift][position & bucket_mask];
 		}
 
 		const T&
 		operator[](size_t ix) const
 		{
 			mn_assert(ix < count);
-			size_t bucket_index = ix / bucket_size;
-			size_t element_index = ix % bucket_size;
+			size_t position = (front.bucket_index << bucket_shift) + front.element_index + ix;
+			return buckets[position >> bucket_shift][position & bucket_mask];
+		}
+	};
 
-			bucket_index += front.bucket_index;
-			element_index += front.element_index;
+	// a contiguous run of deque elements which live in the same bucket, it can be iterated like a normal array
+	template<typename T>
+	struct Deque_Segment
+	{
+		T* ptr;
+		size_t count;
 
-			bucket_index += element_index / bucket_size;
-			element_index = element_index % bucket_size;
-			return buckets[bucket_index][element_index];
+		T&
+		operator[](size_t ix) const
+		{
+			mn_assert(ix < count);
+			return ptr[ix];
 		}
+
+		T* begin() const { return ptr; }
+		T* end() const { return ptr + count; }
 	};
 
-	// creates a new instance of a deque
+	// iterates over the segments of a deque, each step moves to the start of the next bucket
 	template<typename T>
-	inline static Deque<T>
-	deque_new()
+	struct Deque_Segment_Iterator
 	{
-		Deque<T> self{};
-		self.allocator = allocator_top();
-		self.buckets = nullptr;
-		self.count = 0;
-		self.cap = 0;
-		self.bucket_count = 0;
-		self.bucket_cap = 0;
-		self.front = { 0, 0 };
-		self.back = { 0, 0 };
-		self.bucket_size = sizeof(T) >= 4096 ? 1 : (4096 / sizeof(T));
-		return self;
-	}
+		T* const* buckets;
+		// position of the current segment counting from the start of the first bucket
+		size_t position;
+		size_t end_position;
+		size_t bucket_shift;
+		size_t bucket_mask;
+
+		Deque_Segment<T>
+		operator*() const
+		{
+			auto element_index = position & bucket_mask;
+			auto count = bucket_mask + 1 - element_index;
+			if (count > end_position - position)
+				count = end_position - position;
+			return Deque_Segment<T>{buckets[position >> bucket_shift] + element_index, count};
+		}
+
+		Deque_Segment_Iterator&
+		operator++()
+		{
+			position = (position | bucket_mask) + 1;
+			if (position > end_position)
+				position = end_position;
+			return *this;
+		}
+
+		bool
+		operator==(const Deque_Segment_Iterator& other) const
+		{
+			return position == other.position;
+		}
+
+		bool
+		operator!=(const Deque_Segment_Iterator& other) const
+		{
+			return position != other.position;
+		}
+	};
+
+	// a range over the segments of a deque which can be used in a range for loop
+	template<typename T>
+	struct Deque_Segments
+	{
+		Deque_Segment_Iterator<T> first;
+		Deque_Segment_Iterator<T> last;
+
+		Deque_Segment_Iterator<T> begin() const { return first; }
+		Deque_Segment_Iterator<T> end() const { return last; }
+	};
 
 	// creates a new deque instance with the given allocator
 	template<typename T>
@@ -92,10 +142,26 @@ namespace mn
 		self.bucket_cap = 0;
 		self.front = { 0, 0 };
 		self.back = { 0, 0 };
-		self.bucket_size = sizeof(T) >= 4096 ? 1 : (4096 / sizeof(T));
+		// the largest power of two count of elements which fits in the bucket bytes
+		self.bucket_size = 1;
+		self.bucket_shift = 0;
+		while (self.bucket_size * 2 * sizeof(T) <= DEQUE_BUCKET_BYTES)
+		{
+			self.bucket_size *= 2;
+			++self.bucket_shift;
+		}
+		self.bucket_mask = self.bucket_size - 1;
 		return self;
 	}
 
+	// creates a new instance of a deque
+	template<typename T>
+	inline static Deque<T>
+	deque_new()
+	{
+		return deque_with_allocator<T>(allocator_top());
+	}
+
 	// frees the given deque instance
 	template<typename T>
 	inline static void
@@ -136,7 +202,7 @@ namespace mn
 	inline static Deque_Index
 	deque_index_inc(const Deque<T>& self, Deque_Index index)
 	{
-		if (index.element_index + 1 >= self.bucket_size)
+		if (index.element_index == self.bucket_mask)
 		{
 			index.element_index = 0;
 			++index.bucket_index;
@@ -164,11 +230,11 @@ namespace mn
 
 	template<typename T>
 	inline static Deque_Index
-	deque_index_dec(Deque<T>& self, Deque_Index index)
+	deque_index_dec(const Deque<T>& self, Deque_Index index)
 	{
 		if (index.element_index == 0)
 		{
-			index.element_index = self.bucket_size - 1;
+			index.element_index = self.bucket_mask;
 			--index.bucket_index;
 			return index;
 		}
@@ -179,11 +245,12 @@ namespace mn
 		}
 	}
 
+	// makes sure the bucket of the back index is allocated, all the buckets before the back index are allocated
 	template<typename T>
 	inline static void
 	deque_grow_back(Deque<T>& self)
 	{
-		if(self.cap > self.count && self.back.bucket_index < self.bucket_count && deque_index_can_inc(self, self.back))
+		if (self.back.bucket_index < self.bucket_count)
 			return;
 
 		T* bucket = (T*)alloc_from(self.allocator, sizeof(T) * self.bucket_size, alignof(T)).ptr;
@@ -230,11 +297,41 @@ namespace mn
 		return p;
 	}
 
+	// pushes the given array of values to the back of the deque, the values are copied with one memcpy per bucket
+	template<typename T>
+	inline static void
+	deque_push_back_n(Deque<T>& self, const T* ptr, size_t count)
+	{
+		while (count > 0)
+		{
+			deque_grow_back(self);
+			auto n = self.bucket_size - self.back.element_index;
+			if (n > count)
+				n = count;
+			::memcpy(self.buckets[self.back.bucket_index] + self.back.element_index, ptr, n * sizeof(T));
+
+			auto position = (self.back.bucket_index << self.bucket_shift) + self.back.element_index + n;
+			self.back = Deque_Index{ position >> self.bucket_shift, position & self.bucket_mask };
+			self.count += n;
+			ptr += n;
+			count -= n;
+		}
+	}
+
+	// pushes the given buf of values to the back of the deque
+	template<typename T>
+	inline static void
+	deque_push_back_n(Deque<T>& self, const Buf<T>& values)
+	{
+		deque_push_back_n(self, values.ptr, values.count);
+	}
+
+	// makes sure the slot before the front index is allocated by adding a bucket at the front if needed
 	template<typename T>
 	inline static void
 	deque_grow_front(Deque<T>& self)
 	{
-		if (self.cap > self.count && deque_index_can_dec(self, self.front))
+		if (deque_index_can_dec(self, self.front))
 			return;
 
 		T* bucket = (T*)alloc_from(self.allocator, sizeof(T) * self.bucket_size, alignof(T)).ptr;
@@ -262,7 +359,6 @@ namespace mn
 
 		++self.front.bucket_index;
 		++self.back.bucket_index;
-		deque_grow_back(self);
 	}
 
 	// pushes the given value to the front of the deque
@@ -288,6 +384,41 @@ namespace mn
 		return p;
 	}
 
+	// pushes the given array of values to the front of the deque keeping their order, so the first value becomes the
+	// front of the deque, the values are copied with one memcpy per bucket
+	template<typename T>
+	inline static void
+	deque_push_front_n(Deque<T>& self, const T* ptr, size_t count)
+	{
+		while (count > 0)
+		{
+			deque_grow_front(self);
+			// the free slots before the front in its bucket, or the whole bucket which was just added
+			auto n = self.front.element_index > 0 ? self.front.element_index : self.bucket_size;
+			if (n > count)
+				n = count;
+
+			auto position = (self.front.bucket_index << self.bucket_shift) + self.front.element_index - n;
+			self.front = Deque_Index{ position >> self.bucket_shift, position & self.bucket_mask };
+			::memcpy(self.buckets[self.front.bucket_index] + self.front.element_index, ptr + count - n, n * sizeof(T));
+			self.count += n;
+			count -= n;
+		}
+	}
+
+	// moves the front and back to the start of the middle bucket once the deque is empty, so the pushes to the back
+	// reuse the buckets after it and the pushes to the front reuse the buckets before it
+	template<typename T>
+	inline static void
+	_deque_reset_if_empty(Deque<T>& self)
+	{
+		if (self.count == 0)
+		{
+			self.front = { self.bucket_count / 2, 0 };
+			self.back = self.front;
+		}
+	}
+
 	// removes an element off the back of the given deque
 	template<typename T>
 	inline static void
@@ -297,6 +428,7 @@ namespace mn
 			return;
 		self.back = deque_index_dec(self, self.back);
 		--self.count;
+		_deque_reset_if_empty(self);
 	}
 
 	// removes an element off the front of the given deque
@@ -308,6 +440,125 @@ namespace mn
 			return;
 		self.front = deque_index_inc(self, self.front);
 		--self.count;
+		_deque_reset_if_empty(self);
+	}
+
+	// pops up to the given count of values off the front of the deque and copies them into the given array (if it's
+	// not null) with one memcpy per bucket, and returns the count of popped values
+	template<typename T>
+	inline static size_t
+	deque_pop_front_n(Deque<T>& self, T* ptr, size_t count)
+	{
+		if (count > self.count)
+			count = self.count;
+
+		auto position = (self.front.bucket_index << self.bucket_shift) + self.front.element_index;
+		if (ptr)
+		{
+			for (size_t i = 0; i < count;)
+			{
+				auto element_index = (position + i) & self.bucket_mask;
+				auto n = self.bucket_size - element_index;
+				if (n > count - i)
+					n = count - i;
+				::memcpy(ptr + i, self.buckets[(position + i) >> self.bucket_shift] + element_index, n * sizeof(T));
+				i += n;
+			}
+		}
+
+		position += count;
+		self.front = Deque_Index{ position >> self.bucket_shift, position & self.bucket_mask };
+		self.count -= count;
+		_deque_reset_if_empty(self);
+		return count;
+	}
+
+	// pops up to the given count of values off the back of the deque and copies them into the given array (if it's
+	// not null) keeping their order with one memcpy per bucket, and returns the count of popped values
+	template<typename T>
+	inline static size_t
+	deque_pop_back_n(Deque<T>& self, T* ptr, size_t count)
+	{
+		if (count > self.count)
+			count = self.count;
+
+		auto position = (self.back.bucket_index << self.bucket_shift) + self.back.element_index - count;
+		if (ptr)
+		{
+			for (size_t i = 0; i < count;)
+			{
+				auto element_index = (position + i) & self.bucket_mask;
+				auto n = self.bucket_size - element_index;
+				if (n > count - i)
+					n = count - i;
+				::memcpy(ptr + i, self.buckets[(position + i) >> self.bucket_shift] + element_index, n * sizeof(T));
+				i += n;
+			}
+		}
+
+		self.back = Deque_Index{ position >> self.bucket_shift, position & self.bucket_mask };
+		self.count -= count;
+		_deque_reset_if_empty(self);
+		return count;
+	}
+
+	// returns the contiguous segment which starts at the given element index and ends at the end of its bucket or the
+	// end of the deque
+	template<typename T>
+	inline static Deque_Segment<T>
+	deque_segment(Deque<T>& self, size_t ix)
+	{
+		mn_assert(ix < self.count);
+		auto position = (self.front.bucket_index << self.bucket_shift) + self.front.element_index + ix;
+		auto element_index = position & self.bucket_mask;
+		auto count = self.bucket_size - element_index;
+		if (count > self.count - ix)
+			count = self.count - ix;
+		return Deque_Segment<T>{ self.buckets[position >> self.bucket_shift] + element_index, count };
+	}
+
+	// returns the contiguous segment which starts at the given element index and ends at the end of its bucket or the
+	// end of the deque
+	template<typename T>
+	inline static Deque_Segment<const T>
+	deque_segment(const Deque<T>& self, size_t ix)
+	{
+		mn_assert(ix < self.count);
+		auto position = (self.front.bucket_index << self.bucket_shift) + self.front.element_index + ix;
+		auto element_index = position & self.bucket_mask;
+		auto count = self.bucket_size - element_index;
+		if (count > self.count - ix)
+			count = self.count - ix;
+		return Deque_Segment<const T>{ self.buckets[position >> self.bucket_shift] + element_index, count };
+	}
+
+	// returns a range over the contiguous segments of the deque in order, which is the fastest way to scan the deque
+	// because the inner loop over each segment is a plain array loop
+	// for (auto segment: mn::deque_segments(d))
+	//     for (auto& value: segment)
+	//         ...
+	template<typename T>
+	inline static Deque_Segments<T>
+	deque_segments(Deque<T>& self)
+	{
+		auto position = (self.front.bucket_index << self.bucket_shift) + self.front.element_index;
+		Deque_Segment_Iterator<T> first{ self.buckets, position, position + self.count, self.bucket_shift, self.bucket_mask };
+		auto last = first;
+		last.position = last.end_position;
+		return Deque_Segments<T>{ first, last };
+	}
+
+	// returns a range over the contiguous segments of the deque in order, which is the fastest way to scan the deque
+	// because the inner loop over each segment is a plain array loop
+	template<typename T>
+	inline static Deque_Segments<const T>
+	deque_segments(const Deque<T>& self)
+	{
+		auto position = (self.front.bucket_index << self.bucket_shift) + self.front.element_index;
+		Deque_Segment_Iterator<const T> first{ self.buckets, position, position + self.count, self.bucket_shift, self.bucket_mask };
+		auto last = first;
+		last.position = last.end_position;
+		return Deque_Segments<const T>{ first, last };
 	}
 
 	// returns a reference to the front of the given deque
@@ -349,8 +600,9 @@ namespace mn
 	deque_clone(const Deque<T>& other, Allocator allocator = allocator_top())
 	{
 		Deque<T> res = deque_with_allocator<T>(allocator);
-		for (size_t i = 0; i < other.count; ++i)
-			deque_push_back(res, clone(other[i]));
+		for (auto segment: deque_segments(other))
+			for (const auto& value: segment)
+				deque_push_back(res, clone(value));
 		return res;
 	}
 
@@ -362,4 +614,4 @@ namespace mn
 	{
 		return deque_clone(other);
 	}
-}
\ No newline at end of file
+}
@@ -257,6 +257,10 @@ namespace mn
 	local_worker_index();
 
 
+	// value of Fabric_Settings::scratch_retained_memory_cap which makes the workers free all the memory pages of their
+	// scratch after each job instead of retaining them for the next jobs
+	constexpr size_t FABRIC_SCRATCH_RETAIN_NOTHING = SIZE_MAX;
+
 	// fabric construction settings, which is used to customize fabric behavior on creation
 	struct Fabric_Settings
 	{
@@ -278,9 +282,15 @@ namespace mn
 		// will use to start evicting these workers if the blocking_workers_count >= workers_count * blocking_workers_threshold
 		// default: 0.5f
 		float blocking_workers_threshold;
-		// function which will be executed after each worker finishes executing a job
+		// each job runs in a scratch scope of the worker's tmp allocator (memory::tmp()), a checkpoint is taken before
+		// the job starts and restored after it finishes, the memory pages which the job grew into are retained by the
+		// worker for the next jobs up to this cap (in bytes) and anything above it is freed, 0 means the default cap and
+		// FABRIC_SCRATCH_RETAIN_NOTHING turns the retention off
+		// default: 4MB
+		size_t scratch_retained_memory_cap;
+		// function which will be executed after each worker finishes executing a job, it runs in its own scratch scope
 		Task<void()> after_each_job;
-		// function which will be executed when a new worker is started
+		// function which will be executed when a new worker is started, it runs in its own scratch scope
 		Task<void()> on_worker_start;
 	};
 
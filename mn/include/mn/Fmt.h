@@ -7,7 +7,10 @@
 
 #include "mn/Str.h"
 #include "mn/Buf.h"
+#include "mn/Small_Buf.h"
+#include "mn/Small_Str.h"
 #include "mn/Map.h"
+#include "mn/Ordered_Map.h"
 #include "mn/File.h"
 #include "mn/Result.h"
 
@@ -26,6 +29,19 @@ namespace fmt
 		}
 	};
 
+	template<>
+	struct formatter<mn::Small_Str> {
+		template <typename ParseContext>
+		constexpr auto parse(ParseContext &ctx) { return ctx.begin(); }
+
+		template <typename FormatContext>
+		auto format(const mn::Small_Str &str, FormatContext &ctx) {
+			if (str.count == 0)
+				return ctx.out();
+			return format_to(ctx.out(), "{}", std::string_view{mn::small_str_ptr(str), str.count});
+		}
+	};
+
 	template<typename T>
 	struct formatter<mn::Buf<T>> {
 		template <typename ParseContext>
@@ -45,6 +61,25 @@ namespace fmt
 		}
 	};
 
+	template<typename T, size_t N>
+	struct formatter<mn::Small_Buf<T, N>> {
+		template <typename ParseContext>
+		constexpr auto parse(ParseContext &ctx) { return ctx.begin(); }
+
+		template <typename FormatContext>
+		auto format(const mn::Small_Buf<T, N> &buf, FormatContext &ctx) {
+			format_to(ctx.out(), "[{}]{{", buf.count);
+			for(size_t i = 0; i < buf.count; ++i)
+			{
+				if(i != 0)
+					format_to(ctx.out(), ", ");
+				format_to(ctx.out(), "{}: {}", i, buf[i]);
+			}
+			format_to(ctx.out(), " }}");
+			return ctx.out();
+		}
+	};
+
 	template<typename T, typename THash>
 	struct formatter<mn::Set<T, THash>> {
 		template <typename ParseContext>
@@ -87,6 +122,27 @@ namespace fmt
 		}
 	};
 
+	template<typename TKey, typename TValue>
+	struct formatter<mn::Ordered_Map<TKey, TValue>> {
+		template <typename ParseContext>
+		constexpr auto parse(ParseContext &ctx) { return ctx.begin(); }
+
+		template <typename FormatContext>
+		auto format(const mn::Ordered_Map<TKey, TValue> &map, FormatContext &ctx) {
+			format_to(ctx.out(), "[{}]{{ ", map.count);
+			size_t i = 0;
+			for(const auto& [key, value]: map)
+			{
+				if(i != 0)
+					format_to(ctx.out(), ", ");
+				format_to(ctx.out(), "{}: {}", key, value);
+				++i;
+			}
+			format_to(ctx.out(), " }}");
+			return ctx.out();
+		}
+	};
+
 	template<>
 	struct formatter<mn::Err>
 	{
@@ -0,0 +1,437 @@
+#pragma once
+
+#include "mn/Base.h"
+#include "mn/Memory.h"
+#include "mn/Buf.h"
+#include "mn/Assert.h"
+
+namespace mn
+{
+	// the default compare functor of the heap which uses operator<, it makes the heap a min heap
+	template<typename T>
+	struct Heap_Less
+	{
+		inline bool
+		operator()(const T& a, const T& b) const
+		{
+			return a < b;
+		}
+	};
+
+	// a handle to a value in the heap, it remains valid until the value is popped or removed from the heap
+	struct Heap_Handle
+	{
+		size_t id;
+	};
+
+	// a priority queue implemented as an implicit d-ary heap, the value at the top is the one which the compare
+	// functor orders first (the smallest value by default), values pushed with heap_push_handle get a handle which
+	// can be used to update or remove them later (e.g. rescheduling a timer), the handles are stored in a separate
+	// array which is only allocated once the first handle is requested so heaps which don't use them (e.g. top-k
+	// queries) only move their values around, the ARITY is the count of children of each node, a higher arity makes
+	// the heap shallower and puts the children of a node in the same cache line at the cost of more compares per
+	// level, use Heap4 for the 4-ary variant
+	template<typename T, typename TCompare = Heap_Less<T>, size_t ARITY = 2>
+	struct Heap
+	{
+		static_assert(ARITY >= 2, "heap arity should be at least 2");
+
+		// marks the end of the free handles list, and the values which were pushed without a handle
+		static constexpr size_t NO_HANDLE = ~size_t(0);
+
+		// the values ordered as a heap
+		Buf<T> values;
+		// handles[i] is the handle id of values[i], it's empty until the first handle is requested
+		Buf<size_t> handles;
+		// positions[id] is the index of the value of the given handle id, for free handles it's the next free handle id
+		Buf<size_t> positions;
+		// the first free handle id which will be reused by the next push
+		size_t free_handle;
+		// whether the handles array is maintained
+		bool has_handles;
+	};
+
+	// a 4-ary heap which is faster than the binary heap for large heaps
+	template<typename T, typename TCompare = Heap_Less<T>>
+	using Heap4 = Heap<T, TCompare, 4>;
+
+	template<typename T, typename TCompare, size_t ARITY>
+	inline static void
+	_heap_place(Heap<T, TCompare, ARITY>& self, size_t index, const T& value, size_t handle)
+	{
+		self.values.ptr[index] = value;
+		if (self.has_handles)
+		{
+			self.handles.ptr[index] = handle;
+			if (handle != Heap<T, TCompare, ARITY>::NO_HANDLE)
+				self.positions.ptr[handle] = index;
+		}
+	}
+
+	template<typename T, typename TCompare, size_t ARITY>
+	inline static void
+	_heap_move(Heap<T, TCompare, ARITY>& self, size_t to, size_t from)
+	{
+		_heap_place(self, to, self.values.ptr[from], self.has_handles ? self.handles.ptr[from] : Heap<T, TCompare, ARITY>::NO_HANDLE);
+	}
+
+	// moves the given value up starting from the given index until its parent is ordered before it, the moved over
+	// values are shifted down instead of swapped which halves the writes
+	template<typename T, typename TCompare, size_t ARITY>
+	inline static void
+	_heap_sift_up(Heap<T, TCompare, ARITY>& self, size_t index, T value, size_t handle)
+	{
+		TCompare compare{};
+		while (index > 0)
+		{
+			size_t parent = (index - 1) / ARITY;
+			if (compare(value, self.values.ptr[parent]) == false)
+				break;
+			_heap_move(self, index, parent);
+			index = parent;
+		}
+		_heap_place(self, index, value, handle);
+	}
+
+	// returns the index of the child which is ordered first among the children of the given index, or the count of
+	// values if it has no children
+	template<typename T, typename TCompare, size_t ARITY>
+	inline static size_t
+	_heap_best_child(const Heap<T, TCompare, ARITY>& self, size_t index)
+	{
+		TCompare compare{};
+		size_t count = self.values.count;
+		size_t first_child = index * ARITY + 1;
+		if (first_child >= count)
+			return count;
+
+		size_t last_child = first_child + ARITY;
+		if (last_child > count)
+			last_child = count;
+
+		size_t best = first_child;
+		for (size_t child = first_child + 1; child < last_child; ++child)
+			if (compare(self.values.ptr[child], self.values.ptr[best]))
+				best = child;
+		return best;
+	}
+
+	// moves the given value down starting from the given index until it's ordered before all of its children
+	template<typename T, typename TCompare, size_t ARITY>
+	inline static void
+	_heap_sift_down(Heap<T, TCompare, ARITY>& self, size_t index, T value, size_t handle)
+	{
+		TCompare compare{};
+		while (true)
+		{
+			size_t best = _heap_best_child(self, index);
+			if (best == self.values.count || compare(self.values.ptr[best], value) == false)
+				break;
+			_heap_move(self, index, best);
+			index = best;
+		}
+		_heap_place(self, index, value, handle);
+	}
+
+	// fills the hole at the given index with the given value which usually comes from the bottom of the heap (e.g. the
+	// last value after a pop), so instead of comparing it at each level it moves the hole all the way down along the
+	// best children then sifts the value up from there which saves about half of the compares
+	template<typename T, typename TCompare, size_t ARITY>
+	inline static void
+	_heap_fill_hole(Heap<T, TCompare, ARITY>& self, size_t index, T value, size_t handle)
+	{
+		while (true)
+		{
+			size_t best = _heap_best_child(self, index);
+			if (best == self.values.count)
+				break;
+			_heap_move(self, index, best);
+			index = best;
+		}
+		_heap_sift_up(self, index, value, handle);
+	}
+
+	template<typename T, typename TCompare, size_t ARITY>
+	inline static size_t
+	_heap_handle_new(Heap<T, TCompare, ARITY>& self)
+	{
+		// the values which were pushed before the first handle don't have handles
+		if (self.has_handles == false)
+		{
+			buf_resize(self.handles, self.values.count);
+			buf_fill(self.handles, Heap<T, TCompare, ARITY>::NO_HANDLE);
+			self.has_handles = true;
+		}
+
+		if (self.free_handle != Heap<T, TCompare, ARITY>::NO_HANDLE)
+		{
+			size_t res = self.free_handle;
+			self.free_handle = self.positions.ptr[res];
+			return res;
+		}
+
+		size_t res = self.positions.count;
+		buf_push(self.positions, size_t(0));
+		return res;
+	}
+
+	// pushes the given value with the given handle into the heap
+	template<typename T, typename TCompare, size_t ARITY>
+	inline static void
+	_heap_push(Heap<T, TCompare, ARITY>& self, const T& value, size_t handle)
+	{
+		buf_push(self.values, value);
+		if (self.has_handles)
+			buf_push(self.handles, handle);
+		_heap_sift_up(self, self.values.count - 1, value, handle);
+	}
+
+	// removes the value at the given index by moving the last value into its place, and returns the removed value
+	template<typename T, typename TCompare, size_t ARITY>
+	inline static T
+	_heap_remove_at(Heap<T, TCompare, ARITY>& self, size_t index)
+	{
+		T res = self.values.ptr[index];
+		size_t last_index = --self.values.count;
+		T last = self.values.ptr[last_index];
+		size_t last_handle = Heap<T, TCompare, ARITY>::NO_HANDLE;
+		if (self.has_handles)
+		{
+			size_t handle = self.handles.ptr[index];
+			if (handle != Heap<T, TCompare, ARITY>::NO_HANDLE)
+			{
+				self.positions.ptr[handle] = self.free_handle;
+				self.free_handle = handle;
+			}
+			last_handle = self.handles.ptr[last_index];
+			--self.handles.count;
+		}
+
+		if (index == last_index)
+			return res;
+
+		if (index > 0 && TCompare{}(last, self.values.ptr[(index - 1) / ARITY]))
+			_heap_sift_up(self, index, last, last_handle);
+		else
+			_heap_fill_hole(self, index, last, last_handle);
+		return res;
+	}
+
+	// creates a new heap with the given allocator
+	template<typename T, typename TCompare = Heap_Less<T>, size_t ARITY = 2>
+	inline static Heap<T, TCompare, ARITY>
+	heap_with_allocator(Allocator allocator)
+	{
+		Heap<T, TCompare, ARITY> self{};
+		self.values = buf_with_allocator<T>(allocator);
+		self.handles = buf_with_allocator<size_t>(allocator);
+		self.positions = buf_with_allocator<size_t>(allocator);
+		self.free_handle = Heap<T, TCompare, ARITY>::NO_HANDLE;
+		self.has_handles = false;
+		return self;
+	}
+
+	// creates a new heap
+	template<typename T, typename TCompare = Heap_Less<T>, size_t ARITY = 2>
+	inline static Heap<T, TCompare, ARITY>
+	heap_new()
+	{
+		return heap_with_allocator<T, TCompare, ARITY>(allocator_top());
+	}
+
+	// creates a new 4-ary heap with the given allocator
+	template<typename T, typename TCompare = Heap_Less<T>>
+	inline static Heap4<T, TCompare>
+	heap4_with_allocator(Allocator allocator)
+	{
+		return heap_with_allocator<T, TCompare, 4>(allocator);
+	}
+
+	// creates a new 4-ary heap
+	template<typename T, typename TCompare = Heap_Less<T>>
+	inline static Heap4<T, TCompare>
+	heap4_new()
+	{
+		return heap_with_allocator<T, TCompare, 4>(allocator_top());
+	}
+
+	// creates a new heap from the given values in linear time without handles, the values are copied so the given
+	// values are left as is
+	template<typename T, typename TCompare = Heap_Less<T>, size_t ARITY = 2>
+	inline static Heap<T, TCompare, ARITY>
+	heap_from_buf(const T* values, size_t count, Allocator allocator = allocator_top())
+	{
+		auto self = heap_with_allocator<T, TCompare, ARITY>(allocator);
+		if (count == 0)
+			return self;
+
+		buf_resize(self.values, count);
+		::memcpy(self.values.ptr, values, count * sizeof(T));
+
+		// floyd's heap construction, it sifts down each parent starting from the last one
+		if (count > 1)
+			for (size_t i = (count - 2) / ARITY + 1; i > 0; --i)
+				_heap_sift_down(self, i - 1, self.values.ptr[i - 1], Heap<T, TCompare, ARITY>::NO_HANDLE);
+		return self;
+	}
+
+	// creates a new heap from the given buf in linear time without handles, the values are copied so the given buf is
+	// left as is
+	template<typename T, typename TCompare = Heap_Less<T>, size_t ARITY = 2>
+	inline static Heap<T, TCompare, ARITY>
+	heap_from_buf(const Buf<T>& values, Allocator allocator = allocator_top())
+	{
+		return heap_from_buf<T, TCompare, ARITY>(values.ptr, values.count, allocator);
+	}
+
+	// frees the given heap, note this doesn't free any complex data structure stored in it
+	template<typename T, typename TCompare, size_t ARITY>
+	inline static void
+	heap_free(Heap<T, TCompare, ARITY>& self)
+	{
+		buf_free(self.values);
+		buf_free(self.handles);
+		buf_free(self.positions);
+		self.free_handle = Heap<T, TCompare, ARITY>::NO_HANDLE;
+		self.has_handles = false;
+	}
+
+	// destruct overload for heap, it calls destruct on each value then frees the heap
+	template<typename T, typename TCompare, size_t ARITY>
+	inline static void
+	destruct(Heap<T, TCompare, ARITY>& self)
+	{
+		for (size_t i = 0; i < self.values.count; ++i)
+			destruct(self.values.ptr[i]);
+		heap_free(self);
+	}
+
+	// clears the given heap and invalidates all of its handles, note this doesn't free any complex data structure
+	// stored in it
+	template<typename T, typename TCompare, size_t ARITY>
+	inline static void
+	heap_clear(Heap<T, TCompare, ARITY>& self)
+	{
+		buf_clear(self.values);
+		buf_clear(self.handles);
+		buf_clear(self.positions);
+		self.free_handle = Heap<T, TCompare, ARITY>::NO_HANDLE;
+	}
+
+	// ensures the heap can hold the given count of values without growing
+	template<typename T, typename TCompare, size_t ARITY>
+	inline static void
+	heap_reserve(Heap<T, TCompare, ARITY>& self, size_t count)
+	{
+		buf_reserve(self.values, count);
+		if (self.has_handles)
+			buf_reserve(self.handles, count);
+	}
+
+	// returns the count of values in the heap
+	template<typename T, typename TCompare, size_t ARITY>
+	inline static size_t
+	heap_count(const Heap<T, TCompare, ARITY>& self)
+	{
+		return self.values.count;
+	}
+
+	// returns whether the heap is empty
+	template<typename T, typename TCompare, size_t ARITY>
+	inline static bool
+	heap_empty(const Heap<T, TCompare, ARITY>& self)
+	{
+		return self.values.count == 0;
+	}
+
+	// pushes the given value into the heap without a handle
+	template<typename T, typename TCompare, size_t ARITY>
+	inline static void
+	heap_push(Heap<T, TCompare, ARITY>& self, const T& value)
+	{
+		_heap_push(self, value, Heap<T, TCompare, ARITY>::NO_HANDLE);
+	}
+
+	// pushes the given value into the heap and returns its handle
+	template<typename T, typename TCompare, size_t ARITY>
+	inline static Heap_Handle
+	heap_push_handle(Heap<T, TCompare, ARITY>& self, const T& value)
+	{
+		size_t handle = _heap_handle_new(self);
+		_heap_push(self, value, handle);
+		return Heap_Handle{handle};
+	}
+
+	// returns the value at the top of the heap (the smallest value by default)
+	template<typename T, typename TCompare, size_t ARITY>
+	inline static const T&
+	heap_top(const Heap<T, TCompare, ARITY>& self)
+	{
+		mn_assert(self.values.count > 0);
+		return self.values.ptr[0];
+	}
+
+	// returns the handle of the value at the top of the heap, the value should've been pushed with a handle
+	template<typename T, typename TCompare, size_t ARITY>
+	inline static Heap_Handle
+	heap_top_handle(const Heap<T, TCompare, ARITY>& self)
+	{
+		mn_assert(self.values.count > 0 && self.has_handles);
+		mn_assert((self.handles.ptr[0] != Heap<T, TCompare, ARITY>::NO_HANDLE));
+		return Heap_Handle{self.handles.ptr[0]};
+	}
+
+	// removes the value at the top of the heap and returns it
+	template<typename T, typename TCompare, size_t ARITY>
+	inline static T
+	heap_pop(Heap<T, TCompare, ARITY>& self)
+	{
+		mn_assert(self.values.count > 0);
+		return _heap_remove_at(self, 0);
+	}
+
+	// returns the value of the given handle
+	template<typename T, typename TCompare, size_t ARITY>
+	inline static const T&
+	heap_get(const Heap<T, TCompare, ARITY>& self, Heap_Handle handle)
+	{
+		mn_assert(handle.id < self.positions.count);
+		return self.values[self.positions.ptr[handle.id]];
+	}
+
+	// replaces the value of the given handle with the given value which should be ordered before or equal to the old
+	// value (e.g. a smaller value in a min heap), it's cheaper than heap_update because it only moves the value up
+	template<typename T, typename TCompare, size_t ARITY>
+	inline static void
+	heap_decrease_key(Heap<T, TCompare, ARITY>& self, Heap_Handle handle, const T& value)
+	{
+		mn_assert(handle.id < self.positions.count);
+		size_t index = self.positions.ptr[handle.id];
+		mn_assert_msg(TCompare{}(self.values[index], value) == false, "new value is ordered after the old value");
+		_heap_sift_up(self, index, value, handle.id);
+	}
+
+	// replaces the value of the given handle with the given value and restores the heap order
+	template<typename T, typename TCompare, size_t ARITY>
+	inline static void
+	heap_update(Heap<T, TCompare, ARITY>& self, Heap_Handle handle, const T& value)
+	{
+		mn_assert(handle.id < self.positions.count);
+		size_t index = self.positions.ptr[handle.id];
+		if (TCompare{}(value, self.values[index]))
+			_heap_sift_up(self, index, value, handle.id);
+		else
+			_heap_sift_down(self, index, value, handle.id);
+	}
+
+	// removes the value of the given handle from the heap and returns it
+	template<typename T, typename TCompare, size_t ARITY>
+	inline static T
+	heap_remove(Heap<T, TCompare, ARITY>& self, Heap_Handle handle)
+	{
+		mn_assert(handle.id < self.positions.count);
+		size_t index = self.positions.ptr[handle.id];
+		mn_assert(index < self.values.count && self.handles.ptr[index] == handle.id);
+		return _heap_remove_at(self, index);
+	}
+}
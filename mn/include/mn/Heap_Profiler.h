@@ -0,0 +1,89 @@
+#pragma once
+
+#include "mn/Exports.h"
+#include "mn/Context.h"
+#include "mn/Stream.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace mn
+{
+	// a sampling heap profiler which is built on top of the memory profiling hooks (Memory_Profile_Interface), instead
+	// of recording every allocation it samples an allocation every N bytes on average (a poisson process over the
+	// allocated bytes), captures the sampled allocation callstack, and aggregates the samples by callstack
+	// since the common path is just a thread local counter decrement it's cheap enough to keep running in production
+	typedef struct IHeap_Profiler* Heap_Profiler;
+
+	// the default average count of allocated bytes between two samples
+	constexpr inline size_t HEAP_PROFILER_DEFAULT_SAMPLE_INTERVAL = 512ULL * 1024ULL;
+
+	// which value to report in the flamegraph collapsed profile
+	enum HEAP_PROFILE_VALUE
+	{
+		// estimated bytes which are still alive
+		HEAP_PROFILE_VALUE_INUSE_BYTES,
+		// estimated bytes allocated since the profiler was started
+		HEAP_PROFILE_VALUE_ALLOC_BYTES,
+	};
+
+	// creates a new heap profiler which samples an allocation every sample_interval bytes on average
+	MN_EXPORT Heap_Profiler
+	heap_profiler_new(size_t sample_interval = HEAP_PROFILER_DEFAULT_SAMPLE_INTERVAL);
+
+	// frees the given heap profiler, it should be stopped first
+	MN_EXPORT void
+	heap_profiler_free(Heap_Profiler self);
+
+	// destruct overload for heap profiler free
+	inline static void
+	destruct(Heap_Profiler self)
+	{
+		heap_profiler_free(self);
+	}
+
+	// installs the heap profiler as the current memory profiling hooks, the old hooks are restored on stop
+	MN_EXPORT void
+	heap_profiler_start(Heap_Profiler self);
+
+	// uninstalls the heap profiler from the memory profiling hooks and restores the old ones
+	MN_EXPORT void
+	heap_profiler_stop(Heap_Profiler self);
+
+	// returns the memory profiling hooks of the given heap profiler, which is useful in case you want to chain it with
+	// your own hooks instead of calling heap_profiler_start
+	MN_EXPORT Memory_Profile_Interface
+	heap_profiler_interface(Heap_Profiler self);
+
+	// writes the collected profile in pprof's legacy heap profile format (heap_v2) to the given stream, the frames are
+	// written as raw addresses along with the mapped libraries so that pprof can symbolize them, the counts are written
+	// unscaled and pprof un-samples them using the sample interval in the header
+	// example: pprof --http=:8080 ./my_program heap.prof
+	MN_EXPORT void
+	heap_profiler_dump_pprof(Heap_Profiler self, Stream out);
+
+	// writes the collected profile in flamegraph collapsed stack format to the given stream, each line is the
+	// semicolon separated frames addresses (root first) followed by the estimated bytes
+	MN_EXPORT void
+	heap_profiler_dump_collapsed(Heap_Profiler self, Stream out, HEAP_PROFILE_VALUE value = HEAP_PROFILE_VALUE_INUSE_BYTES);
+
+	// the collected profile totals, counts and bytes are estimated (scaled up from the samples)
+	struct Heap_Profile_Summary
+	{
+		uint64_t sample_count;
+		uint64_t dropped_live_samples;
+		uint64_t inuse_count;
+		uint64_t inuse_bytes;
+		uint64_t alloc_count;
+		uint64_t alloc_bytes;
+		size_t unique_callstacks;
+	};
+
+	// returns the totals of the collected profile
+	MN_EXPORT Heap_Profile_Summary
+	heap_profiler_summary(Heap_Profiler self);
+
+	// clears the collected profile
+	MN_EXPORT void
+	heap_profiler_clear(Heap_Profiler self);
+}
@@ -1,10 +1,24 @@
 #pragma once
 
+#include "mn/Exports.h"
 #include "mn/Base.h"
 #include "mn/Memory.h"
 #include "mn/Buf.h"
 #include "mn/Assert.h"
 
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define MN_HASH_SSE2 1
+	#include <emmintrin.h>
+#else
+	#define MN_HASH_SSE2 0
+#endif
+
+#if MN_COMPILER_MSVC
+	#include <intrin.h>
+#endif
+
 namespace mn
 {
 	// a key value pair, used in hash map implementation
@@ -206,6 +220,175 @@ namespace mn
 		return murmur_hash(block.ptr, block.size, seed);
 	}
 
+	// the seed which is used by hash_bytes, and in turn by the hash of strings and other byte keys, it's a fixed
+	// value by default so hashes are reproducible, call hash_seed_randomize at the start of the process (before
+	// creating any hash table) to protect against hash flooding from untrusted keys
+	MN_EXPORT extern uint64_t hash_seed_global;
+
+	// the default value of the global hash seed, it's also the fixed seed of the stable hash functions
+	constexpr uint64_t HASH_SEED_DEFAULT = 0xc70f6907UL;
+
+	// sets the global hash seed, this should be called before creating any hash table because it changes the hash of
+	// the existing keys
+	MN_EXPORT void
+	hash_seed_set(uint64_t seed);
+
+	// sets the global hash seed to a random value from the OS, this should be called before creating any hash table
+	// because it changes the hash of the existing keys
+	MN_EXPORT void
+	hash_seed_randomize();
+
+	// multiplies the given two 64 bit numbers and returns the low 64 bits in a and the high 64 bits in b
+	inline static void
+	_wyhash_mum(uint64_t* a, uint64_t* b)
+	{
+		#if defined(__SIZEOF_INT128__)
+			__uint128_t r = *a;
+			r *= *b;
+			*a = uint64_t(r);
+			*b = uint64_t(r >> 64);
+		#elif MN_COMPILER_MSVC && defined(_M_X64)
+			*a = _umul128(*a, *b, b);
+		#else
+			uint64_t ha = *a >> 32, hb = *b >> 32, la = uint32_t(*a), lb = uint32_t(*b);
+			uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32);
+			uint64_t c = t < rl;
+			uint64_t lo = t + (rm1 << 32);
+			c += lo < t;
+			uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+			*a = lo;
+			*b = hi;
+		#endif
+	}
+
+	inline static uint64_t
+	_wyhash_mix(uint64_t a, uint64_t b)
+	{
+		_wyhash_mum(&a, &b);
+		return a ^ b;
+	}
+
+	inline static uint64_t
+	_wyhash_read8(const uint8_t* p)
+	{
+		uint64_t v;
+		::memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	inline static uint64_t
+	_wyhash_read4(const uint8_t* p)
+	{
+		uint32_t v;
+		::memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	inline static uint64_t
+	_wyhash_read3(const uint8_t* p, size_t k)
+	{
+		return (uint64_t(p[0]) << 16) | (uint64_t(p[k >> 1]) << 8) | p[k - 1];
+	}
+
+	// hashes a block of bytes using wyhash (final version 4) algorithm, it's much faster than murmur hash and has
+	// better avalanche on short keys, long inputs are processed 48 bytes per iteration in 3 independent lanes
+	inline static uint64_t
+	wyhash(const void* ptr, size_t len, uint64_t seed)
+	{
+		constexpr uint64_t secret[4] = {
+			0x2d358dccaa6c78a5ULL,
+			0x8bb84b93962eacc9ULL,
+			0x4b33a62ed433d4a3ULL,
+			0x4d5a2da51de1aa47ULL,
+		};
+
+		auto p = (const uint8_t*)ptr;
+		seed ^= _wyhash_mix(seed ^ secret[0], secret[1]);
+		uint64_t a = 0, b = 0;
+		if (len <= 16)
+		{
+			if (len >= 4)
+			{
+				a = (_wyhash_read4(p) << 32) | _wyhash_read4(p + ((len >> 3) << 2));
+				b = (_wyhash_read4(p + len - 4) << 32) | _wyhash_read4(p + len - 4 - ((len >> 3) << 2));
+			}
+			else if (len > 0)
+			{
+				a = _wyhash_read3(p, len);
+			}
+		}
+		else
+		{
+			size_t i = len;
+			if (i > 48)
+			{
+				uint64_t see1 = seed, see2 = seed;
+				do
+				{
+					seed = _wyhash_mix(_wyhash_read8(p) ^ secret[1], _wyhash_read8(p + 8) ^ seed);
+					see1 = _wyhash_mix(_wyhash_read8(p + 16) ^ secret[2], _wyhash_read8(p + 24) ^ see1);
+					see2 = _wyhash_mix(_wyhash_read8(p + 32) ^ secret[3], _wyhash_read8(p + 40) ^ see2);
+					p += 48;
+					i -= 48;
+				} while (i > 48);
+				seed ^= see1 ^ see2;
+			}
+			while (i > 16)
+			{
+				seed = _wyhash_mix(_wyhash_read8(p) ^ secret[1], _wyhash_read8(p + 8) ^ seed);
+				i -= 16;
+				p += 16;
+			}
+			a = _wyhash_read8(p + i - 16);
+			b = _wyhash_read8(p + i - 8);
+		}
+		a ^= secret[1];
+		b ^= seed;
+		_wyhash_mum(&a, &b);
+		return _wyhash_mix(a ^ secret[0] ^ len, b ^ secret[1]);
+	}
+
+	// hashes a block of bytes using the default hash function with the global hash seed, this is the hash function
+	// used by strings and other byte keys
+	inline static size_t
+	hash_bytes(const void* ptr, size_t len)
+	{
+		return size_t(wyhash(ptr, len, hash_seed_global));
+	}
+
+	// hashes a block of bytes using the default hash function with the global hash seed
+	inline static size_t
+	hash_bytes(const Block& block)
+	{
+		return hash_bytes(block.ptr, block.size);
+	}
+
+	// hashes a block of bytes using the default hash function with a fixed seed, unlike hash_bytes it's not affected
+	// by hash_seed_set and hash_seed_randomize so the result is the same in every process and can be persisted
+	inline static size_t
+	hash_bytes_stable(const void* ptr, size_t len)
+	{
+		return size_t(wyhash(ptr, len, HASH_SEED_DEFAULT));
+	}
+
+	// returns the index of the shard which the given hash belongs to out of the given power of two count of shards, the
+	// index is taken from the high bits of a multiplicative mix which differs from the one used by the hash map tags,
+	// so the keys of each shard still spread well inside it
+	inline static size_t
+	hash_shard_index(size_t hash, size_t shards_count)
+	{
+		auto mixed = (uint64_t(hash) * 0xff51afd7ed558ccdULL) ^ (uint64_t(hash) >> 32);
+		return size_t(mixed >> 32) & (shards_count - 1);
+	}
+
+	// the stable hash functor, it's used by the structures which store hashes that outlive the process (like the
+	// persisted bloom and cuckoo filters), it's the same as the default hash functor for the types which don't use
+	// the global hash seed, and it's specialized to use hash_bytes_stable for the types that do (strings, uuids)
+	template<typename T>
+	struct Stable_Hash: Hash<T>
+	{
+	};
+
 	// hash specialization for float values
 	template<>
 	struct Hash<float>
@@ -262,85 +445,111 @@ namespace mn
 		}
 		else if constexpr (sizeof(size_t) == 8)
 		{
-			a ^= b;
-			a *= 0xff51afd7ed558ccd;
-			a ^= a >> 32;
-			return a;
+			return size_t(_wyhash_mix(uint64_t(a) ^ 0x2d358dccaa6c78a5ULL, uint64_t(b) ^ 0x8bb84b93962eacc9ULL));
 		}
 	}
 
 
-	// hash table slot flags
-	enum HASH_FLAGS: uint8_t { HASH_EMPTY, HASH_USED, HASH_DELETED };
-
-	// hash table slot with the index and hash
-	struct Hash_Slot
+	// hash table control byte values, a used slot stores the 7 bit tag of its hash instead which has the most
+	// significant bit cleared, so both empty and deleted slots have the most significant bit set
+	enum HASH_CONTROL: uint8_t
 	{
-		// most signficant 2 bits = HASH_FLAGS enum
-		// remaining bits = index
-		size_t index;
-		size_t hash;
+		HASH_CONTROL_EMPTY = 0x80,
+		HASH_CONTROL_DELETED = 0xFE,
 	};
 
-	// returns the flags of the given hash slot
-	inline static HASH_FLAGS
-	hash_slot_flags(Hash_Slot s)
+	// count of control bytes which are probed at the same time
+	constexpr size_t HASH_GROUP_WIDTH = 16;
+
+	// returns the index of the first set bit in the given group match mask
+	inline static size_t
+	_hash_group_mask_first(uint32_t mask)
 	{
-		if constexpr (sizeof(size_t) == 8)
-			return HASH_FLAGS((s.index & 0xC000000000000000) >> 62);
-		else if constexpr (sizeof(size_t) == 4)
-			return HASH_FLAGS((s.index & 0xC0000000) >> 30);
+		#if MN_COMPILER_MSVC
+			unsigned long index = 0;
+			_BitScanForward(&index, mask);
+			return index;
+		#else
+			return __builtin_ctz(mask);
+		#endif
 	}
 
-	// returns the index of the given hash slot
-	inline static size_t
-	hash_slot_index(Hash_Slot s)
+	// returns a mask of the control bytes in the group which start at the given pointer and are equal to the given tag
+	inline static uint32_t
+	_hash_group_match(const uint8_t* control, uint8_t tag)
 	{
-		if constexpr (sizeof(size_t) == 8)
-			return size_t(s.index & 0x3FFFFFFFFFFFFFFF);
-		else if constexpr (sizeof(size_t) == 4)
-			return size_t(s.index & 0x3FFFFFFF);
+		#if MN_HASH_SSE2
+			auto group = _mm_loadu_si128((const __m128i*)control);
+			return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(char(tag)), group)));
+		#else
+			uint32_t res = 0;
+			for (size_t i = 0; i < HASH_GROUP_WIDTH; ++i)
+				res |= uint32_t(control[i] == tag) << i;
+			return res;
+		#endif
 	}
 
-	// sets the flags of the given hash slot
-	inline static Hash_Slot
-	hash_slot_set_flags(Hash_Slot s, HASH_FLAGS f)
+	// returns a mask of the empty and deleted control bytes in the group which start at the given pointer
+	inline static uint32_t
+	_hash_group_match_empty_or_deleted(const uint8_t* control)
 	{
-		if constexpr (sizeof(size_t) == 8)
-		{
-			s.index &= ~0xC000000000000000;
-			s.index |= (size_t(f) << 62);
-		}
-		else if constexpr (sizeof(size_t) == 4)
-		{
-			s.index &= ~0xC0000000;
-			s.index |= (size_t(f) << 30);
-		}
-		return s;
+		#if MN_HASH_SSE2
+			return uint32_t(_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)control)));
+		#else
+			uint32_t res = 0;
+			for (size_t i = 0; i < HASH_GROUP_WIDTH; ++i)
+				res |= uint32_t(control[i] >> 7) << i;
+			return res;
+		#endif
 	}
 
-	// sets the index of the given hash slot
-	inline static Hash_Slot
-	hash_slot_set_index(Hash_Slot s, size_t index)
+	// returns the 7 bit tag of the given hash which is stored in the control byte, the position in the table is taken
+	// from the low bits of the hash so we take the tag from the high bits of the hash after mixing it, this way the
+	// identity hash of the integers still produces useful tags
+	inline static uint8_t
+	_hash_tag(size_t hash)
 	{
 		if constexpr (sizeof(size_t) == 8)
+			return uint8_t((uint64_t(hash) * 0x9E3779B97F4A7C15ULL) >> 57);
+		else
+			return uint8_t((uint32_t(hash) * 0x9E3779B9U) >> 25);
+	}
+
+	// sets the control byte of the given slot, the first HASH_GROUP_WIDTH - 1 control bytes are mirrored after the
+	// end of the table so that a group can be loaded starting from any slot without wrapping around
+	inline static void
+	_hash_control_set(uint8_t* control, size_t cap, size_t ix, uint8_t value)
+	{
+		control[ix] = value;
+		if (ix < HASH_GROUP_WIDTH - 1)
+			control[cap + ix] = value;
+	}
+
+	// returns the first empty or deleted slot in the probe sequence of the given hash
+	inline static size_t
+	_hash_find_free_slot(const uint8_t* control, size_t cap, size_t hash)
+	{
+		auto mask = cap - 1;
+		auto pos = hash & mask;
+		while (true)
 		{
-			s.index &= ~0x3FFFFFFFFFFFFFFF;
-			s.index |= (size_t(index) & 0x3FFFFFFFFFFFFFFF);
-		}
-		else if constexpr (sizeof(size_t) == 4)
-		{
-			s.index &= ~0x3FFFFFFF;
-			s.index |= (size_t(index) & 0x3FFFFFFF);
+			if (auto free_mask = _hash_group_match_empty_or_deleted(control + pos))
+				return (pos + _hash_group_mask_first(free_mask)) & mask;
+			pos = (pos + HASH_GROUP_WIDTH) & mask;
 		}
-		return s;
 	}
 
-	// a hash set
+	// a hash set, it's an open addressing hash table with a control byte per slot (swiss table), lookups compare the
+	// 7 bit tag of the hash against a whole group of 16 control bytes at a time (using SSE2 if it's available) and
+	// only touch the values when the tag matches, the values themselves are stored densely in insertion order
 	template<typename T, typename THash = Hash<T>>
 	struct Set
 	{
-		Buf<Hash_Slot> _slots;
+		// control byte of each slot (HASH_CONTROL_EMPTY, HASH_CONTROL_DELETED, or the tag of the used slot), followed
+		// by a mirror of the first HASH_GROUP_WIDTH - 1 control bytes
+		Buf<uint8_t> _control;
+		// index of the value of each used slot
+		Buf<size_t> _slots;
 		Buf<T> values;
 		size_t count;
 		size_t _deleted_count;
@@ -355,7 +564,8 @@ namespace mn
 	set_new()
 	{
 		Set<T, THash> self{};
-		self._slots = buf_new<Hash_Slot>();
+		self._control = buf_new<uint8_t>();
+		self._slots = buf_new<size_t>();
 		self.values = buf_new<T>();
 		return self;
 	}
@@ -366,7 +576,8 @@ namespace mn
 	set_with_allocator(Allocator allocator)
 	{
 		Set<T, THash> self{};
-		self._slots = buf_with_allocator<Hash_Slot>(allocator);
+		self._control = buf_with_allocator<uint8_t>(allocator);
+		self._slots = buf_with_allocator<size_t>(allocator);
 		self.values = buf_with_allocator<T>(allocator);
 		return self;
 	}
@@ -376,6 +587,7 @@ namespace mn
 	inline static void
 	set_free(Set<T, THash>& self)
 	{
+		buf_free(self._control);
 		buf_free(self._slots);
 		buf_free(self.values);
 		self.count = 0;
@@ -387,6 +599,7 @@ namespace mn
 	inline static void
 	destruct(Set<T, THash>& self)
 	{
+		buf_free(self._control);
 		buf_free(self._slots);
 		destruct(self.values);
 		self.count = 0;
@@ -398,7 +611,7 @@ namespace mn
 	inline static void
 	set_clear(Set<T, THash>& self)
 	{
-		buf_fill(self._slots, Hash_Slot{});
+		buf_fill(self._control, uint8_t(HASH_CONTROL_EMPTY));
 		buf_clear(self.values);
 		self.count = 0;
 		self._deleted_count = 0;
@@ -412,154 +625,47 @@ namespace mn
 		return self._slots.count;
 	}
 
-	struct _Hash_Search_Result
-	{
-		size_t hash;
-		size_t index;
-	};
-
+	// returns the slot of the given key or the capacity of the table if it doesn't exist
 	template<typename T, typename THash = Hash<T>>
-	inline static _Hash_Search_Result
-	_set_find_slot_for_insert(const Buf<Hash_Slot>& _slots, const Buf<T>& values, const T& key, size_t* external_hash)
-	{
-		_Hash_Search_Result res{};
-		if (external_hash)
-			res.hash = *external_hash;
-		else
-			res.hash = THash()(key);
-
-		auto cap = _slots.count;
-		if (cap == 0) return res;
-
-		auto index = res.hash & (cap - 1);
-		auto ix = index;
-
-		size_t first_deleted_slot_index = 0;
-		bool found_first_deleted_slot = false;
-
-		// linear probing
-		while(true)
-		{
-			auto slot = _slots[ix];
-			auto slot_hash = slot.hash;
-			auto slot_index = hash_slot_index(slot);
-			auto slot_flags = hash_slot_flags(slot);
-			switch (slot_flags)
-			{
-			// this position is not empty but if it's the same value then we return it
-			case HASH_FLAGS::HASH_USED:
-			{
-				if (slot_hash == res.hash && values[slot_index] == key)
-				{
-					res.index = ix;
-					return res;
-				}
-				break;
-			}
-			// this is an empty slot then we can use it
-			case HASH_FLAGS::HASH_EMPTY:
-			{
-				// we didn't find the key, so check the first deleted slot if we found one then
-				// reuse it
-				if (found_first_deleted_slot)
-				{
-					res.index = first_deleted_slot_index;
-				}
-				// we didn't find the key, so use the first empty slot
-				else
-				{
-					res.index = ix;
-				}
-				return res;
-				break;
-			}
-			// this is a deleted slot we'll remember it just in case we wanted to resuse it
-			case HASH_FLAGS::HASH_DELETED:
-			{
-				if (found_first_deleted_slot == false)
-				{
-					first_deleted_slot_index = ix;
-					found_first_deleted_slot = true;
-				}
-				break;
-			}
-			default: mn_unreachable(); return _Hash_Search_Result{};
-			}
-
-			// the position is not empty and the key is not the same
-			++ix;
-			ix &= (cap - 1);
-
-			// if we went full circle then we just return the cap to signal no index has been found
-			if (ix == index)
-			{
-				ix = cap;
-				break;
-			}
-		}
-
-		res.index = ix;
-		return res;
-	}
-
-	template<typename T, typename THash = Hash<T>>
-	inline static _Hash_Search_Result
-	_set_find_slot_for_lookup(const Set<T, THash>& self, const T& key)
+	inline static size_t
+	_set_find_slot(const Set<T, THash>& self, const T& key, size_t hash)
 	{
-		_Hash_Search_Result res{};
-		res.hash = THash()(key);
-
 		auto cap = self._slots.count;
-		if (cap == 0) return res;
-
-		auto index = res.hash & (cap - 1);
-		auto ix = index;
+		if (cap == 0) return cap;
 
-		// linear probing
-		while(true)
+		auto tag = _hash_tag(hash);
+		auto mask = cap - 1;
+		auto pos = hash & mask;
+		for (size_t probe = 0; probe < cap; probe += HASH_GROUP_WIDTH)
 		{
-			auto slot = self._slots[ix];
-			auto slot_hash = slot.hash;
-			auto slot_index = hash_slot_index(slot);
-			auto slot_flags = hash_slot_flags(slot);
-
-			// if the cell is empty then we didn't find the value
-			if (slot_flags == HASH_FLAGS::HASH_EMPTY)
-			{
-				ix = cap;
-				break;
-			}
-
-			// if the cell is used and it's the same value then we found it
-			if (slot_flags == HASH_FLAGS::HASH_USED &&
-				slot_hash == res.hash &&
-				self.values[slot_index] == key)
+			auto control = self._control.ptr + pos;
+			auto match_mask = _hash_group_match(control, tag);
+			while (match_mask)
 			{
-				break;
+				auto ix = (pos + _hash_group_mask_first(match_mask)) & mask;
+				if (self.values.ptr[self._slots.ptr[ix]] == key)
+					return ix;
+				match_mask &= match_mask - 1;
 			}
 
-			// the position is not used or the key is not the same
-			++ix;
-			ix &= (cap - 1);
-
-			// if we went full circle then we just return the cap to signal no index has been found
-			if (ix == index)
-			{
-				ix = cap;
+			// an empty slot in the group means that the key was never pushed further in the probe sequence
+			if (_hash_group_match(control, HASH_CONTROL_EMPTY))
 				break;
-			}
+			pos = (pos + HASH_GROUP_WIDTH) & mask;
 		}
-
-		res.index = ix;
-		return res;
+		return cap;
 	}
 
 	template<typename T, typename THash = Hash<T>>
 	inline static void
 	_set_reserve_exact(Set<T, THash>& self, size_t new_count)
 	{
-		auto new_slots = buf_with_allocator<Hash_Slot>(self._slots.allocator);
-		buf_resize_fill(new_slots, new_count, Hash_Slot{});
+		mn_assert(new_count >= HASH_GROUP_WIDTH);
+
+		auto new_control = buf_with_allocator<uint8_t>(self._control.allocator);
+		buf_resize_fill(new_control, new_count + HASH_GROUP_WIDTH - 1, uint8_t(HASH_CONTROL_EMPTY));
+		auto new_slots = buf_with_allocator<size_t>(self._slots.allocator);
+		buf_resize(new_slots, new_count);
 
 		self._deleted_count = 0;
 		// if 12/16th of table is occupied, grow
@@ -569,23 +675,18 @@ namespace mn
 		// if table is only 4/16th full, shrink
 		self._used_count_shrink_threshold = new_count >> 2;
 
-		// do a rehash
-		if (self.count != 0)
+		// do a rehash, values are dense so we iterate over them instead of the slots
+		for (size_t i = 0; i < self.count; ++i)
 		{
-			for (size_t i = 0; i < self._slots.count; ++i)
-			{
-				auto slot = self._slots[i];
-				auto flags = hash_slot_flags(slot);
-				if (flags == HASH_FLAGS::HASH_USED)
-				{
-					auto index = hash_slot_index(slot);
-					auto res = _set_find_slot_for_insert<T, THash>(new_slots, self.values, self.values[index], &slot.hash);
-					new_slots[res.index] = slot;
-				}
-			}
+			auto hash = THash()(self.values.ptr[i]);
+			auto ix = _hash_find_free_slot(new_control.ptr, new_count, hash);
+			_hash_control_set(new_control.ptr, new_count, ix, _hash_tag(hash));
+			new_slots.ptr[ix] = i;
 		}
 
+		buf_free(self._control);
 		buf_free(self._slots);
+		self._control = new_control;
 		self._slots = new_slots;
 	}
 
@@ -595,7 +696,7 @@ namespace mn
 	{
 		if (self._slots.count == 0)
 		{
-			_set_reserve_exact(self, 8);
+			_set_reserve_exact(self, HASH_GROUP_WIDTH);
 		}
 		else if (self.count + 1 > self._used_count_threshold)
 		{
@@ -643,6 +744,8 @@ namespace mn
 				}
 				++new_cap;
 			}
+			if (new_cap < HASH_GROUP_WIDTH)
+				new_cap = HASH_GROUP_WIDTH;
 			_set_reserve_exact(self, new_cap);
 		}
 	}
@@ -654,41 +757,23 @@ namespace mn
 	{
 		_set_maintain_space_complexity(self);
 
-		auto res = _set_find_slot_for_insert<T, THash>(self._slots, self.values, key, nullptr);
-
-		auto& slot = self._slots[res.index];
-		auto flags = hash_slot_flags(slot);
-		switch(flags)
-		{
-		case HASH_FLAGS::HASH_EMPTY:
+		auto hash = THash()(key);
+		auto cap = self._slots.count;
+		auto ix = _set_find_slot(self, key, hash);
+		if (ix != cap)
 		{
-			slot = hash_slot_set_flags(slot, HASH_FLAGS::HASH_USED);
-			slot = hash_slot_set_index(slot, self.count);
-			slot.hash = res.hash;
-			++self.count;
-			return buf_push(self.values, key);
+			auto index = self._slots.ptr[ix];
+			self.values.ptr[index] = key;
+			return self.values.ptr + index;
 		}
-		case HASH_FLAGS::HASH_DELETED:
-		{
-			slot = hash_slot_set_flags(slot, HASH_FLAGS::HASH_USED);
-			slot = hash_slot_set_index(slot, self.count);
-			slot.hash = res.hash;
-			++self.count;
+
+		ix = _hash_find_free_slot(self._control.ptr, cap, hash);
+		if (self._control.ptr[ix] == HASH_CONTROL_DELETED)
 			--self._deleted_count;
-			return buf_push(self.values, key);
-		}
-		case HASH_FLAGS::HASH_USED:
-		{
-			auto index = hash_slot_index(slot);
-			self.values[index] = key;
-			return &self.values[index];
-		}
-		default:
-		{
-			mn_unreachable();
-			return nullptr;
-		}
-		}
+		_hash_control_set(self._control.ptr, cap, ix, _hash_tag(hash));
+		self._slots.ptr[ix] = self.count;
+		++self.count;
+		return buf_push(self.values, key);
 	}
 
 	// searches for the given key in the hash set and returns an iterator to it, if the key doesn't exist it will return
@@ -697,12 +782,10 @@ namespace mn
 	inline static const T*
 	set_lookup(const Set<T, THash>& self, const T& key)
 	{
-		auto res = _set_find_slot_for_lookup(self, key);
-		if (res.index == self._slots.count)
+		auto ix = _set_find_slot(self, key, THash()(key));
+		if (ix == self._slots.count)
 			return nullptr;
-		auto& slot = self._slots[res.index];
-		auto index = hash_slot_index(slot);
-		return (const T*)(self.values.ptr + index);
+		return (const T*)(self.values.ptr + self._slots.ptr[ix]);
 	}
 
 	// remove the given value from the hash set, and returns whether it found and removed the element
@@ -710,30 +793,27 @@ namespace mn
 	inline static bool
 	set_remove(Set<T, THash>& self, const T& key)
 	{
-		auto res = _set_find_slot_for_lookup(self, key);
-		if (res.index == self._slots.count)
+		auto cap = self._slots.count;
+		auto ix = _set_find_slot(self, key, THash()(key));
+		if (ix == cap)
 			return false;
-		auto& slot = self._slots[res.index];
-		auto index = hash_slot_index(slot);
-		slot = hash_slot_set_flags(slot, HASH_FLAGS::HASH_DELETED);
+		auto index = self._slots.ptr[ix];
+		_hash_control_set(self._control.ptr, cap, ix, HASH_CONTROL_DELETED);
 
-		if (index == self.count - 1)
-		{
-			buf_remove(self.values, index);
-		}
-		else
+		if (index != self.count - 1)
 		{
 			// fixup the index of the last element after swap
-			auto last_res = _set_find_slot_for_lookup(self, self.values[self.count - 1]);
-			self._slots[last_res.index] = hash_slot_set_index(self._slots[last_res.index], index);
-			buf_remove(self.values, index);
+			const auto& last = self.values.ptr[self.count - 1];
+			auto last_ix = _set_find_slot(self, last, THash()(last));
+			self._slots.ptr[last_ix] = index;
 		}
+		buf_remove(self.values, index);
 
 		--self.count;
 		++self._deleted_count;
 
 		// rehash because of size is too low
-		if (self.count < self._used_count_shrink_threshold && self._slots.count > 8)
+		if (self.count < self._used_count_shrink_threshold && self._slots.count > HASH_GROUP_WIDTH)
 		{
 			_set_reserve_exact(self, self._slots.count >> 1);
 			buf_shrink_to_fit(self.values);
@@ -752,6 +832,7 @@ namespace mn
 	set_clone(const Set<T, THash>& other, Allocator allocator = allocator_top())
 	{
 		Set<T, THash> self = other;
+		self._control = buf_memcpy_clone(other._control, allocator);
 		self._slots = buf_memcpy_clone(other._slots, allocator);
 		self.values = buf_clone(other.values, allocator);
 		return self;
@@ -764,6 +845,7 @@ namespace mn
 	set_memcpy_clone(const Set<T, THash>& other, Allocator allocator = allocator_top())
 	{
 		Set<T, THash> self = other;
+		self._control = buf_memcpy_clone(other._control, allocator);
 		self._slots = buf_memcpy_clone(other._slots, allocator);
 		self.values = buf_memcpy_clone(other.values, allocator);
 		return self;
@@ -6,6 +6,7 @@
 #include "mn/memory/Stack.h"
 #include "mn/memory/Arena.h"
 #include "mn/memory/Buddy.h"
+#include "mn/memory/Concurrent_Buddy.h"
 #include "mn/Context.h"
 
 #include <stdint.h>
@@ -36,6 +37,17 @@ namespace mn
 		self->free(block);
 	}
 
+	// allocates from the given allocator the given size of memory and returns a pointer into it which is aligned to the
+	// given alignment (a power of two), not all the allocators respect the alignment (clib and the leak detectors
+	// don't) so it over allocates and aligns the pointer itself, the whole allocated block is written into memory and
+	// it's the one which should be freed using free_from
+	inline static void*
+	alloc_aligned_from(Allocator self, size_t size, size_t alignment, Block& memory)
+	{
+		memory = alloc_from(self, size + alignment - 1, uint8_t(alignment > UINT8_MAX ? alignof(max_align_t) : alignment));
+		return (void*)((uintptr_t(memory.ptr) + alignment - 1) & ~uintptr_t(alignment - 1));
+	}
+
 
 	// allocates from the given allocator a single instance of the given type
 	template<typename T>
@@ -126,6 +138,42 @@ namespace mn
 	}
 
 
+	// a general destruct function overload which calls the destructor of the given value
+	template<typename T>
+	inline static void
+	destruct(T& value)
+	{
+		value.~T();
+	}
+
+	// default no-op destruct functions for the builtin types
+	inline static void destruct(char&) {}
+	inline static void destruct(uint8_t&) {}
+	inline static void destruct(uint16_t&) {}
+	inline static void destruct(uint32_t&) {}
+	inline static void destruct(uint64_t&) {}
+	inline static void destruct(int8_t&) {}
+	inline static void destruct(int16_t&) {}
+	inline static void destruct(int32_t&) {}
+	inline static void destruct(int64_t&) {}
+	inline static void destruct(float&) {}
+	inline static void destruct(double&) {}
+	inline static void destruct(long double&) {}
+
+	// allocates a single instance of the given type from the given arena and calls its constructor with the given
+	// arguments, it also registers the destruct function of the instance with the arena so that it will be destructed
+	// when the arena is cleared, freed, or restored to a checkpoint before this call, this way you can bump allocate
+	// objects which own resources (Str, Buf, Mutex, etc...) without walking them manually before clearing the arena
+	template<typename T, typename ... TArgs>
+	inline static T*
+	arena_construct(memory::Arena* self, TArgs&& ... args)
+	{
+		T* res = alloc_from<T>(self);
+		::new (res) T(std::forward<TArgs>(args)...);
+		self->destructor_register([](void* ptr) { destruct(*(T*)ptr); }, res);
+		return res;
+	}
+
 	// allocates a single instance of the given type and zeros the memory
 	template<typename T>
 	inline static T*
@@ -170,6 +218,14 @@ namespace mn
 		return alloc_construct<memory::Buddy>(heap_size, meta);
 	}
 
+	// creates a new thread safe buddy allocator with the given heap size and meta allocator
+	// read more about concurrent buddy allocator in Concurrent_Buddy.h
+	inline static memory::Concurrent_Buddy*
+	allocator_concurrent_buddy_new(size_t heap_size = 1ULL * 1024ULL * 1024ULL, Allocator meta = memory::virtual_mem())
+	{
+		return alloc_construct<memory::Concurrent_Buddy>(heap_size, meta);
+	}
+
 	// frees the given allocator
 	inline static void
 	allocator_free(Allocator self)
@@ -2,8 +2,13 @@
 
 #include "mn/Memory_Stream.h"
 #include "mn/Buf.h"
+#include "mn/Small_Buf.h"
+#include "mn/Small_Str.h"
 #include "mn/Str.h"
 #include "mn/Map.h"
+#include "mn/Ordered_Map.h"
+#include "mn/Bloom_Filter.h"
+#include "mn/Cuckoo_Filter.h"
 #include "mn/Defer.h"
 #include "mn/Block_Stream.h"
 #include "mn/Fmt.h"
@@ -373,6 +378,12 @@ namespace mn
 		}
 	}
 
+	inline static Err
+	msgpack(Msgpack_Writer& self, const Small_Str& v)
+	{
+		return msgpack(self, small_str_view(v));
+	}
+
 	inline static Err
 	msgpack(Msgpack_Writer& self, const char* v)
 	{
@@ -455,6 +466,42 @@ namespace mn
 		return {};
 	}
 
+	template<typename T, size_t N>
+	inline static Err
+	msgpack(Msgpack_Writer& self, const Small_Buf<T, N>& v)
+	{
+		if (v.count <= 15)
+		{
+			uint8_t prefix = (uint8_t)v.count;
+			prefix |= 0x90;
+			if (auto err = _msgpack_push_uint8(self, prefix)) return err;
+		}
+		else if (v.count <= UINT16_MAX)
+		{
+			uint8_t prefix = 0xdc;
+			if (auto err = _msgpack_push_uint8(self, prefix)) return err;
+			uint16_t count = (uint16_t)v.count;
+			if (auto err = _msgpack_push_uint16(self, count)) return err;
+		}
+		else if (v.count <= UINT32_MAX)
+		{
+			uint8_t prefix = 0xdd;
+			if (auto err = _msgpack_push_uint8(self, prefix)) return err;
+			uint32_t count = (uint32_t)v.count;
+			if (auto err = _msgpack_push_uint32(self, count)) return err;
+		}
+		else
+		{
+			mn_unreachable();
+			return errf("array with count larger than 32 bit is not supported");
+		}
+
+		for (const auto& a: v)
+			if (auto err = msgpack(self, a))
+				return err;
+		return {};
+	}
+
 	template<typename T, size_t N>
 	inline static Err
 	msgpack(Msgpack_Writer& self, const T (&arr)[N])
@@ -491,29 +538,28 @@ namespace mn
 		return {};
 	}
 
-	template<typename TKey, typename TValue, typename THash>
 	inline static Err
-	msgpack(Msgpack_Writer& self, const Map<TKey, TValue, THash>& v)
+	_msgpack_push_map_count(Msgpack_Writer& self, size_t count)
 	{
-		if (v.count <= 15)
+		if (count <= 15)
 		{
-			uint8_t prefix = (uint8_t)v.count;
+			uint8_t prefix = (uint8_t)count;
 			prefix |= 0x80;
 			if (auto err = _msgpack_push_uint8(self, prefix)) return err;
 		}
-		else if (v.count <= UINT16_MAX)
+		else if (count <= UINT16_MAX)
 		{
 			uint8_t prefix = 0xde;
 			if (auto err = _msgpack_push_uint8(self, prefix)) return err;
-			uint16_t count = (uint16_t)v.count;
-			if (auto err = _msgpack_push_uint16(self, count)) return err;
+			uint16_t count16 = (uint16_t)count;
+			if (auto err = _msgpack_push_uint16(self, count16)) return err;
 		}
-		else if (v.count <= UINT32_MAX)
+		else if (count <= UINT32_MAX)
 		{
 			uint8_t prefix = 0xdf;
 			if (auto err = _msgpack_push_uint8(self, prefix)) return err;
-			uint32_t count = (uint32_t)v.count;
-			if (auto err = _msgpack_push_uint32(self, count)) return err;
+			uint32_t count32 = (uint32_t)count;
+			if (auto err = _msgpack_push_uint32(self, count32)) return err;
 		}
 		else
 		{
@@ -521,6 +567,29 @@ namespace mn
 			return errf("map with count larger than 32 bit is not supported");
 		}
 
+		return {};
+	}
+
+	template<typename TKey, typename TValue, typename THash>
+	inline static Err
+	msgpack(Msgpack_Writer& self, const Map<TKey, TValue, THash>& v)
+	{
+		if (auto err = _msgpack_push_map_count(self, v.count)) return err;
+
+		for (const auto& a: v)
+		{
+			if (auto err = msgpack(self, a.key)) return err;
+			if (auto err = msgpack(self, a.value)) return err;
+		}
+		return {};
+	}
+
+	template<typename TKey, typename TValue>
+	inline static Err
+	msgpack(Msgpack_Writer& self, const Ordered_Map<TKey, TValue>& v)
+	{
+		if (auto err = _msgpack_push_map_count(self, v.count)) return err;
+
 		for (const auto& a: v)
 		{
 			if (auto err = msgpack(self, a.key)) return err;
@@ -529,6 +598,48 @@ namespace mn
 		return {};
 	}
 
+	// writes the given words as a binary block in little endian byte order so it can be read on any machine
+	inline static Err
+	_msgpack_push_words(Msgpack_Writer& self, const uint64_t* words, size_t count)
+	{
+		if (system_endianness() == ENDIAN_LITTLE)
+			return msgpack(self, (const void*)words, count * sizeof(uint64_t));
+
+		auto swapped = buf_with_count<uint64_t>(count);
+		mn_defer { buf_free(swapped); };
+		for (size_t i = 0; i < count; ++i)
+			swapped[i] = byteswap_uint64(words[i]);
+		return msgpack(self, (const void*)swapped.ptr, count * sizeof(uint64_t));
+	}
+
+	template<typename T, typename THash>
+	inline static Err
+	msgpack(Msgpack_Writer& self, const Bloom_Filter<T, THash>& v)
+	{
+		if (auto err = _msgpack_push_map_count(self, 2)) return err;
+		if (auto err = msgpack(self, "blocks_count")) return err;
+		if (auto err = msgpack(self, uint64_t(v.blocks_count))) return err;
+		if (auto err = msgpack(self, "bits")) return err;
+		return _msgpack_push_words(self, (const uint64_t*)v.blocks, v.blocks_count * BLOOM_FILTER_BLOCK_WORDS);
+	}
+
+	template<typename T, typename THash>
+	inline static Err
+	msgpack(Msgpack_Writer& self, const Cuckoo_Filter<T, THash>& v)
+	{
+		if (auto err = _msgpack_push_map_count(self, 5)) return err;
+		if (auto err = msgpack(self, "buckets_count")) return err;
+		if (auto err = msgpack(self, uint64_t(v.buckets.count))) return err;
+		if (auto err = msgpack(self, "count")) return err;
+		if (auto err = msgpack(self, uint64_t(v.count))) return err;
+		if (auto err = msgpack(self, "victim_fingerprint")) return err;
+		if (auto err = msgpack(self, uint64_t(v.victim_fingerprint))) return err;
+		if (auto err = msgpack(self, "victim_index")) return err;
+		if (auto err = msgpack(self, uint64_t(v.victim_index))) return err;
+		if (auto err = msgpack(self, "buckets")) return err;
+		return _msgpack_push_words(self, v.buckets.ptr, v.buckets.count);
+	}
+
 	struct Msgpack_Reader
 	{
 		Stream stream;
@@ -946,6 +1057,50 @@ namespace mn
 		}
 	}
 
+	inline static Err
+	msgpack(Msgpack_Reader& self, Small_Str& res)
+	{
+		uint8_t prefix{};
+		if (auto err = _msgpack_pop_uint8(self, prefix)) return err;
+
+		if (self.allocator && res.allocator != self.allocator)
+		{
+			small_str_free(res);
+			res = small_str_with_allocator(self.allocator);
+		}
+
+		size_t str_count = 0;
+		if (prefix >= 0xa0 && prefix <= 0xbf)
+		{
+			str_count = prefix & 0x1f;
+		}
+		else if (prefix == 0xd9)
+		{
+			uint8_t count{};
+			if (auto err = _msgpack_pop_uint8(self, count)) return err;
+			str_count = count;
+		}
+		else if (prefix == 0xda)
+		{
+			uint16_t count{};
+			if (auto err = _msgpack_pop_uint16(self, count)) return err;
+			str_count = count;
+		}
+		else if (prefix == 0xdb)
+		{
+			uint32_t count{};
+			if (auto err = _msgpack_pop_uint32(self, count)) return err;
+			str_count = count;
+		}
+		else
+		{
+			return errf("invalid string prefix '{}'", prefix);
+		}
+
+		small_str_resize(res, str_count);
+		return _msgpack_pop(self, Block{small_str_ptr(res), res.count});
+	}
+
 	inline static Err
 	msgpack(Msgpack_Reader& self, const char*& res)
 	{
@@ -1093,6 +1248,51 @@ namespace mn
 		return {};
 	}
 
+	template<typename T, size_t N>
+	inline static Err
+	msgpack(Msgpack_Reader& self, Small_Buf<T, N>& res)
+	{
+		if (self.allocator && res.allocator != self.allocator)
+		{
+			destruct(res);
+			res = small_buf_with_allocator<T, N>(self.allocator);
+		}
+
+		uint8_t prefix{};
+		if (auto err = _msgpack_pop_uint8(self, prefix)) return err;
+
+		size_t array_count = 0;
+		if (prefix >= 0x90 && prefix <= 0x9f)
+		{
+			array_count = prefix & 0xf;
+		}
+		else if (prefix == 0xdc)
+		{
+			uint16_t count{};
+			if (auto err = _msgpack_pop_uint16(self, count)) return err;
+			array_count = count;
+		}
+		else if (prefix == 0xdd)
+		{
+			uint32_t count{};
+			if (auto err = _msgpack_pop_uint32(self, count)) return err;
+			array_count = count;
+		}
+		else
+		{
+			return errf("invalid array prefix '{}'", prefix);
+		}
+
+		small_buf_reserve(res, array_count);
+		for (size_t i = 0; i < array_count; ++i)
+		{
+			T v{};
+			if (auto err = msgpack(self, v)) return err;
+			small_buf_push(res, v);
+		}
+		return {};
+	}
+
 	template<typename T, size_t N>
 	inline static Err
 	msgpack(Msgpack_Reader& self, T (&res)[N])
@@ -1130,20 +1330,12 @@ namespace mn
 		return {};
 	}
 
-	template<typename TKey, typename TValue, typename THash>
 	inline static Err
-	msgpack(Msgpack_Reader& self, Map<TKey, TValue, THash>& res)
+	_msgpack_pop_map_count(Msgpack_Reader& self, size_t& map_count)
 	{
-		if (self.allocator && res._slots.allocator != self.allocator)
-		{
-			destruct(res);
-			res = map_with_allocator<TKey, TValue, THash>(self.allocator);
-		}
-
 		uint8_t prefix{};
 		if (auto err = _msgpack_pop_uint8(self, prefix)) return err;
 
-		size_t map_count = 0;
 		if (prefix >= 0x80 && prefix <= 0x8f)
 		{
 			map_count = prefix & 0xf;
@@ -1165,6 +1357,22 @@ namespace mn
 			return errf("invalid map prefix '{}'", prefix);
 		}
 
+		return {};
+	}
+
+	template<typename TKey, typename TValue, typename THash>
+	inline static Err
+	msgpack(Msgpack_Reader& self, Map<TKey, TValue, THash>& res)
+	{
+		if (self.allocator && res._slots.allocator != self.allocator)
+		{
+			destruct(res);
+			res = map_with_allocator<TKey, TValue, THash>(self.allocator);
+		}
+
+		size_t map_count = 0;
+		if (auto err = _msgpack_pop_map_count(self, map_count)) return err;
+
 		map_reserve(res, map_count);
 		for (size_t i = 0; i < map_count; ++i)
 		{
@@ -1179,6 +1387,32 @@ namespace mn
 		return {};
 	}
 
+	template<typename TKey, typename TValue>
+	inline static Err
+	msgpack(Msgpack_Reader& self, Ordered_Map<TKey, TValue>& res)
+	{
+		if (self.allocator && res.allocator != self.allocator)
+		{
+			destruct(res);
+			res = ordered_map_with_allocator<TKey, TValue>(self.allocator);
+		}
+
+		size_t map_count = 0;
+		if (auto err = _msgpack_pop_map_count(self, map_count)) return err;
+
+		for (size_t i = 0; i < map_count; ++i)
+		{
+			TKey key{};
+			if (auto err = msgpack(self, key)) return err;
+
+			TValue value{};
+			if (auto err = msgpack(self, value)) return err;
+
+			ordered_map_insert(res, key, value);
+		}
+		return {};
+	}
+
 	// struct helper code
 	template<typename T>
 	struct Msgpack_Field
@@ -1308,6 +1542,111 @@ namespace mn
 		return {};
 	}
 
+	// reads a binary block of exactly the given count of little endian words
+	inline static Err
+	_msgpack_pop_words(Msgpack_Reader& self, uint64_t* words, size_t count)
+	{
+		void* ptr = words;
+		size_t size = count * sizeof(uint64_t);
+		if (auto err = msgpack(self, ptr, size)) return err;
+
+		if (system_endianness() == ENDIAN_BIG)
+			for (size_t i = 0; i < count; ++i)
+				words[i] = byteswap_uint64(words[i]);
+		return {};
+	}
+
+	template<typename T, typename THash>
+	inline static Err
+	msgpack(Msgpack_Reader& self, Bloom_Filter<T, THash>& res)
+	{
+		auto allocator = res.allocator;
+		if (self.allocator)
+			allocator = self.allocator;
+		if (allocator == nullptr)
+			allocator = allocator_top();
+
+		uint64_t blocks_count = 0;
+		Str field_name{};
+		mn_defer { str_free(field_name); };
+
+		// the bits field is written last so we know the size of the filter by the time we read it
+		size_t fields_count = 0;
+		if (auto err = _msgpack_pop_map_count(self, fields_count)) return err;
+		if (fields_count != 2) return errf("expected bloom filter with 2 fields, but found '{}'", fields_count);
+		if (auto err = msgpack(self, field_name)) return err;
+		if (field_name != "blocks_count") return errf("expected bloom filter field 'blocks_count', but found '{}'", field_name);
+		if (auto err = msgpack(self, blocks_count)) return err;
+		if (blocks_count == 0 || blocks_count > UINT32_MAX) return errf("invalid bloom filter blocks count '{}'", blocks_count);
+
+		str_clear(field_name);
+		if (auto err = msgpack(self, field_name)) return err;
+		if (field_name != "bits") return errf("expected bloom filter field 'bits', but found '{}'", field_name);
+
+		auto filter = _bloom_filter_with_blocks<T, THash>(allocator, size_t(blocks_count));
+		if (auto err = _msgpack_pop_words(self, (uint64_t*)filter.blocks, filter.blocks_count * BLOOM_FILTER_BLOCK_WORDS))
+		{
+			bloom_filter_free(filter);
+			return err;
+		}
+
+		bloom_filter_free(res);
+		res = filter;
+		return {};
+	}
+
+	template<typename T, typename THash>
+	inline static Err
+	msgpack(Msgpack_Reader& self, Cuckoo_Filter<T, THash>& res)
+	{
+		auto allocator = res.buckets.allocator;
+		if (self.allocator)
+			allocator = self.allocator;
+		if (allocator == nullptr)
+			allocator = allocator_top();
+
+		uint64_t buckets_count = 0, count = 0, victim_fingerprint = 0, victim_index = 0;
+		Str field_name{};
+		mn_defer { str_free(field_name); };
+
+		// the buckets field is written last so we know the size of the filter by the time we read it
+		size_t fields_count = 0;
+		if (auto err = _msgpack_pop_map_count(self, fields_count)) return err;
+		if (fields_count != 5) return errf("expected cuckoo filter with 5 fields, but found '{}'", fields_count);
+		const char* names[] = {"buckets_count", "count", "victim_fingerprint", "victim_index"};
+		uint64_t* values[] = {&buckets_count, &count, &victim_fingerprint, &victim_index};
+		for (size_t i = 0; i < 4; ++i)
+		{
+			str_clear(field_name);
+			if (auto err = msgpack(self, field_name)) return err;
+			if (field_name != names[i]) return errf("expected cuckoo filter field '{}', but found '{}'", names[i], field_name);
+			if (auto err = msgpack(self, *values[i])) return err;
+		}
+
+		if (buckets_count == 0 || (buckets_count & (buckets_count - 1)) != 0)
+			return errf("invalid cuckoo filter buckets count '{}'", buckets_count);
+		if (victim_fingerprint > UINT16_MAX || victim_index >= buckets_count)
+			return errf("invalid cuckoo filter victim");
+
+		str_clear(field_name);
+		if (auto err = msgpack(self, field_name)) return err;
+		if (field_name != "buckets") return errf("expected cuckoo filter field 'buckets', but found '{}'", field_name);
+
+		auto filter = _cuckoo_filter_with_buckets<T, THash>(allocator, size_t(buckets_count));
+		if (auto err = _msgpack_pop_words(self, filter.buckets.ptr, filter.buckets.count))
+		{
+			cuckoo_filter_free(filter);
+			return err;
+		}
+		filter.count = size_t(count);
+		filter.victim_fingerprint = uint16_t(victim_fingerprint);
+		filter.victim_index = size_t(victim_index);
+
+		cuckoo_filter_free(res);
+		res = filter;
+		return {};
+	}
+
 	// helper encode/decode functions
 	template<typename T>
 	inline static Result<Str>
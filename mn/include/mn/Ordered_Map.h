@@ -0,0 +1,842 @@
+#pragma once
+
+#include "mn/Base.h"
+#include "mn/Memory.h"
+#include "mn/Buf.h"
+#include "mn/Map.h"
+#include "mn/Assert.h"
+
+#include <string.h>
+
+namespace mn
+{
+	// the size in bytes that the ordered map nodes aim for, it spans a few cache lines so that searching a node
+	// touches a handful of contiguous cache lines instead of chasing a pointer per key like binary trees do
+	constexpr size_t ORDERED_MAP_NODE_SIZE = 256;
+
+	// an ordered map implemented as a B+ tree, the entries are stored sorted by key (using operator<) in wide leaf
+	// nodes which are linked together for ordered iteration, and the internal nodes only store keys to guide the
+	// search, it's useful for range queries and ordered iteration (time series keys, prefix scans over strings, etc.)
+	// note: inserting or removing entries invalidates the pointers and iterators into the ordered map
+	template<typename TKey, typename TValue>
+	struct Ordered_Map
+	{
+		static constexpr size_t
+		_node_capacity(size_t element_size)
+		{
+			size_t res = ORDERED_MAP_NODE_SIZE / element_size;
+			return res < 4 ? 4 : res;
+		}
+
+		// max count of entries in a leaf node
+		static constexpr size_t LEAF_CAPACITY = _node_capacity(sizeof(Key_Value<TKey, TValue>));
+		// max count of keys in an internal node
+		static constexpr size_t INTERNAL_CAPACITY = _node_capacity(sizeof(TKey));
+
+		struct Node
+		{
+			size_t count;
+			bool is_leaf;
+		};
+
+		struct Leaf: Node
+		{
+			Leaf* prev;
+			Leaf* next;
+			Key_Value<TKey, TValue> entries[LEAF_CAPACITY];
+		};
+
+		// keys[i] is the min key of the subtree children[i + 1], it's a shallow copy of the key in the leaf so it
+		// doesn't own any memory, and it's kept in sync when the min key is removed
+		struct Internal: Node
+		{
+			TKey keys[INTERNAL_CAPACITY];
+			Node* children[INTERNAL_CAPACITY + 1];
+		};
+
+		Allocator allocator;
+		Node* root;
+		size_t count;
+	};
+
+	// an iterator over the entries of the ordered map in ascending key order
+	template<typename TKey, typename TValue>
+	struct Ordered_Map_Iterator
+	{
+		typename Ordered_Map<TKey, TValue>::Leaf* leaf;
+		size_t index;
+
+		Ordered_Map_Iterator&
+		operator++()
+		{
+			++index;
+			if (index == leaf->count)
+			{
+				leaf = leaf->next;
+				index = 0;
+			}
+			return *this;
+		}
+
+		Ordered_Map_Iterator
+		operator++(int)
+		{
+			auto res = *this;
+			operator++();
+			return res;
+		}
+
+		bool
+		operator==(const Ordered_Map_Iterator& other) const
+		{
+			return leaf == other.leaf && index == other.index;
+		}
+
+		bool
+		operator!=(const Ordered_Map_Iterator& other) const
+		{
+			return !operator==(other);
+		}
+
+		Key_Value<const TKey, TValue>&
+		operator*() const
+		{
+			return *(Key_Value<const TKey, TValue>*)(leaf->entries + index);
+		}
+
+		Key_Value<const TKey, TValue>*
+		operator->() const
+		{
+			return (Key_Value<const TKey, TValue>*)(leaf->entries + index);
+		}
+	};
+
+	template<typename TKey, typename TValue>
+	inline static typename Ordered_Map<TKey, TValue>::Leaf*
+	_ordered_map_leaf_new(Ordered_Map<TKey, TValue>& self)
+	{
+		auto res = alloc_zerod_from<typename Ordered_Map<TKey, TValue>::Leaf>(self.allocator);
+		res->is_leaf = true;
+		return res;
+	}
+
+	template<typename TKey, typename TValue>
+	inline static typename Ordered_Map<TKey, TValue>::Internal*
+	_ordered_map_internal_new(Ordered_Map<TKey, TValue>& self)
+	{
+		return alloc_zerod_from<typename Ordered_Map<TKey, TValue>::Internal>(self.allocator);
+	}
+
+	template<typename TKey, typename TValue>
+	inline static void
+	_ordered_map_node_free(Ordered_Map<TKey, TValue>& self, typename Ordered_Map<TKey, TValue>::Node* node)
+	{
+		using Leaf = typename Ordered_Map<TKey, TValue>::Leaf;
+		using Internal = typename Ordered_Map<TKey, TValue>::Internal;
+
+		if (node->is_leaf)
+			free_from(self.allocator, Block{node, sizeof(Leaf)});
+		else
+			free_from(self.allocator, Block{node, sizeof(Internal)});
+	}
+
+	// returns the index of the first entry in the leaf which is not less than the given key
+	template<typename TLeaf, typename TKey>
+	inline static size_t
+	_ordered_map_leaf_lower_bound(const TLeaf* leaf, const TKey& key)
+	{
+		size_t begin = 0, end = leaf->count;
+		while (begin < end)
+		{
+			size_t mid = begin + (end - begin) / 2;
+			if (leaf->entries[mid].key < key)
+				begin = mid + 1;
+			else
+				end = mid;
+		}
+		return begin;
+	}
+
+	// returns the index of the child in the internal node which the given key belongs to
+	template<typename TInternal, typename TKey>
+	inline static size_t
+	_ordered_map_internal_child_index(const TInternal* internal, const TKey& key)
+	{
+		size_t begin = 0, end = internal->count;
+		while (begin < end)
+		{
+			size_t mid = begin + (end - begin) / 2;
+			if (key < internal->keys[mid])
+				end = mid;
+			else
+				begin = mid + 1;
+		}
+		return begin;
+	}
+
+	// returns the leaf which the given key belongs to, or nullptr if the ordered map is empty
+	template<typename TKey, typename TValue>
+	inline static typename Ordered_Map<TKey, TValue>::Leaf*
+	_ordered_map_find_leaf(const Ordered_Map<TKey, TValue>& self, const TKey& key)
+	{
+		using Leaf = typename Ordered_Map<TKey, TValue>::Leaf;
+		using Internal = typename Ordered_Map<TKey, TValue>::Internal;
+
+		auto node = self.root;
+		if (node == nullptr)
+			return nullptr;
+
+		while (node->is_leaf == false)
+		{
+			auto internal = (Internal*)node;
+			node = internal->children[_ordered_map_internal_child_index(internal, key)];
+		}
+		return (Leaf*)node;
+	}
+
+	// returns the min key in the subtree of the given node
+	template<typename TKey, typename TValue>
+	inline static const TKey&
+	_ordered_map_subtree_min_key(const typename Ordered_Map<TKey, TValue>::Node* node)
+	{
+		using Leaf = typename Ordered_Map<TKey, TValue>::Leaf;
+		using Internal = typename Ordered_Map<TKey, TValue>::Internal;
+
+		while (node->is_leaf == false)
+			node = ((const Internal*)node)->children[0];
+		return ((const Leaf*)node)->entries[0].key;
+	}
+
+	template<typename TKey, typename TValue>
+	inline static void
+	_ordered_map_subtree_free(Ordered_Map<TKey, TValue>& self, typename Ordered_Map<TKey, TValue>::Node* node)
+	{
+		using Internal = typename Ordered_Map<TKey, TValue>::Internal;
+
+		if (node->is_leaf == false)
+		{
+			auto internal = (Internal*)node;
+			for (size_t i = 0; i <= internal->count; ++i)
+				_ordered_map_subtree_free(self, internal->children[i]);
+		}
+		_ordered_map_node_free(self, node);
+	}
+
+	// inserts the given key and value into the subtree of the given node, and returns the inserted entry in the res
+	// argument, if the node is split it returns the new right node and its separator key, otherwise it returns nullptr
+	template<typename TKey, typename TValue>
+	inline static typename Ordered_Map<TKey, TValue>::Node*
+	_ordered_map_insert(
+		Ordered_Map<TKey, TValue>& self,
+		typename Ordered_Map<TKey, TValue>::Node* node,
+		const TKey& key,
+		const TValue& value,
+		Key_Value<TKey, TValue>*& res,
+		TKey& separator)
+	{
+		using Map = Ordered_Map<TKey, TValue>;
+		using Leaf = typename Map::Leaf;
+		using Internal = typename Map::Internal;
+		using Node = typename Map::Node;
+
+		if (node->is_leaf)
+		{
+			auto leaf = (Leaf*)node;
+			auto index = _ordered_map_leaf_lower_bound(leaf, key);
+			if (index < leaf->count && (key < leaf->entries[index].key) == false)
+			{
+				leaf->entries[index].value = value;
+				res = leaf->entries + index;
+				return nullptr;
+			}
+
+			Leaf* target = leaf;
+			Leaf* right = nullptr;
+			if (leaf->count == Map::LEAF_CAPACITY)
+			{
+				// the left leaf ends up with half of the entries including the new entry
+				right = _ordered_map_leaf_new(self);
+				size_t left_count = (Map::LEAF_CAPACITY + 1) / 2;
+				if (index < left_count)
+					--left_count;
+				else
+					target = right;
+
+				right->count = Map::LEAF_CAPACITY - left_count;
+				::memcpy(right->entries, leaf->entries + left_count, right->count * sizeof(Key_Value<TKey, TValue>));
+				leaf->count = left_count;
+				if (target == right)
+					index -= left_count;
+
+				right->next = leaf->next;
+				if (right->next)
+					right->next->prev = right;
+				right->prev = leaf;
+				leaf->next = right;
+			}
+
+			::memmove(target->entries + index + 1, target->entries + index, (target->count - index) * sizeof(Key_Value<TKey, TValue>));
+			target->entries[index] = Key_Value<TKey, TValue>{key, value};
+			++target->count;
+			++self.count;
+			res = target->entries + index;
+
+			if (right)
+				separator = right->entries[0].key;
+			return right;
+		}
+
+		auto internal = (Internal*)node;
+		auto child_index = _ordered_map_internal_child_index(internal, key);
+		TKey child_separator{};
+		auto child_right = _ordered_map_insert(self, internal->children[child_index], key, value, res, child_separator);
+		if (child_right == nullptr)
+			return nullptr;
+
+		if (internal->count < Map::INTERNAL_CAPACITY)
+		{
+			::memmove(internal->keys + child_index + 1, internal->keys + child_index, (internal->count - child_index) * sizeof(TKey));
+			::memmove(internal->children + child_index + 2, internal->children + child_index + 1, (internal->count - child_index) * sizeof(Node*));
+			internal->keys[child_index] = child_separator;
+			internal->children[child_index + 1] = child_right;
+			++internal->count;
+			return nullptr;
+		}
+
+		// the internal node is full, so we gather all the keys and children then split them in half and the middle key
+		// moves up to the parent
+		constexpr size_t KEYS_COUNT = Map::INTERNAL_CAPACITY + 1;
+		TKey keys[KEYS_COUNT];
+		Node* children[KEYS_COUNT + 1];
+		::memcpy(keys, internal->keys, child_index * sizeof(TKey));
+		keys[child_index] = child_separator;
+		::memcpy(keys + child_index + 1, internal->keys + child_index, (internal->count - child_index) * sizeof(TKey));
+		::memcpy(children, internal->children, (child_index + 1) * sizeof(Node*));
+		children[child_index + 1] = child_right;
+		::memcpy(children + child_index + 2, internal->children + child_index + 1, (internal->count - child_index) * sizeof(Node*));
+
+		size_t mid = KEYS_COUNT / 2;
+		auto right = _ordered_map_internal_new(self);
+		internal->count = mid;
+		::memcpy(internal->keys, keys, mid * sizeof(TKey));
+		::memcpy(internal->children, children, (mid + 1) * sizeof(Node*));
+		right->count = KEYS_COUNT - mid - 1;
+		::memcpy(right->keys, keys + mid + 1, right->count * sizeof(TKey));
+		::memcpy(right->children, children + mid + 1, (right->count + 1) * sizeof(Node*));
+		separator = keys[mid];
+		return right;
+	}
+
+	// removes the key at the given index and the child to its right from the given internal node
+	template<typename TInternal>
+	inline static void
+	_ordered_map_internal_remove_at(TInternal* internal, size_t index)
+	{
+		::memmove(internal->keys + index, internal->keys + index + 1, (internal->count - index - 1) * sizeof(internal->keys[0]));
+		::memmove(internal->children + index + 1, internal->children + index + 2, (internal->count - index - 1) * sizeof(internal->children[0]));
+		--internal->count;
+	}
+
+	// fixes the underflow of the child at the given index by borrowing from its siblings or merging with one of them
+	template<typename TKey, typename TValue>
+	inline static void
+	_ordered_map_rebalance(Ordered_Map<TKey, TValue>& self, typename Ordered_Map<TKey, TValue>::Internal* parent, size_t index)
+	{
+		using Map = Ordered_Map<TKey, TValue>;
+		using Leaf = typename Map::Leaf;
+		using Internal = typename Map::Internal;
+		using Node = typename Map::Node;
+
+		auto child = parent->children[index];
+		auto left = index > 0 ? parent->children[index - 1] : nullptr;
+		auto right = index < parent->count ? parent->children[index + 1] : nullptr;
+
+		if (child->is_leaf)
+		{
+			constexpr size_t MIN_COUNT = Map::LEAF_CAPACITY / 2;
+			auto c = (Leaf*)child;
+			if (left && left->count > MIN_COUNT)
+			{
+				auto l = (Leaf*)left;
+				::memmove(c->entries + 1, c->entries, c->count * sizeof(Key_Value<TKey, TValue>));
+				c->entries[0] = l->entries[l->count - 1];
+				--l->count;
+				++c->count;
+				parent->keys[index - 1] = c->entries[0].key;
+			}
+			else if (right && right->count > MIN_COUNT)
+			{
+				auto r = (Leaf*)right;
+				c->entries[c->count] = r->entries[0];
+				++c->count;
+				--r->count;
+				::memmove(r->entries, r->entries + 1, r->count * sizeof(Key_Value<TKey, TValue>));
+				parent->keys[index] = r->entries[0].key;
+			}
+			else
+			{
+				size_t merge_index = left ? index - 1 : index;
+				auto l = (Leaf*)parent->children[merge_index];
+				auto r = (Leaf*)parent->children[merge_index + 1];
+				::memcpy(l->entries + l->count, r->entries, r->count * sizeof(Key_Value<TKey, TValue>));
+				l->count += r->count;
+				l->next = r->next;
+				if (l->next)
+					l->next->prev = l;
+				_ordered_map_node_free(self, r);
+				_ordered_map_internal_remove_at(parent, merge_index);
+			}
+		}
+		else
+		{
+			constexpr size_t MIN_COUNT = Map::INTERNAL_CAPACITY / 2;
+			auto c = (Internal*)child;
+			if (left && left->count > MIN_COUNT)
+			{
+				auto l = (Internal*)left;
+				::memmove(c->keys + 1, c->keys, c->count * sizeof(TKey));
+				::memmove(c->children + 1, c->children, (c->count + 1) * sizeof(Node*));
+				c->keys[0] = parent->keys[index - 1];
+				c->children[0] = l->children[l->count];
+				parent->keys[index - 1] = l->keys[l->count - 1];
+				--l->count;
+				++c->count;
+			}
+			else if (right && right->count > MIN_COUNT)
+			{
+				auto r = (Internal*)right;
+				c->keys[c->count] = parent->keys[index];
+				c->children[c->count + 1] = r->children[0];
+				++c->count;
+				parent->keys[index] = r->keys[0];
+				::memmove(r->keys, r->keys + 1, (r->count - 1) * sizeof(TKey));
+				::memmove(r->children, r->children + 1, r->count * sizeof(Node*));
+				--r->count;
+			}
+			else
+			{
+				size_t merge_index = left ? index - 1 : index;
+				auto l = (Internal*)parent->children[merge_index];
+				auto r = (Internal*)parent->children[merge_index + 1];
+				l->keys[l->count] = parent->keys[merge_index];
+				::memcpy(l->keys + l->count + 1, r->keys, r->count * sizeof(TKey));
+				::memcpy(l->children + l->count + 1, r->children, (r->count + 1) * sizeof(Node*));
+				l->count += r->count + 1;
+				_ordered_map_node_free(self, r);
+				_ordered_map_internal_remove_at(parent, merge_index);
+			}
+		}
+	}
+
+	// removes the given key from the subtree of the given node, and returns whether it found and removed the key
+	template<typename TKey, typename TValue>
+	inline static bool
+	_ordered_map_remove(Ordered_Map<TKey, TValue>& self, typename Ordered_Map<TKey, TValue>::Node* node, const TKey& key)
+	{
+		using Map = Ordered_Map<TKey, TValue>;
+		using Leaf = typename Map::Leaf;
+		using Internal = typename Map::Internal;
+
+		if (node->is_leaf)
+		{
+			auto leaf = (Leaf*)node;
+			auto index = _ordered_map_leaf_lower_bound(leaf, key);
+			if (index == leaf->count || key < leaf->entries[index].key)
+				return false;
+
+			::memmove(leaf->entries + index, leaf->entries + index + 1, (leaf->count - index - 1) * sizeof(Key_Value<TKey, TValue>));
+			--leaf->count;
+			--self.count;
+			return true;
+		}
+
+		auto internal = (Internal*)node;
+		auto child_index = _ordered_map_internal_child_index(internal, key);
+		auto child = internal->children[child_index];
+		if (_ordered_map_remove(self, child, key) == false)
+			return false;
+
+		// the removed key was the min key of the child so we update its separator to the new min key
+		if (child_index > 0 && (internal->keys[child_index - 1] < key) == false)
+			internal->keys[child_index - 1] = _ordered_map_subtree_min_key<TKey, TValue>(child);
+
+		size_t min_count = child->is_leaf ? Map::LEAF_CAPACITY / 2 : Map::INTERNAL_CAPACITY / 2;
+		if (child->count < min_count)
+			_ordered_map_rebalance(self, internal, child_index);
+		return true;
+	}
+
+	template<bool DEEP, typename TKey, typename TValue>
+	inline static typename Ordered_Map<TKey, TValue>::Node*
+	_ordered_map_subtree_clone(
+		Ordered_Map<TKey, TValue>& self,
+		const typename Ordered_Map<TKey, TValue>::Node* node,
+		typename Ordered_Map<TKey, TValue>::Leaf*& prev_leaf)
+	{
+		using Leaf = typename Ordered_Map<TKey, TValue>::Leaf;
+		using Internal = typename Ordered_Map<TKey, TValue>::Internal;
+
+		if (node->is_leaf)
+		{
+			auto other = (const Leaf*)node;
+			auto leaf = _ordered_map_leaf_new(self);
+			leaf->count = other->count;
+			for (size_t i = 0; i < other->count; ++i)
+			{
+				if constexpr (DEEP)
+					leaf->entries[i] = clone(other->entries[i]);
+				else
+					leaf->entries[i] = other->entries[i];
+			}
+
+			leaf->prev = prev_leaf;
+			if (prev_leaf)
+				prev_leaf->next = leaf;
+			prev_leaf = leaf;
+			return leaf;
+		}
+
+		auto other = (const Internal*)node;
+		auto internal = _ordered_map_internal_new(self);
+		internal->count = other->count;
+		for (size_t i = 0; i <= other->count; ++i)
+		{
+			internal->children[i] = _ordered_map_subtree_clone<DEEP>(self, other->children[i], prev_leaf);
+			if (i > 0)
+				internal->keys[i - 1] = _ordered_map_subtree_min_key<TKey, TValue>(internal->children[i]);
+		}
+		return internal;
+	}
+
+	// creates a new ordered map with the given allocator
+	template<typename TKey, typename TValue>
+	inline static Ordered_Map<TKey, TValue>
+	ordered_map_with_allocator(Allocator allocator)
+	{
+		Ordered_Map<TKey, TValue> self{};
+		self.allocator = allocator;
+		return self;
+	}
+
+	// creates a new ordered map
+	template<typename TKey, typename TValue>
+	inline static Ordered_Map<TKey, TValue>
+	ordered_map_new()
+	{
+		return ordered_map_with_allocator<TKey, TValue>(allocator_top());
+	}
+
+	// frees the given ordered map, note this doesn't free any complex data structure stored in the ordered map
+	template<typename TKey, typename TValue>
+	inline static void
+	ordered_map_free(Ordered_Map<TKey, TValue>& self)
+	{
+		if (self.root)
+			_ordered_map_subtree_free(self, self.root);
+		self.root = nullptr;
+		self.count = 0;
+	}
+
+	// clears the given ordered map content, note this doesn't free any complex data structure stored in it
+	template<typename TKey, typename TValue>
+	inline static void
+	ordered_map_clear(Ordered_Map<TKey, TValue>& self)
+	{
+		ordered_map_free(self);
+	}
+
+	// inserts the given key and value into the ordered map and returns a pointer to the entry, if the key already exists
+	// its value is overwritten
+	template<typename TKey, typename TValue>
+	inline static Key_Value<const TKey, TValue>*
+	ordered_map_insert(Ordered_Map<TKey, TValue>& self, const TKey& key, const TValue& value)
+	{
+		using Node = typename Ordered_Map<TKey, TValue>::Node;
+
+		if (self.allocator == nullptr)
+			self.allocator = allocator_top();
+
+		if (self.root == nullptr)
+			self.root = _ordered_map_leaf_new(self);
+
+		Key_Value<TKey, TValue>* res = nullptr;
+		TKey separator{};
+		auto right = _ordered_map_insert(self, self.root, key, value, res, separator);
+		if (right)
+		{
+			auto root = _ordered_map_internal_new(self);
+			root->count = 1;
+			root->keys[0] = separator;
+			root->children[0] = self.root;
+			root->children[1] = right;
+			self.root = (Node*)root;
+		}
+		return (Key_Value<const TKey, TValue>*)res;
+	}
+
+	// inserts a key with zero/empty value into the ordered map and returns a pointer to the entry
+	template<typename TKey, typename TValue>
+	inline static Key_Value<const TKey, TValue>*
+	ordered_map_insert(Ordered_Map<TKey, TValue>& self, const TKey& key)
+	{
+		return ordered_map_insert(self, key, TValue{});
+	}
+
+	// searches for the given key in the ordered map, if it doesn't exist it will return nullptr
+	template<typename TKey, typename TValue>
+	inline static Key_Value<const TKey, TValue>*
+	ordered_map_lookup(Ordered_Map<TKey, TValue>& self, const TKey& key)
+	{
+		auto leaf = _ordered_map_find_leaf(self, key);
+		if (leaf == nullptr)
+			return nullptr;
+
+		auto index = _ordered_map_leaf_lower_bound(leaf, key);
+		if (index == leaf->count || key < leaf->entries[index].key)
+			return nullptr;
+		return (Key_Value<const TKey, TValue>*)(leaf->entries + index);
+	}
+
+	// searches for the given key in the ordered map, if it doesn't exist it will return nullptr
+	template<typename TKey, typename TValue>
+	inline static const Key_Value<const TKey, TValue>*
+	ordered_map_lookup(const Ordered_Map<TKey, TValue>& self, const TKey& key)
+	{
+		return ordered_map_lookup(const_cast<Ordered_Map<TKey, TValue>&>(self), key);
+	}
+
+	// removes the given key from the ordered map, and returns whether it found and removed the key, note this doesn't
+	// free any complex data structure stored in the key or the value
+	template<typename TKey, typename TValue>
+	inline static bool
+	ordered_map_remove(Ordered_Map<TKey, TValue>& self, const TKey& key)
+	{
+		using Internal = typename Ordered_Map<TKey, TValue>::Internal;
+
+		if (self.root == nullptr)
+			return false;
+
+		if (_ordered_map_remove(self, self.root, key) == false)
+			return false;
+
+		if (self.root->count == 0)
+		{
+			auto old_root = self.root;
+			self.root = old_root->is_leaf ? nullptr : ((Internal*)old_root)->children[0];
+			_ordered_map_node_free(self, old_root);
+		}
+		return true;
+	}
+
+	// returns an iterator to the first entry in the ordered map
+	template<typename TKey, typename TValue>
+	inline static Ordered_Map_Iterator<TKey, TValue>
+	ordered_map_begin(const Ordered_Map<TKey, TValue>& self)
+	{
+		using Internal = typename Ordered_Map<TKey, TValue>::Internal;
+		using Leaf = typename Ordered_Map<TKey, TValue>::Leaf;
+
+		auto node = self.root;
+		if (node == nullptr)
+			return {};
+
+		while (node->is_leaf == false)
+			node = ((Internal*)node)->children[0];
+		return Ordered_Map_Iterator<TKey, TValue>{(Leaf*)node, 0};
+	}
+
+	// returns an iterator after the last entry in the ordered map
+	template<typename TKey, typename TValue>
+	inline static Ordered_Map_Iterator<TKey, TValue>
+	ordered_map_end(const Ordered_Map<TKey, TValue>&)
+	{
+		return {};
+	}
+
+	// returns an iterator to the first entry with a key which is not less than the given key (greater or equal), or the
+	// end iterator if there's no such entry
+	template<typename TKey, typename TValue>
+	inline static Ordered_Map_Iterator<TKey, TValue>
+	ordered_map_lower_bound(const Ordered_Map<TKey, TValue>& self, const TKey& key)
+	{
+		auto leaf = _ordered_map_find_leaf(self, key);
+		if (leaf == nullptr)
+			return {};
+
+		auto index = _ordered_map_leaf_lower_bound(leaf, key);
+		if (index == leaf->count)
+			return Ordered_Map_Iterator<TKey, TValue>{leaf->next, 0};
+		return Ordered_Map_Iterator<TKey, TValue>{leaf, index};
+	}
+
+	// returns an iterator to the first entry with a key which is greater than the given key, or the end iterator if
+	// there's no such entry
+	template<typename TKey, typename TValue>
+	inline static Ordered_Map_Iterator<TKey, TValue>
+	ordered_map_upper_bound(const Ordered_Map<TKey, TValue>& self, const TKey& key)
+	{
+		auto it = ordered_map_lower_bound(self, key);
+		if (it.leaf && (key < it->key) == false)
+			++it;
+		return it;
+	}
+
+	// begin iterator overload for the ordered map
+	template<typename TKey, typename TValue>
+	inline static Ordered_Map_Iterator<TKey, TValue>
+	begin(const Ordered_Map<TKey, TValue>& self)
+	{
+		return ordered_map_begin(self);
+	}
+
+	// end iterator overload for the ordered map
+	template<typename TKey, typename TValue>
+	inline static Ordered_Map_Iterator<TKey, TValue>
+	end(const Ordered_Map<TKey, TValue>& self)
+	{
+		return ordered_map_end(self);
+	}
+
+	// creates an ordered map from the given entries which should be sorted by key in ascending order with unique keys,
+	// it builds the tree bottom up in linear time which is much faster than inserting the entries one by one, and the
+	// entries are copied by memcpy into the ordered map
+	template<typename TKey, typename TValue>
+	inline static Ordered_Map<TKey, TValue>
+	ordered_map_from_sorted(const Key_Value<TKey, TValue>* entries, size_t count, Allocator allocator = allocator_top())
+	{
+		using Map = Ordered_Map<TKey, TValue>;
+		using Node = typename Map::Node;
+
+		auto self = ordered_map_with_allocator<TKey, TValue>(allocator);
+		if (count == 0)
+			return self;
+
+		for (size_t i = 1; i < count; ++i)
+			mn_assert_msg(entries[i - 1].key < entries[i].key, "entries should be sorted in ascending order with unique keys");
+
+		// the nodes of the current level along with the min key of each one of them
+		auto nodes = buf_with_allocator<Node*>(memory::clib());
+		auto min_keys = buf_with_allocator<TKey>(memory::clib());
+		auto next_nodes = buf_with_allocator<Node*>(memory::clib());
+		auto next_min_keys = buf_with_allocator<TKey>(memory::clib());
+
+		// entries are distributed evenly over the leaves so that all of them are at least half full
+		size_t leaves_count = (count + Map::LEAF_CAPACITY - 1) / Map::LEAF_CAPACITY;
+		typename Map::Leaf* prev_leaf = nullptr;
+		for (size_t i = 0, offset = 0; i < leaves_count; ++i)
+		{
+			size_t leaf_count = count / leaves_count + (i < count % leaves_count ? 1 : 0);
+			auto leaf = _ordered_map_leaf_new(self);
+			leaf->count = leaf_count;
+			::memcpy(leaf->entries, entries + offset, leaf_count * sizeof(Key_Value<TKey, TValue>));
+			leaf->prev = prev_leaf;
+			if (prev_leaf)
+				prev_leaf->next = leaf;
+			prev_leaf = leaf;
+
+			buf_push(nodes, (Node*)leaf);
+			buf_push(min_keys, entries[offset].key);
+			offset += leaf_count;
+		}
+		self.count = count;
+
+		// then we build the internal levels bottom up until we reach a single root
+		constexpr size_t MAX_CHILDREN = Map::INTERNAL_CAPACITY + 1;
+		while (nodes.count > 1)
+		{
+			buf_clear(next_nodes);
+			buf_clear(next_min_keys);
+
+			size_t parents_count = (nodes.count + MAX_CHILDREN - 1) / MAX_CHILDREN;
+			for (size_t i = 0, offset = 0; i < parents_count; ++i)
+			{
+				size_t children_count = nodes.count / parents_count + (i < nodes.count % parents_count ? 1 : 0);
+				auto internal = _ordered_map_internal_new(self);
+				internal->count = children_count - 1;
+				for (size_t j = 0; j < children_count; ++j)
+				{
+					internal->children[j] = nodes[offset + j];
+					if (j > 0)
+						internal->keys[j - 1] = min_keys[offset + j];
+				}
+
+				buf_push(next_nodes, (Node*)internal);
+				buf_push(next_min_keys, min_keys[offset]);
+				offset += children_count;
+			}
+
+			auto tmp_nodes = nodes;
+			nodes = next_nodes;
+			next_nodes = tmp_nodes;
+
+			auto tmp_min_keys = min_keys;
+			min_keys = next_min_keys;
+			next_min_keys = tmp_min_keys;
+		}
+		self.root = nodes[0];
+
+		buf_free(nodes);
+		buf_free(min_keys);
+		buf_free(next_nodes);
+		buf_free(next_min_keys);
+		return self;
+	}
+
+	// creates an ordered map from the given buf of entries which should be sorted by key in ascending order with unique
+	// keys
+	template<typename TKey, typename TValue>
+	inline static Ordered_Map<TKey, TValue>
+	ordered_map_from_sorted(const Buf<Key_Value<TKey, TValue>>& entries, Allocator allocator = allocator_top())
+	{
+		return ordered_map_from_sorted(entries.ptr, entries.count, allocator);
+	}
+
+	// clones the given ordered map using the given allocator, it calls clone on each key and value
+	template<typename TKey, typename TValue>
+	inline static Ordered_Map<TKey, TValue>
+	ordered_map_clone(const Ordered_Map<TKey, TValue>& other, Allocator allocator = allocator_top())
+	{
+		auto self = ordered_map_with_allocator<TKey, TValue>(allocator);
+		if (other.root == nullptr)
+			return self;
+
+		typename Ordered_Map<TKey, TValue>::Leaf* prev_leaf = nullptr;
+		self.root = _ordered_map_subtree_clone<true>(self, other.root, prev_leaf);
+		self.count = other.count;
+		return self;
+	}
+
+	// clones the given ordered map using the given allocator by calling into memcpy, this is useful for POD/trivial
+	// structures which doesn't have a clone overload
+	template<typename TKey, typename TValue>
+	inline static Ordered_Map<TKey, TValue>
+	ordered_map_memcpy_clone(const Ordered_Map<TKey, TValue>& other, Allocator allocator = allocator_top())
+	{
+		auto self = ordered_map_with_allocator<TKey, TValue>(allocator);
+		if (other.root == nullptr)
+			return self;
+
+		typename Ordered_Map<TKey, TValue>::Leaf* prev_leaf = nullptr;
+		self.root = _ordered_map_subtree_clone<false>(self, other.root, prev_leaf);
+		self.count = other.count;
+		return self;
+	}
+
+	// clone overload for the ordered map
+	template<typename TKey, typename TValue>
+	inline static Ordered_Map<TKey, TValue>
+	clone(const Ordered_Map<TKey, TValue>& other)
+	{
+		return ordered_map_clone(other);
+	}
+
+	// destruct overload for the ordered map, it calls destruct on each key and value then frees the ordered map
+	template<typename TKey, typename TValue>
+	inline static void
+	destruct(Ordered_Map<TKey, TValue>& self)
+	{
+		for (auto& entry: self)
+			destruct((Key_Value<TKey, TValue>&)entry);
+		ordered_map_free(self);
+	}
+}
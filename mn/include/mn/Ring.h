@@ -8,7 +8,8 @@
 
 namespace mn
 {
-	// a ring buffer which is useful for doing queues because it can push front and back
+	// a ring buffer which is useful for doing queues because it can push front and back, the capacity is always a
+	// power of two so that wrapping an index around is a mask instead of a division
 	template<typename T>
 	struct Ring
 	{
@@ -22,14 +23,14 @@ namespace mn
 		operator[](size_t ix)
 		{
 			mn_assert(ix < count);
-			return ptr[(head + ix) % cap];
+			return ptr[(head + ix) & (cap - 1)];
 		}
 
 		inline const T&
 		operator[](size_t ix) const
 		{
 			mn_assert(ix < count);
-			return ptr[(head + ix) % cap];
+			return ptr[(head + ix) & (cap - 1)];
 		}
 	};
 
@@ -69,12 +70,12 @@ namespace mn
 	{
 		for(size_t i = 0; i < self.count; ++i)
 		{
-			destruct(self.ptr[(i + self.head) % self.cap]);
+			destruct(self.ptr[(i + self.head) & (self.cap - 1)]);
 		}
 		ring_free(self);
 	}
 
-	// ensures the ring has capacity for the given added size
+	// ensures the ring has capacity for the given added size, the capacity is rounded up to a power of two
 	template<typename T>
 	inline static void
 	ring_reserve(Ring<T>& self, size_t added_size)
@@ -85,9 +86,29 @@ namespace mn
 		if (self.allocator == nullptr)
 			self.allocator = allocator_top();
 
-		size_t next_cap = size_t(self.cap * 1.5f);
-		size_t accurate_cap = self.count + added_size;
-		size_t request_cap = next_cap > accurate_cap ? next_cap : accurate_cap;
+		size_t request_cap = self.cap ? self.cap * 2 : 8;
+		while (request_cap < self.count + added_size)
+			request_cap *= 2;
+		// try to resize the current memory first, then move the wrapped around part of the ring to the end
+		if (self.cap)
+		{
+			auto resized_block = self.allocator->realloc(Block{ self.ptr, self.cap * sizeof(T) }, request_cap * sizeof(T), alignof(T));
+			if (resized_block.ptr)
+			{
+				self.ptr = (T*)resized_block.ptr;
+				self.allocator->commit(Block{ self.ptr + self.cap, (request_cap - self.cap) * sizeof(T) });
+				if (self.head + self.count > self.cap)
+				{
+					size_t tail_count = self.cap - self.head;
+					size_t new_head = request_cap - tail_count;
+					::memmove(self.ptr + new_head, self.ptr + self.head, tail_count * sizeof(T));
+					self.head = new_head;
+				}
+				self.cap = request_cap;
+				return;
+			}
+		}
+
 		Block new_block = alloc_from(self.allocator, request_cap * sizeof(T), alignof(T));
 		if(self.count)
 		{
@@ -110,21 +131,49 @@ namespace mn
 	ring_push_back(Ring<T>& self, const R& value)
 	{
 		if(self.count == self.cap)
-			ring_reserve(self, self.cap ? 1 : 8);
+			ring_reserve(self, 1);
 
-		self.ptr[(self.head + self.count) % self.cap] = value;
+		self.ptr[(self.head + self.count) & (self.cap - 1)] = value;
 		++self.count;
 	}
 
+	// pushes the given array of values to the end of the ring buffer, the values are copied in at most two memcpy
+	// calls (one before wrapping around and one after)
+	template<typename T>
+	inline static void
+	ring_push_back_n(Ring<T>& self, const T* ptr, size_t count)
+	{
+		if (count == 0)
+			return;
+
+		ring_reserve(self, count);
+
+		size_t tail = (self.head + self.count) & (self.cap - 1);
+		size_t first_count = self.cap - tail;
+		if (first_count > count)
+			first_count = count;
+		::memcpy(self.ptr + tail, ptr, first_count * sizeof(T));
+		::memcpy(self.ptr, ptr + first_count, (count - first_count) * sizeof(T));
+		self.count += count;
+	}
+
+	// pushes the given buf of values to the end of the ring buffer
+	template<typename T>
+	inline static void
+	ring_push_back_n(Ring<T>& self, const Buf<T>& values)
+	{
+		ring_push_back_n(self, values.ptr, values.count);
+	}
+
 	// pushes a value to the front of the ring buffer
 	template<typename T, typename R>
 	inline static void
 	ring_push_front(Ring<T>& self, const R& value)
 	{
 		if(self.count == self.cap)
-			ring_reserve(self, self.cap ? 1 : 8);
+			ring_reserve(self, 1);
 
-		self.head = self.head ? self.head - 1 : self.cap - 1;
+		self.head = (self.head - 1) & (self.cap - 1);
 		self.ptr[self.head] = value;
 		++self.count;
 	}
@@ -135,7 +184,7 @@ namespace mn
 	ring_back(Ring<T>& self)
 	{
 		mn_assert(self.count > 0);
-		const size_t ix = (self.head + self.count - 1) % self.cap;
+		const size_t ix = (self.head + self.count - 1) & (self.cap - 1);
 		return self.ptr[ix];
 	}
 
@@ -145,7 +194,7 @@ namespace mn
 	ring_back(const Ring<T>& self)
 	{
 		mn_assert(self.count > 0);
-		const size_t ix = (self.head + self.count - 1) % self.cap;
+		const size_t ix = (self.head + self.count - 1) & (self.cap - 1);
 		return self.ptr[ix];
 	}
 
@@ -182,10 +231,34 @@ namespace mn
 	ring_pop_front(Ring<T>& self)
 	{
 		mn_assert(self.count > 0);
-		self.head = (self.head + 1) % self.cap;
+		self.head = (self.head + 1) & (self.cap - 1);
 		--self.count;
 	}
 
+	// pops up to the given count of values off the front of the ring and copies them into the given array (if it's
+	// not null) in at most two memcpy calls, and returns the count of popped values
+	template<typename T>
+	inline static size_t
+	ring_pop_front_n(Ring<T>& self, T* ptr, size_t count)
+	{
+		if (count > self.count)
+			count = self.count;
+		if (count == 0)
+			return 0;
+
+		size_t first_count = self.cap - self.head;
+		if (first_count > count)
+			first_count = count;
+		if (ptr)
+		{
+			::memcpy(ptr, self.ptr + self.head, first_count * sizeof(T));
+			::memcpy(ptr + first_count, self.ptr, (count - first_count) * sizeof(T));
+		}
+		self.head = (self.head + count) & (self.cap - 1);
+		self.count -= count;
+		return count;
+	}
+
 	// returns whether the given ring is empty
 	template<typename T>
 	inline static bool
@@ -0,0 +1,366 @@
+#pragma once
+
+#include "mn/Base.h"
+#include "mn/Memory.h"
+#include "mn/Buf.h"
+#include "mn/Assert.h"
+
+#include <string.h>
+
+namespace mn
+{
+	// small buffer optimized dynamic array, it stores up to N elements inline and spills to the allocator beyond that,
+	// it's useful for the many bufs which hold only a handful of elements (argument lists, path components, etc.)
+	// copying a small buf is a shallow copy just like copying a buf, the copy refers to the same buf so only one of
+	// them should be used and freed, use small_buf_clone to get an independent small buf (the elements of an inline
+	// small buf happen to be copied with the struct but that's an implementation detail which shouldn't be relied on)
+	template<typename T, size_t N = 8>
+	struct Small_Buf
+	{
+		static_assert(N > 0, "small buf inline capacity should be larger than 0");
+
+		// the allocator which this small buf uses when it spills out of the inline storage
+		Allocator allocator;
+		// count of elements that exist in this small buf
+		size_t count;
+		// capacity of the heap allocated memory, it's 0 while the elements are stored inline
+		size_t cap;
+		union
+		{
+			T* heap_ptr;
+			alignas(T) uint8_t inline_storage[N * sizeof(T)];
+		};
+
+		T&
+		operator[](size_t ix)
+		{
+			mn_assert(ix < count);
+			return (cap ? heap_ptr : (T*)inline_storage)[ix];
+		}
+
+		const T&
+		operator[](size_t ix) const
+		{
+			mn_assert(ix < count);
+			return (cap ? heap_ptr : (const T*)inline_storage)[ix];
+		}
+	};
+
+	// creates a new small buf using the default allocator
+	template<typename T, size_t N = 8>
+	inline static Small_Buf<T, N>
+	small_buf_new()
+	{
+		Small_Buf<T, N> self{};
+		self.allocator = allocator_top();
+		return self;
+	}
+
+	// creates a new small buf with a custom allocator
+	template<typename T, size_t N = 8>
+	inline static Small_Buf<T, N>
+	small_buf_with_allocator(Allocator allocator)
+	{
+		Small_Buf<T, N> self{};
+		self.allocator = allocator;
+		return self;
+	}
+
+	// returns whether the elements of the given small buf are stored inline
+	template<typename T, size_t N>
+	inline static bool
+	small_buf_is_inline(const Small_Buf<T, N>& self)
+	{
+		return self.cap == 0;
+	}
+
+	// returns the count of elements the given small buf can hold without allocating memory
+	template<typename T, size_t N>
+	inline static size_t
+	small_buf_capacity(const Small_Buf<T, N>& self)
+	{
+		return self.cap ? self.cap : N;
+	}
+
+	// returns a pointer to the elements of the given small buf
+	template<typename T, size_t N>
+	inline static T*
+	small_buf_ptr(Small_Buf<T, N>& self)
+	{
+		return self.cap ? self.heap_ptr : (T*)self.inline_storage;
+	}
+
+	// returns a pointer to the elements of the given small buf
+	template<typename T, size_t N>
+	inline static const T*
+	small_buf_ptr(const Small_Buf<T, N>& self)
+	{
+		return self.cap ? self.heap_ptr : (const T*)self.inline_storage;
+	}
+
+	// frees the given small buf, the inline storage doesn't need freeing
+	template<typename T, size_t N>
+	inline static void
+	small_buf_free(Small_Buf<T, N>& self)
+	{
+		if (self.cap && self.allocator)
+			free_from(self.allocator, Block{ self.heap_ptr, self.cap * sizeof(T) });
+		self.cap = 0;
+		self.count = 0;
+	}
+
+	// destruct overload for small buf which calls destruct on each element then frees the small buf
+	template<typename T, size_t N>
+	inline static void
+	destruct(Small_Buf<T, N>& self)
+	{
+		auto ptr = small_buf_ptr(self);
+		for (size_t i = 0; i < self.count; ++i)
+			destruct(ptr[i]);
+		small_buf_free(self);
+	}
+
+	// ensures the given small buf has the capacity to hold the added size, which might spill it to the allocator in
+	// case the current capacity can't hold the added size
+	template<typename T, size_t N>
+	inline static void
+	small_buf_reserve(Small_Buf<T, N>& self, size_t added_size)
+	{
+		size_t capacity = small_buf_capacity(self);
+		if (self.count + added_size <= capacity)
+			return;
+
+		if (self.allocator == nullptr)
+			self.allocator = allocator_top();
+
+		size_t next_cap = size_t(capacity * 1.5f);
+		size_t accurate_cap = self.count + added_size;
+		size_t request_cap = next_cap > accurate_cap ? next_cap : accurate_cap;
+
+		if (self.cap)
+		{
+			auto resized_block = self.allocator->realloc(Block{ self.heap_ptr, self.cap * sizeof(T) }, request_cap * sizeof(T), alignof(T));
+			if (resized_block.ptr)
+			{
+				self.allocator->commit(Block{ (T*)resized_block.ptr + self.cap, (request_cap - self.cap) * sizeof(T) });
+				self.heap_ptr = (T*)resized_block.ptr;
+				self.cap = request_cap;
+				return;
+			}
+		}
+
+		auto new_block = alloc_from(self.allocator, request_cap * sizeof(T), alignof(T));
+		if (self.count)
+			::memcpy(new_block.ptr, small_buf_ptr(self), self.count * sizeof(T));
+		if (self.cap)
+			free_from(self.allocator, Block{ self.heap_ptr, self.cap * sizeof(T) });
+		self.heap_ptr = (T*)new_block.ptr;
+		self.cap = request_cap;
+	}
+
+	// resizes the given small buf to the new count of elements, note: the new elements are not initialized
+	template<typename T, size_t N>
+	inline static void
+	small_buf_resize(Small_Buf<T, N>& self, size_t new_size)
+	{
+		if (new_size > self.count)
+			small_buf_reserve(self, new_size - self.count);
+		self.count = new_size;
+	}
+
+	// pushes a new value to the end of the given small buf
+	template<typename T, size_t N, typename R>
+	inline static T*
+	small_buf_push(Small_Buf<T, N>& self, const R& value)
+	{
+		if (self.count == small_buf_capacity(self))
+			small_buf_reserve(self, small_buf_capacity(self));
+
+		auto ptr = small_buf_ptr(self);
+		ptr[self.count] = T(value);
+		++self.count;
+		return ptr + self.count - 1;
+	}
+
+	// inserts a new value at a specific index
+	template<typename T, size_t N, typename R>
+	inline static T*
+	small_buf_insert(Small_Buf<T, N>& self, size_t index, const R& value)
+	{
+		mn_assert(index <= self.count);
+		if (self.count == small_buf_capacity(self))
+			small_buf_reserve(self, small_buf_capacity(self));
+
+		auto ptr = small_buf_ptr(self);
+		::memmove(ptr + index + 1, ptr + index, (self.count - index) * sizeof(T));
+		++self.count;
+		ptr[index] = T(value);
+		return ptr + index;
+	}
+
+	// pushes a range of elements to the end of the given small buf
+	template<typename T, size_t N>
+	inline static void
+	small_buf_concat(Small_Buf<T, N>& self, const T* begin, const T* end)
+	{
+		size_t added_count = end - begin;
+		size_t old_count = self.count;
+		small_buf_resize(self, old_count + added_count);
+		::memcpy(small_buf_ptr(self) + old_count, begin, added_count * sizeof(T));
+	}
+
+	// pops the last element of the small buf
+	template<typename T, size_t N>
+	inline static void
+	small_buf_pop(Small_Buf<T, N>& self)
+	{
+		mn_assert(self.count > 0);
+		--self.count;
+	}
+
+	// removes the element found at the given index (will not keep order)
+	template<typename T, size_t N>
+	inline static void
+	small_buf_remove(Small_Buf<T, N>& self, size_t ix)
+	{
+		mn_assert(ix < self.count);
+		auto ptr = small_buf_ptr(self);
+		if (ix + 1 != self.count)
+		{
+			T tmp = ptr[self.count - 1];
+			ptr[self.count - 1] = ptr[ix];
+			ptr[ix] = tmp;
+		}
+		--self.count;
+	}
+
+	// remove the value found at the given index while preserving the order of the elements in the given small buf
+	template<typename T, size_t N>
+	inline static void
+	small_buf_remove_ordered(Small_Buf<T, N>& self, size_t index)
+	{
+		mn_assert(index < self.count);
+		auto ptr = small_buf_ptr(self);
+		::memmove(ptr + index, ptr + index + 1, (self.count - index - 1) * sizeof(T));
+		--self.count;
+	}
+
+	// clears the given small buf while keeping its memory
+	template<typename T, size_t N>
+	inline static void
+	small_buf_clear(Small_Buf<T, N>& self)
+	{
+		self.count = 0;
+	}
+
+	// returns the top/last element in the given small buf
+	template<typename T, size_t N>
+	inline static const T&
+	small_buf_top(const Small_Buf<T, N>& self)
+	{
+		mn_assert(self.count > 0);
+		return small_buf_ptr(self)[self.count - 1];
+	}
+
+	// returns the top/last element in the given small buf
+	template<typename T, size_t N>
+	inline static T&
+	small_buf_top(Small_Buf<T, N>& self)
+	{
+		mn_assert(self.count > 0);
+		return small_buf_ptr(self)[self.count - 1];
+	}
+
+	// returns whether the given small buf is empty or not
+	template<typename T, size_t N>
+	inline static bool
+	small_buf_empty(const Small_Buf<T, N>& self)
+	{
+		return self.count == 0;
+	}
+
+	// returns an iterator to the start of the given small buf
+	template<typename T, size_t N>
+	inline static const T*
+	small_buf_begin(const Small_Buf<T, N>& self)
+	{
+		return small_buf_ptr(self);
+	}
+
+	// returns an iterator to the start of the given small buf
+	template<typename T, size_t N>
+	inline static T*
+	small_buf_begin(Small_Buf<T, N>& self)
+	{
+		return small_buf_ptr(self);
+	}
+
+	// returns an iterator at the end of the given small buf
+	template<typename T, size_t N>
+	inline static const T*
+	small_buf_end(const Small_Buf<T, N>& self)
+	{
+		return small_buf_ptr(self) + self.count;
+	}
+
+	// returns an iterator at the end of the given small buf
+	template<typename T, size_t N>
+	inline static T*
+	small_buf_end(Small_Buf<T, N>& self)
+	{
+		return small_buf_ptr(self) + self.count;
+	}
+
+	// begin iterator overload for small buf
+	template<typename T, size_t N>
+	inline static const T*
+	begin(const Small_Buf<T, N>& self)
+	{
+		return small_buf_begin(self);
+	}
+
+	// begin iterator overload for small buf
+	template<typename T, size_t N>
+	inline static T*
+	begin(Small_Buf<T, N>& self)
+	{
+		return small_buf_begin(self);
+	}
+
+	// end iterator overload for small buf
+	template<typename T, size_t N>
+	inline static const T*
+	end(const Small_Buf<T, N>& self)
+	{
+		return small_buf_end(self);
+	}
+
+	// end iterator overload for small buf
+	template<typename T, size_t N>
+	inline static T*
+	end(Small_Buf<T, N>& self)
+	{
+		return small_buf_end(self);
+	}
+
+	// a custom clone function for the small buf, which iterators over the elements and calls clone on each one of them
+	// thus making a deep copy of the small buf
+	template<typename T, size_t N>
+	inline static Small_Buf<T, N>
+	small_buf_clone(const Small_Buf<T, N>& other, Allocator allocator = allocator_top())
+	{
+		auto self = small_buf_with_allocator<T, N>(allocator);
+		small_buf_resize(self, other.count);
+		for (size_t i = 0; i < other.count; ++i)
+			self[i] = clone(other[i]);
+		return self;
+	}
+
+	// an overload of the general clone function which uses the custom clone function of the small buf
+	template<typename T, size_t N>
+	inline static Small_Buf<T, N>
+	clone(const Small_Buf<T, N>& other)
+	{
+		return small_buf_clone(other);
+	}
+}
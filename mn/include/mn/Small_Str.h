@@ -0,0 +1,299 @@
+#pragma once
+
+#include "mn/Exports.h"
+#include "mn/Memory.h"
+#include "mn/Str.h"
+#include "mn/Map.h"
+
+#include <string.h>
+
+namespace mn
+{
+	// inline capacity of the small string including the null terminator
+	constexpr size_t SMALL_STR_INLINE_CAPACITY = 16;
+
+	// a small string stores strings up to 15 bytes inline without allocating, it's suitable for the short strings which
+	// dominate map keys and identifiers, the inline characters share the storage of the heap pointer and capacity so
+	// it's no bigger than a string, the null terminator is maintained all the time, use small_str_view to pass it to
+	// the str functions
+	// copying a small string copies its bytes, so a heap string's copy shares the same heap buffer while an inline
+	// string's copy gets its own characters and edits to one of them don't show up in the other, in both cases only one
+	// of them should be freed, use small_str_clone to get an independent small string
+	struct Small_Str
+	{
+		// the allocator which this small string uses when it spills out of the inline storage
+		Allocator allocator;
+		// count of characters in this small string excluding the null terminator
+		size_t count: 63;
+		// whether the characters are stored in the heap allocated memory instead of the inline storage
+		size_t is_heap: 1;
+		union
+		{
+			struct
+			{
+				char* ptr;
+				// capacity of the heap allocated memory including the null terminator
+				size_t cap;
+			} heap;
+			char inline_storage[SMALL_STR_INLINE_CAPACITY];
+		};
+	};
+	static_assert(sizeof(Small_Str) <= sizeof(Str), "small string should be no bigger than a string");
+
+	// creates a new small string
+	inline static Small_Str
+	small_str_new()
+	{
+		Small_Str self{};
+		self.allocator = allocator_top();
+		return self;
+	}
+
+	// creates a new small string with the given allocator
+	inline static Small_Str
+	small_str_with_allocator(Allocator allocator)
+	{
+		Small_Str self{};
+		self.allocator = allocator;
+		return self;
+	}
+
+	// creates a new small string from the given sub string
+	MN_EXPORT Small_Str
+	small_str_from_substr(const char* begin, const char* end, Allocator allocator = allocator_top());
+
+	// creates a new small string from the given c string
+	inline static Small_Str
+	small_str_from_c(const char* str, Allocator allocator = allocator_top())
+	{
+		if (str == nullptr)
+			return small_str_with_allocator(allocator);
+		return small_str_from_substr(str, str + ::strlen(str), allocator);
+	}
+
+	// creates a new small string from the given string
+	inline static Small_Str
+	small_str_from_str(const Str& str, Allocator allocator = allocator_top())
+	{
+		return small_str_from_substr(str.ptr, str.ptr + str.count, allocator);
+	}
+
+	// frees the given small string, the inline storage doesn't need freeing
+	MN_EXPORT void
+	small_str_free(Small_Str& self);
+
+	// destruct overload for small string free
+	inline static void
+	destruct(Small_Str& self)
+	{
+		small_str_free(self);
+	}
+
+	// returns whether the characters of the given small string are stored inline
+	inline static bool
+	small_str_is_inline(const Small_Str& self)
+	{
+		return self.is_heap == 0;
+	}
+
+	// returns a pointer to the null terminated characters of the given small string
+	inline static const char*
+	small_str_ptr(const Small_Str& self)
+	{
+		return self.is_heap ? self.heap.ptr : self.inline_storage;
+	}
+
+	// returns a pointer to the null terminated characters of the given small string
+	inline static char*
+	small_str_ptr(Small_Str& self)
+	{
+		return self.is_heap ? self.heap.ptr : self.inline_storage;
+	}
+
+	// wraps the given small string into a read only string view (does not allocate) like str_lit, which is useful to
+	// call the str functions, the view is const because it may point into the inline storage of the small string so
+	// it shouldn't be modified or freed, and it's valid as long as the small string is not modified or freed
+	inline static const Str
+	small_str_view(const Small_Str& self)
+	{
+		Str res{};
+		res.ptr = (char*)small_str_ptr(self);
+		res.count = self.count;
+		res.cap = self.count + 1;
+		return res;
+	}
+
+	// resizes the given small string to the given size and maintains the null terminator
+	MN_EXPORT void
+	small_str_resize(Small_Str& self, size_t size);
+
+	// pushes the given block of bytes into the small string
+	MN_EXPORT void
+	small_str_block_push(Small_Str& self, Block block);
+
+	// pushes the given c string into the small string
+	inline static void
+	small_str_push(Small_Str& self, const char* str)
+	{
+		if (str == nullptr)
+			return;
+		small_str_block_push(self, Block{(void*)str, ::strlen(str)});
+	}
+
+	// pushes the given string into the small string
+	inline static void
+	small_str_push(Small_Str& self, const Str& str)
+	{
+		small_str_block_push(self, block_from(str));
+	}
+
+	// pushes the given small string into the small string
+	inline static void
+	small_str_push(Small_Str& self, const Small_Str& str)
+	{
+		small_str_block_push(self, Block{(void*)small_str_ptr(str), str.count});
+	}
+
+	// clears the given small string while keeping its memory
+	inline static void
+	small_str_clear(Small_Str& self)
+	{
+		small_str_resize(self, 0);
+	}
+
+	// returns a deep copy of the given small string, strings which fit inline don't allocate
+	MN_EXPORT Small_Str
+	small_str_clone(const Small_Str& other, Allocator allocator = allocator_top());
+
+	// an overload of the general clone function for the small string
+	inline static Small_Str
+	clone(const Small_Str& other)
+	{
+		return small_str_clone(other);
+	}
+
+	// compares two small strings and returns 0 if they are equal, 1 if a > b, and -1 if a < b
+	inline static int
+	small_str_cmp(const Small_Str& a, const Small_Str& b)
+	{
+		return str_cmp(small_str_view(a), small_str_view(b));
+	}
+
+	// returns whether the two small strings are equal, it compares the counts first and only compares the bytes if
+	// they match which is the common case of failing map lookups
+	inline static bool
+	small_str_equal(const Small_Str& a, const Small_Str& b)
+	{
+		if (a.count != b.count)
+			return false;
+		return ::memcmp(small_str_ptr(a), small_str_ptr(b), a.count) == 0;
+	}
+
+	// hash specialization for small strings, it's equal to the hash of a string with the same content
+	template<>
+	struct Hash<Small_Str>
+	{
+		inline size_t
+		operator()(const Small_Str& str) const
+		{
+			return str.count ? hash_bytes(small_str_ptr(str), str.count) : 0;
+		}
+	};
+
+	// stable hash specialization for small strings, it's equal to the stable hash of a string with the same content
+	template<>
+	struct Stable_Hash<Small_Str>
+	{
+		inline size_t
+		operator()(const Small_Str& str) const
+		{
+			return str.count ? hash_bytes_stable(small_str_ptr(str), str.count) : 0;
+		}
+	};
+
+	inline static bool
+	operator==(const Small_Str& a, const Small_Str& b)
+	{
+		return small_str_equal(a, b);
+	}
+
+	inline static bool
+	operator!=(const Small_Str& a, const Small_Str& b)
+	{
+		return small_str_equal(a, b) == false;
+	}
+
+	inline static bool
+	operator<(const Small_Str& a, const Small_Str& b)
+	{
+		return small_str_cmp(a, b) < 0;
+	}
+
+	inline static bool
+	operator<=(const Small_Str& a, const Small_Str& b)
+	{
+		return small_str_cmp(a, b) <= 0;
+	}
+
+	inline static bool
+	operator>(const Small_Str& a, const Small_Str& b)
+	{
+		return small_str_cmp(a, b) > 0;
+	}
+
+	inline static bool
+	operator>=(const Small_Str& a, const Small_Str& b)
+	{
+		return small_str_cmp(a, b) >= 0;
+	}
+
+
+	inline static bool
+	operator==(const Small_Str& a, const char* b)
+	{
+		return small_str_view(a) == b;
+	}
+
+	inline static bool
+	operator!=(const Small_Str& a, const char* b)
+	{
+		return small_str_view(a) != b;
+	}
+
+	inline static bool
+	operator==(const char* a, const Small_Str& b)
+	{
+		return a == small_str_view(b);
+	}
+
+	inline static bool
+	operator!=(const char* a, const Small_Str& b)
+	{
+		return a != small_str_view(b);
+	}
+
+
+	inline static bool
+	operator==(const Small_Str& a, const Str& b)
+	{
+		return small_str_view(a) == b;
+	}
+
+	inline static bool
+	operator!=(const Small_Str& a, const Str& b)
+	{
+		return small_str_view(a) != b;
+	}
+
+	inline static bool
+	operator==(const Str& a, const Small_Str& b)
+	{
+		return a == small_str_view(b);
+	}
+
+	inline static bool
+	operator!=(const Str& a, const Small_Str& b)
+	{
+		return a != small_str_view(b);
+	}
+}
@@ -0,0 +1,341 @@
+#pragma once
+
+#include "mn/Memory.h"
+#include "mn/Buf.h"
+#include "mn/Assert.h"
+
+#include <string.h>
+
+#include <utility>
+
+namespace mn
+{
+	// alignment of each field array in a soa buf, it's a cache line so the arrays don't share lines and the vector
+	// loads over them are aligned
+	constexpr size_t SOA_BUF_ALIGNMENT = 64;
+
+	// returns the type of the field at the given index
+	template<size_t I, typename T, typename... TRest>
+	struct _Soa_Field
+	{
+		using Type = typename _Soa_Field<I - 1, TRest...>::Type;
+	};
+
+	template<typename T, typename... TRest>
+	struct _Soa_Field<0, T, TRest...>
+	{
+		using Type = T;
+	};
+
+	// wraps the given type in a non deduced context, so the field values of the push functions are converted to the
+	// field types instead of being deduced from the arguments
+	template<typename T>
+	struct _Soa_Value
+	{
+		using Type = T;
+	};
+
+	// a proxy to a single row of a soa buf, use mn::soa_row_field<I>(row) to access its fields
+	template<typename... TFields>
+	struct Soa_Row
+	{
+		void* const* ptrs;
+		size_t index;
+	};
+
+	// a struct of arrays dynamic array, it's like Buf<Record> but each field of the record is stored in its own
+	// contiguous and aligned array, so the loops which only touch one or two fields don't waste memory bandwidth on the
+	// rest of the record and the compiler can vectorize them per field, all the arrays live in a single allocation
+	// mn::Soa_Buf<float, float, uint32_t> particles = mn::soa_buf_new<float, float, uint32_t>();
+	// mn::soa_buf_push(particles, 1.0f, 2.0f, 3);
+	// float* xs = mn::soa_buf_field<0>(particles);
+	template<typename... TFields>
+	struct Soa_Buf
+	{
+		static_assert(sizeof...(TFields) > 0, "soa buf should have at least one field");
+		static_assert(((alignof(TFields) <= SOA_BUF_ALIGNMENT) && ...), "soa buf field alignment is too big");
+
+		static constexpr size_t FIELDS_COUNT = sizeof...(TFields);
+
+		// the allocator which this soa buf instance uses
+		Allocator allocator;
+		// the allocated block which the field arrays are placed in after aligning them
+		Block memory;
+		// pointer to the array of each field
+		void* ptrs[FIELDS_COUNT];
+		// count of rows that exist in this soa buf
+		size_t count;
+		// capacity of rows which the allocated memory can hold
+		size_t cap;
+
+		Soa_Row<TFields...>
+		operator[](size_t ix)
+		{
+			mn_assert(ix < count);
+			return Soa_Row<TFields...>{ptrs, ix};
+		}
+
+		Soa_Row<const TFields...>
+		operator[](size_t ix) const
+		{
+			mn_assert(ix < count);
+			return Soa_Row<const TFields...>{ptrs, ix};
+		}
+	};
+
+	// returns a reference to the field at the given index of the given row
+	template<size_t I, typename... TFields>
+	inline static typename _Soa_Field<I, TFields...>::Type&
+	soa_row_field(Soa_Row<TFields...> row)
+	{
+		static_assert(I < sizeof...(TFields), "soa field index out of range");
+		using T = typename _Soa_Field<I, TFields...>::Type;
+		return ((T*)row.ptrs[I])[row.index];
+	}
+
+	// returns a pointer to the contiguous array of the field at the given index
+	template<size_t I, typename... TFields>
+	inline static typename _Soa_Field<I, TFields...>::Type*
+	soa_buf_field(Soa_Buf<TFields...>& self)
+	{
+		static_assert(I < sizeof...(TFields), "soa field index out of range");
+		return (typename _Soa_Field<I, TFields...>::Type*)self.ptrs[I];
+	}
+
+	// returns a pointer to the contiguous array of the field at the given index
+	template<size_t I, typename... TFields>
+	inline static const typename _Soa_Field<I, TFields...>::Type*
+	soa_buf_field(const Soa_Buf<TFields...>& self)
+	{
+		static_assert(I < sizeof...(TFields), "soa field index out of range");
+		return (const typename _Soa_Field<I, TFields...>::Type*)self.ptrs[I];
+	}
+
+	// calls the given function with the typed array pointer of each field in order
+	template<typename... TFields, typename TFunc, size_t... I>
+	inline static void
+	_soa_buf_each_field(Soa_Buf<TFields...>& self, TFunc&& f, std::index_sequence<I...>)
+	{
+		(f((TFields*)self.ptrs[I]), ...);
+	}
+
+	template<typename... TFields, typename TFunc>
+	inline static void
+	_soa_buf_each_field(Soa_Buf<TFields...>& self, TFunc&& f)
+	{
+		_soa_buf_each_field(self, f, std::index_sequence_for<TFields...>{});
+	}
+
+	// creates a new soa buf using the given allocator
+	template<typename... TFields>
+	inline static Soa_Buf<TFields...>
+	soa_buf_with_allocator(Allocator allocator)
+	{
+		Soa_Buf<TFields...> self{};
+		self.allocator = allocator;
+		return self;
+	}
+
+	// creates a new soa buf using the default allocator
+	template<typename... TFields>
+	inline static Soa_Buf<TFields...>
+	soa_buf_new()
+	{
+		return soa_buf_with_allocator<TFields...>(allocator_top());
+	}
+
+	// frees the given soa buf
+	template<typename... TFields>
+	inline static void
+	soa_buf_free(Soa_Buf<TFields...>& self)
+	{
+		if (self.memory.ptr)
+			free_from(self.allocator, self.memory);
+		self.memory = Block{};
+		for (auto& ptr: self.ptrs)
+			ptr = nullptr;
+		self.count = 0;
+		self.cap = 0;
+	}
+
+	// a custom overload for soa buf which loops over all the fields of all the rows and calls destruct on them
+	template<typename... TFields>
+	inline static void
+	destruct(Soa_Buf<TFields...>& self)
+	{
+		_soa_buf_each_field(self, [&](auto* ptr) {
+			for (size_t i = 0; i < self.count; ++i)
+				destruct(ptr[i]);
+		});
+		soa_buf_free(self);
+	}
+
+	// reallocates the field arrays with exactly the given capacity and copies the rows over
+	template<typename... TFields>
+	inline static void
+	_soa_buf_reserve_exact(Soa_Buf<TFields...>& self, size_t new_cap)
+	{
+		if (self.allocator == nullptr)
+			self.allocator = allocator_top();
+
+		// each array size is rounded up to the alignment so all the arrays start aligned when the first one is
+		constexpr size_t sizes[] = {sizeof(TFields)...};
+		size_t offsets[sizeof...(TFields)];
+		size_t size = 0;
+		for (size_t i = 0; i < sizeof...(TFields); ++i)
+		{
+			offsets[i] = size;
+			size += (new_cap * sizes[i] + SOA_BUF_ALIGNMENT - 1) & ~(SOA_BUF_ALIGNMENT - 1);
+		}
+
+		Block memory{};
+		auto base = (char*)alloc_aligned_from(self.allocator, size, SOA_BUF_ALIGNMENT, memory);
+		for (size_t i = 0; i < sizeof...(TFields); ++i)
+		{
+			if (self.count)
+				::memcpy(base + offsets[i], self.ptrs[i], self.count * sizes[i]);
+			self.ptrs[i] = base + offsets[i];
+		}
+
+		if (self.memory.ptr)
+			free_from(self.allocator, self.memory);
+		self.memory = memory;
+		self.cap = new_cap;
+	}
+
+	// ensures the given soa buf has the capacity to hold the added count of rows
+	template<typename... TFields>
+	inline static void
+	soa_buf_reserve(Soa_Buf<TFields...>& self, size_t added_count)
+	{
+		if (self.count + added_count <= self.cap)
+			return;
+
+		size_t next_cap = size_t(self.cap * 1.5f);
+		size_t accurate_cap = self.count + added_count;
+		_soa_buf_reserve_exact(self, next_cap > accurate_cap ? next_cap : accurate_cap);
+	}
+
+	// creates a new soa buf with the given count of rows, the rows are not initialized
+	template<typename... TFields>
+	inline static Soa_Buf<TFields...>
+	soa_buf_with_count(size_t count)
+	{
+		auto self = soa_buf_new<TFields...>();
+		soa_buf_reserve(self, count);
+		self.count = count;
+		return self;
+	}
+
+	// creates a new soa buf with the given capacity of rows
+	template<typename... TFields>
+	inline static Soa_Buf<TFields...>
+	soa_buf_with_capacity(size_t cap)
+	{
+		auto self = soa_buf_new<TFields...>();
+		soa_buf_reserve(self, cap);
+		return self;
+	}
+
+	// resizes the given soa buf to the new count of rows, the added rows are not initialized
+	template<typename... TFields>
+	inline static void
+	soa_buf_resize(Soa_Buf<TFields...>& self, size_t new_count)
+	{
+		if (new_count > self.count)
+			soa_buf_reserve(self, new_count - self.count);
+		self.count = new_count;
+	}
+
+	// clears the rows of the given soa buf, it doesn't free the memory
+	template<typename... TFields>
+	inline static void
+	soa_buf_clear(Soa_Buf<TFields...>& self)
+	{
+		self.count = 0;
+	}
+
+	// returns whether the given soa buf is empty
+	template<typename... TFields>
+	inline static bool
+	soa_buf_empty(const Soa_Buf<TFields...>& self)
+	{
+		return self.count == 0;
+	}
+
+	// pushes a new row with the given field values to the end of the given soa buf, and returns its index
+	template<typename... TFields>
+	inline static size_t
+	soa_buf_push(Soa_Buf<TFields...>& self, const typename _Soa_Value<TFields>::Type&... values)
+	{
+		if (self.count == self.cap)
+			soa_buf_reserve(self, self.cap ? self.cap : 8);
+
+		size_t i = 0;
+		((((TFields*)self.ptrs[i++])[self.count] = values), ...);
+		return self.count++;
+	}
+
+	// removes the last row of the given soa buf
+	template<typename... TFields>
+	inline static void
+	soa_buf_pop(Soa_Buf<TFields...>& self)
+	{
+		mn_assert(self.count > 0);
+		--self.count;
+	}
+
+	// removes the row at the given index by moving the last row into its place (will not keep order)
+	template<typename... TFields>
+	inline static void
+	soa_buf_remove(Soa_Buf<TFields...>& self, size_t ix)
+	{
+		mn_assert(ix < self.count);
+		auto last = self.count - 1;
+		if (ix != last)
+		{
+			_soa_buf_each_field(self, [&](auto* ptr) {
+				ptr[ix] = ptr[last];
+			});
+		}
+		--self.count;
+	}
+
+	// removes the row at the given index and shifts the rows after it (keeps order)
+	template<typename... TFields>
+	inline static void
+	soa_buf_remove_ordered(Soa_Buf<TFields...>& self, size_t ix)
+	{
+		mn_assert(ix < self.count);
+		_soa_buf_each_field(self, [&](auto* ptr) {
+			::memmove(ptr + ix, ptr + ix + 1, (self.count - ix - 1) * sizeof(*ptr));
+		});
+		--self.count;
+	}
+
+	// a custom clone function for the soa buf, which calls clone on each field of each row thus making a deep copy of
+	// the soa buf
+	template<typename... TFields>
+	inline static Soa_Buf<TFields...>
+	soa_buf_clone(const Soa_Buf<TFields...>& other, Allocator allocator = allocator_top())
+	{
+		auto self = soa_buf_with_allocator<TFields...>(allocator);
+		soa_buf_reserve(self, other.count);
+		self.count = other.count;
+		size_t field = 0;
+		_soa_buf_each_field(self, [&](auto* ptr) {
+			auto other_ptr = (decltype(ptr))other.ptrs[field++];
+			for (size_t i = 0; i < other.count; ++i)
+				ptr[i] = clone(other_ptr[i]);
+		});
+		return self;
+	}
+
+	// an overload of the general clone function which uses the custom clone function of the soa buf
+	template<typename... TFields>
+	inline static Soa_Buf<TFields...>
+	clone(const Soa_Buf<TFields...>& other)
+	{
+		return soa_buf_clone(other);
+	}
+}
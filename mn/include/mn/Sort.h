@@ -0,0 +1,678 @@
+#pragma once
+
+#include "mn/Buf.h"
+#include "mn/Memory.h"
+#include "mn/Fabric.h"
+#include "mn/Assert.h"
+
+#include <string.h>
+#include <stdint.h>
+#include <type_traits>
+#include <utility>
+
+namespace mn
+{
+	// ranges smaller than this count are sorted using insertion sort
+	constexpr size_t SORT_INSERTION_THRESHOLD = 24;
+	// ranges larger than this count use the pseudo median of 9 as pivot
+	constexpr size_t SORT_NINTHER_THRESHOLD = 128;
+	// max count of element moves before the partial insertion sort gives up
+	constexpr size_t SORT_PARTIAL_INSERTION_LIMIT = 8;
+	// count of elements which the block partition processes at a time
+	constexpr size_t SORT_BLOCK_SIZE = 64;
+	// buffers smaller than this count are sorted on the calling thread by buf_sort_parallel
+	constexpr size_t SORT_PARALLEL_THRESHOLD = 64 * 1024;
+
+	// the default less than functor which uses operator<
+	struct Sort_Less
+	{
+		template<typename T>
+		inline bool
+		operator()(const T& a, const T& b) const
+		{
+			return a < b;
+		}
+	};
+
+	template<typename T>
+	inline static void
+	_sort_swap(T& a, T& b)
+	{
+		T tmp = a;
+		a = b;
+		b = tmp;
+	}
+
+	template<typename T, typename TLess>
+	inline static void
+	_sort_insertion(T* ptr, size_t count, TLess& less)
+	{
+		for (size_t i = 1; i < count; ++i)
+		{
+			if (less(ptr[i], ptr[i - 1]) == false)
+				continue;
+
+			T tmp = ptr[i];
+			size_t j = i;
+			do
+			{
+				ptr[j] = ptr[j - 1];
+				--j;
+			} while (j > 0 && less(tmp, ptr[j - 1]));
+			ptr[j] = tmp;
+		}
+	}
+
+	template<typename T, typename TLess>
+	inline static void
+	_sort_sift_down(T* ptr, size_t root, size_t count, TLess& less)
+	{
+		T tmp = ptr[root];
+		while (true)
+		{
+			size_t child = root * 2 + 1;
+			if (child >= count)
+				break;
+			if (child + 1 < count && less(ptr[child], ptr[child + 1]))
+				++child;
+			if (less(tmp, ptr[child]) == false)
+				break;
+			ptr[root] = ptr[child];
+			root = child;
+		}
+		ptr[root] = tmp;
+	}
+
+	template<typename T, typename TLess>
+	inline static void
+	_sort_heap(T* ptr, size_t count, TLess& less)
+	{
+		for (size_t i = count / 2; i > 0; --i)
+			_sort_sift_down(ptr, i - 1, count, less);
+		for (size_t i = count - 1; i > 0; --i)
+		{
+			_sort_swap(ptr[0], ptr[i]);
+			_sort_sift_down(ptr, 0, i, less);
+		}
+	}
+
+	// sorts the three elements at the given indices in place
+	template<typename T, typename TLess>
+	inline static void
+	_sort_median3(T* ptr, size_t a, size_t b, size_t c, TLess& less)
+	{
+		if (less(ptr[b], ptr[a]))
+			_sort_swap(ptr[a], ptr[b]);
+		if (less(ptr[c], ptr[b]))
+		{
+			_sort_swap(ptr[b], ptr[c]);
+			if (less(ptr[b], ptr[a]))
+				_sort_swap(ptr[a], ptr[b]);
+		}
+	}
+
+	// insertion sort which doesn't check the start of the range, it requires the element before the range to be not
+	// greater than any element in it
+	template<typename T, typename TLess>
+	inline static void
+	_sort_insertion_unguarded(T* begin, T* end, TLess& less)
+	{
+		for (T* it = begin + 1; it < end; ++it)
+		{
+			T* sift = it;
+			T* sift_1 = it - 1;
+			if (less(*sift, *sift_1) == false)
+				continue;
+
+			T tmp = *sift;
+			do
+			{
+				*sift-- = *sift_1;
+			} while (less(tmp, *--sift_1));
+			*sift = tmp;
+		}
+	}
+
+	// insertion sort which gives up if it has to move more than a few elements, it returns whether the range is sorted
+	template<typename T, typename TLess>
+	inline static bool
+	_sort_insertion_partial(T* begin, T* end, TLess& less)
+	{
+		if (begin == end)
+			return true;
+
+		size_t moves_count = 0;
+		for (T* it = begin + 1; it < end; ++it)
+		{
+			T* sift = it;
+			T* sift_1 = it - 1;
+			if (less(*sift, *sift_1))
+			{
+				T tmp = *sift;
+				do
+				{
+					*sift-- = *sift_1;
+				} while (sift != begin && less(tmp, *--sift_1));
+				*sift = tmp;
+				moves_count += it - sift;
+			}
+
+			if (moves_count > SORT_PARTIAL_INSERTION_LIMIT)
+				return false;
+		}
+		return true;
+	}
+
+	// partitions the range around the pivot at its start, the elements which are equal to the pivot are put on the left
+	// side, it's used when the pivot is equal to the previous pivot which means the range has a lot of duplicates, it
+	// returns the position of the pivot
+	template<typename T, typename TLess>
+	inline static T*
+	_sort_partition_left(T* begin, T* end, TLess& less)
+	{
+		T pivot = *begin;
+		T* first = begin;
+		T* last = end;
+
+		while (less(pivot, *--last));
+		if (last + 1 == end)
+			while (first < last && less(pivot, *++first) == false);
+		else
+			while (less(pivot, *++first) == false);
+
+		while (first < last)
+		{
+			_sort_swap(*first, *last);
+			while (less(pivot, *--last));
+			while (less(pivot, *++first) == false);
+		}
+
+		*begin = *last;
+		*last = pivot;
+		return last;
+	}
+
+	// partitions the range around the pivot at its start, the elements which are equal to the pivot are put on the
+	// right side, it returns the position of the pivot and sets already_partitioned if no elements were swapped
+	template<typename T, typename TLess>
+	inline static T*
+	_sort_partition_right(T* begin, T* end, TLess& less, bool& already_partitioned)
+	{
+		T pivot = *begin;
+		T* first = begin;
+		T* last = end;
+
+		// the median of 3 guarantees that there's an element which is not less than the pivot at the end
+		while (less(*++first, pivot));
+		if (first - 1 == begin)
+			while (first < last && less(*--last, pivot) == false);
+		else
+			while (less(*--last, pivot) == false);
+
+		already_partitioned = first >= last;
+		if (already_partitioned == false)
+		{
+			_sort_swap(*first, *last);
+			++first;
+
+			if constexpr (std::is_arithmetic_v<T> || std::is_pointer_v<T>)
+			{
+				// block partition, the comparison results are collected into blocks of offsets without branching then
+				// the misplaced elements are swapped in bulk, this avoids the branch mispredictions of the classic
+				// partition loop which dominate the sort time of cheap to compare types
+				uint8_t offsets_l[SORT_BLOCK_SIZE];
+				uint8_t offsets_r[SORT_BLOCK_SIZE];
+				T* offsets_l_base = first;
+				T* offsets_r_base = last;
+				size_t num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+				while (first < last)
+				{
+					size_t num_unknown = last - first;
+					size_t left_split = num_l == 0 ? (num_r == 0 ? num_unknown / 2 : num_unknown) : 0;
+					size_t right_split = num_r == 0 ? (num_unknown - left_split) : 0;
+					if (left_split > SORT_BLOCK_SIZE)
+						left_split = SORT_BLOCK_SIZE;
+					if (right_split > SORT_BLOCK_SIZE)
+						right_split = SORT_BLOCK_SIZE;
+
+					for (size_t i = 0; i < left_split; ++i)
+					{
+						offsets_l[num_l] = uint8_t(i);
+						num_l += less(*first, pivot) == false;
+						++first;
+					}
+
+					for (size_t i = 0; i < right_split;)
+					{
+						offsets_r[num_r] = uint8_t(++i);
+						num_r += less(*--last, pivot);
+					}
+
+					size_t num = num_l < num_r ? num_l : num_r;
+					if (num_l == num_r)
+					{
+						// the descending inputs need proper swaps to keep the sort linear
+						for (size_t i = 0; i < num; ++i)
+							_sort_swap(offsets_l_base[offsets_l[start_l + i]], offsets_r_base[-ptrdiff_t(offsets_r[start_r + i])]);
+					}
+					else if (num > 0)
+					{
+						T* l = offsets_l_base + offsets_l[start_l];
+						T* r = offsets_r_base - offsets_r[start_r];
+						T tmp = *l;
+						*l = *r;
+						for (size_t i = 1; i < num; ++i)
+						{
+							l = offsets_l_base + offsets_l[start_l + i];
+							*r = *l;
+							r = offsets_r_base - offsets_r[start_r + i];
+							*l = *r;
+						}
+						*r = tmp;
+					}
+					num_l -= num;
+					num_r -= num;
+					start_l += num;
+					start_r += num;
+
+					if (num_l == 0)
+					{
+						start_l = 0;
+						offsets_l_base = first;
+					}
+
+					if (num_r == 0)
+					{
+						start_r = 0;
+						offsets_r_base = last;
+					}
+				}
+
+				// the remaining misplaced elements of one side are swapped into their place
+				if (num_l)
+				{
+					while (num_l--)
+						_sort_swap(offsets_l_base[offsets_l[start_l + num_l]], *--last);
+					first = last;
+				}
+				if (num_r)
+				{
+					while (num_r--)
+						_sort_swap(offsets_r_base[-ptrdiff_t(offsets_r[start_r + num_r])], *first++);
+					last = first;
+				}
+			}
+			else
+			{
+				while (first < last)
+				{
+					while (less(*first, pivot))
+						++first;
+					while (less(*--last, pivot) == false);
+					if (first >= last)
+						break;
+					_sort_swap(*first, *last);
+					++first;
+				}
+			}
+		}
+
+		T* pivot_pos = first - 1;
+		*begin = *pivot_pos;
+		*pivot_pos = pivot;
+		return pivot_pos;
+	}
+
+	// pattern defeating quick sort, a quick sort which picks the median of 3 (or the pseudo median of 9 for large
+	// ranges) as pivot, it groups the duplicates of a repeated pivot in linear time, it finishes already partitioned
+	// ranges using a bounded insertion sort which makes sorted and nearly sorted inputs linear, and if the partitions
+	// are unbalanced it shuffles some elements to break the pattern and eventually falls back to heap sort to
+	// guarantee O(n log n)
+	template<typename T, typename TLess>
+	inline static void
+	_sort_pdq(T* begin, T* end, TLess& less, size_t bad_allowed, bool leftmost)
+	{
+		while (true)
+		{
+			size_t size = end - begin;
+			if (size < SORT_INSERTION_THRESHOLD)
+			{
+				if (leftmost)
+					_sort_insertion(begin, size, less);
+				else
+					_sort_insertion_unguarded(begin, end, less);
+				return;
+			}
+
+			size_t mid = size / 2;
+			if (size > SORT_NINTHER_THRESHOLD)
+			{
+				_sort_median3(begin, 0, mid, size - 1, less);
+				_sort_median3(begin, 1, mid - 1, size - 2, less);
+				_sort_median3(begin, 2, mid + 1, size - 3, less);
+				_sort_median3(begin, mid - 1, mid, mid + 1, less);
+				_sort_swap(begin[0], begin[mid]);
+			}
+			else
+			{
+				_sort_median3(begin, mid, 0, size - 1, less);
+			}
+
+			// the pivot is equal to the previous pivot (the element before the range) so it's the smallest element in
+			// the range, we put all of its duplicates on the left and we don't need to sort them
+			if (leftmost == false && less(begin[-1], begin[0]) == false)
+			{
+				begin = _sort_partition_left(begin, end, less) + 1;
+				continue;
+			}
+
+			bool already_partitioned = false;
+			T* pivot_pos = _sort_partition_right(begin, end, less, already_partitioned);
+
+			size_t l_size = pivot_pos - begin;
+			size_t r_size = end - (pivot_pos + 1);
+			bool highly_unbalanced = l_size < size / 8 || r_size < size / 8;
+			if (highly_unbalanced)
+			{
+				if (--bad_allowed == 0)
+				{
+					_sort_heap(begin, size, less);
+					return;
+				}
+
+				if (l_size >= SORT_INSERTION_THRESHOLD)
+				{
+					_sort_swap(begin[0], begin[l_size / 4]);
+					_sort_swap(pivot_pos[-1], pivot_pos[-ptrdiff_t(l_size / 4)]);
+					if (l_size > SORT_NINTHER_THRESHOLD)
+					{
+						_sort_swap(begin[1], begin[l_size / 4 + 1]);
+						_sort_swap(begin[2], begin[l_size / 4 + 2]);
+						_sort_swap(pivot_pos[-2], pivot_pos[-ptrdiff_t(l_size / 4 + 1)]);
+						_sort_swap(pivot_pos[-3], pivot_pos[-ptrdiff_t(l_size / 4 + 2)]);
+					}
+				}
+
+				if (r_size >= SORT_INSERTION_THRESHOLD)
+				{
+					_sort_swap(pivot_pos[1], pivot_pos[1 + r_size / 4]);
+					_sort_swap(end[-1], end[-ptrdiff_t(r_size / 4)]);
+					if (r_size > SORT_NINTHER_THRESHOLD)
+					{
+						_sort_swap(pivot_pos[2], pivot_pos[2 + r_size / 4]);
+						_sort_swap(pivot_pos[3], pivot_pos[3 + r_size / 4]);
+						_sort_swap(end[-2], end[-ptrdiff_t(1 + r_size / 4)]);
+						_sort_swap(end[-3], end[-ptrdiff_t(2 + r_size / 4)]);
+					}
+				}
+			}
+			else if (already_partitioned)
+			{
+				if (_sort_insertion_partial(begin, pivot_pos, less) && _sort_insertion_partial(pivot_pos + 1, end, less))
+					return;
+			}
+
+			_sort_pdq(begin, pivot_pos, less, bad_allowed, leftmost);
+			begin = pivot_pos + 1;
+			leftmost = false;
+		}
+	}
+
+	template<typename T, typename TLess>
+	inline static void
+	_sort(T* ptr, size_t count, TLess& less)
+	{
+		if (count < 2)
+			return;
+
+		size_t bad_allowed = 0;
+		for (size_t n = count; n > 1; n >>= 1)
+			++bad_allowed;
+		_sort_pdq(ptr, ptr + count, less, bad_allowed, true);
+	}
+
+	// sorts the given buf in ascending order using operator<, the sort is not stable
+	template<typename T>
+	inline static void
+	buf_sort(Buf<T>& self)
+	{
+		Sort_Less less{};
+		_sort(self.ptr, self.count, less);
+	}
+
+	// sorts the given buf using the given less than function (`bool(const T& a, const T& b)`), the sort is not stable
+	template<typename T, typename TLess>
+	inline static void
+	buf_sort(Buf<T>& self, TLess&& less)
+	{
+		_sort(self.ptr, self.count, less);
+	}
+
+	// returns whether the given buf is sorted in ascending order using operator<
+	template<typename T>
+	inline static bool
+	buf_is_sorted(const Buf<T>& self)
+	{
+		for (size_t i = 1; i < self.count; ++i)
+			if (self[i] < self[i - 1])
+				return false;
+		return true;
+	}
+
+	// returns whether the given buf is sorted using the given less than function
+	template<typename T, typename TLess>
+	inline static bool
+	buf_is_sorted(const Buf<T>& self, TLess&& less)
+	{
+		for (size_t i = 1; i < self.count; ++i)
+			if (less(self[i], self[i - 1]))
+				return false;
+		return true;
+	}
+
+
+	// radix sort key, it maps the key into an unsigned integer of the same size with the same order, it's keyed on the
+	// size and signedness of the type instead of the fixed width typedefs so that all the integer types (char, long,
+	// long long, size_t) map to exactly one case on every platform
+	// signed integers have their sign bit flipped so that the negative ones come first, negative floats have their bits
+	// flipped so that they are ordered in reverse, and positive floats have their sign bit set so that they come after
+	// the negative ones
+	template<typename T>
+	inline static auto
+	_sort_radix_key(T v)
+	{
+		if constexpr (std::is_floating_point_v<T>)
+		{
+			static_assert(sizeof(T) == 4 || sizeof(T) == 8, "radix sort only supports 32 and 64 bit floats");
+			using TBits = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+			constexpr TBits SIGN_BIT = TBits(1) << (sizeof(T) * 8 - 1);
+			TBits bits = 0;
+			::memcpy(&bits, &v, sizeof(bits));
+			return TBits(bits ^ ((bits & SIGN_BIT) ? ~TBits(0) : SIGN_BIT));
+		}
+		else
+		{
+			static_assert(std::is_integral_v<T> && std::is_same_v<T, bool> == false, "radix sort key should be an integer or a floating point type");
+			using TBits = std::make_unsigned_t<T>;
+			if constexpr (std::is_signed_v<T>)
+				return TBits(TBits(v) ^ (TBits(1) << (sizeof(T) * 8 - 1)));
+			else
+				return TBits(v);
+		}
+	}
+
+	// sorts the given buf using LSD radix sort over the key returned by the given key function (`TKey(const T&)`) which
+	// should be an integer or a floating point type, it makes one pass per key byte and skips the bytes which are equal
+	// in all the keys, it's stable and much faster than comparison sorts for large buffers of numeric keys
+	template<typename T, typename TKeyFunc>
+	inline static void
+	buf_radix_sort(Buf<T>& self, TKeyFunc&& key)
+	{
+		using TRadix = decltype(_sort_radix_key(key(std::declval<const T&>())));
+		constexpr size_t PASSES_COUNT = sizeof(TRadix);
+
+		if (self.count < 2)
+			return;
+
+		size_t histograms[PASSES_COUNT][256] = {};
+		for (size_t i = 0; i < self.count; ++i)
+		{
+			auto k = _sort_radix_key(key(self.ptr[i]));
+			for (size_t pass = 0; pass < PASSES_COUNT; ++pass)
+				++histograms[pass][(k >> (pass * 8)) & 0xFF];
+		}
+
+		auto tmp = alloc_from(memory::clib(), self.count * sizeof(T), alignof(T));
+		T* src = self.ptr;
+		T* dst = (T*)tmp.ptr;
+		for (size_t pass = 0; pass < PASSES_COUNT; ++pass)
+		{
+			auto& histogram = histograms[pass];
+			auto first_digit = (_sort_radix_key(key(src[0])) >> (pass * 8)) & 0xFF;
+			if (histogram[first_digit] == self.count)
+				continue;
+
+			size_t offset = 0;
+			for (auto& bucket: histogram)
+			{
+				auto bucket_count = bucket;
+				bucket = offset;
+				offset += bucket_count;
+			}
+
+			for (size_t i = 0; i < self.count; ++i)
+			{
+				auto digit = (_sort_radix_key(key(src[i])) >> (pass * 8)) & 0xFF;
+				dst[histogram[digit]++] = src[i];
+			}
+			_sort_swap(src, dst);
+		}
+
+		if (src != self.ptr)
+			::memcpy(self.ptr, src, self.count * sizeof(T));
+		free_from(memory::clib(), tmp);
+	}
+
+	// sorts the given buf of integers or floating point numbers in ascending order using LSD radix sort
+	template<typename T>
+	inline static void
+	buf_radix_sort(Buf<T>& self)
+	{
+		static_assert(std::is_arithmetic_v<T>, "radix sort without a key function needs a numeric buf");
+		buf_radix_sort(self, [](const T& v) { return v; });
+	}
+
+
+	// merges the two sorted ranges into out, elements of a come first when they are equal to elements of b
+	template<typename T, typename TLess>
+	inline static void
+	_sort_merge(const T* a, size_t a_count, const T* b, size_t b_count, T* out, TLess& less)
+	{
+		size_t i = 0, j = 0;
+		while (i < a_count && j < b_count)
+		{
+			if (less(b[j], a[i]))
+				*out++ = b[j++];
+			else
+				*out++ = a[i++];
+		}
+		if (i < a_count)
+			::memcpy(out, a + i, (a_count - i) * sizeof(T));
+		if (j < b_count)
+			::memcpy(out, b + j, (b_count - j) * sizeof(T));
+	}
+
+	// returns how many elements of a are in the first `diagonal` elements of the merge of a and b, this is the merge
+	// path split which allows us to split a single merge into independent parts
+	template<typename T, typename TLess>
+	inline static size_t
+	_sort_merge_path(const T* a, size_t a_count, const T* b, size_t b_count, size_t diagonal, TLess& less)
+	{
+		size_t begin = diagonal > b_count ? diagonal - b_count : 0;
+		size_t end = diagonal < a_count ? diagonal : a_count;
+		while (begin < end)
+		{
+			size_t mid = begin + (end - begin) / 2;
+			if (less(b[diagonal - mid - 1], a[mid]))
+				end = mid;
+			else
+				begin = mid + 1;
+		}
+		return begin;
+	}
+
+	// sorts the given buf using the given less than function on the workers of the given fabric, the buf is split into
+	// chunks which are sorted in parallel, then the chunks are merged in rounds, and each merge is split further using
+	// merge path so that all the workers take part even in the last rounds, the sort is not stable, if the fabric is
+	// nullptr or the buf is small it's sorted on the calling thread
+	template<typename T, typename TLess>
+	inline static void
+	buf_sort_parallel(Fabric f, Buf<T>& self, TLess&& less)
+	{
+		size_t workers_count = f ? fabric_workers_count(f) : 1;
+		if (workers_count < 2 || self.count < SORT_PARALLEL_THRESHOLD)
+		{
+			buf_sort(self, less);
+			return;
+		}
+
+		// power of two count of chunks so that they can be merged in pairs
+		size_t chunks_count = 1;
+		while (chunks_count < workers_count && self.count / (chunks_count * 2) >= SORT_PARALLEL_THRESHOLD / 2)
+			chunks_count *= 2;
+
+		auto chunk_begin = [&](size_t index) { return self.count * index / chunks_count; };
+
+		compute(f, Compute_Dims{chunks_count, 1, 1}, Compute_Dims{1, 1, 1}, [&](Compute_Args args) {
+			auto begin = chunk_begin(args.workgroup_id.x);
+			auto end = chunk_begin(args.workgroup_id.x + 1);
+			_sort(self.ptr + begin, end - begin, less);
+		});
+
+		auto tmp = alloc_from(memory::clib(), self.count * sizeof(T), alignof(T));
+		T* src = self.ptr;
+		T* dst = (T*)tmp.ptr;
+		for (size_t width = 1; width < chunks_count; width *= 2)
+		{
+			size_t merges_count = chunks_count / (width * 2);
+			size_t segments_count = workers_count / merges_count;
+			if (segments_count == 0)
+				segments_count = 1;
+
+			compute(f, Compute_Dims{merges_count * segments_count, 1, 1}, Compute_Dims{1, 1, 1}, [&](Compute_Args args) {
+				auto merge_index = args.workgroup_id.x / segments_count;
+				auto segment_index = args.workgroup_id.x % segments_count;
+
+				auto a_begin = chunk_begin(merge_index * width * 2);
+				auto b_begin = chunk_begin(merge_index * width * 2 + width);
+				auto b_end = chunk_begin(merge_index * width * 2 + width * 2);
+				auto a = src + a_begin;
+				auto a_count = b_begin - a_begin;
+				auto b = src + b_begin;
+				auto b_count = b_end - b_begin;
+
+				auto total = a_count + b_count;
+				auto diagonal_begin = total * segment_index / segments_count;
+				auto diagonal_end = total * (segment_index + 1) / segments_count;
+				auto i_begin = _sort_merge_path(a, a_count, b, b_count, diagonal_begin, less);
+				auto i_end = _sort_merge_path(a, a_count, b, b_count, diagonal_end, less);
+				auto j_begin = diagonal_begin - i_begin;
+				auto j_end = diagonal_end - i_end;
+				_sort_merge(a + i_begin, i_end - i_begin, b + j_begin, j_end - j_begin, dst + a_begin + diagonal_begin, less);
+			});
+			_sort_swap(src, dst);
+		}
+
+		if (src != self.ptr)
+			::memcpy(self.ptr, src, self.count * sizeof(T));
+		free_from(memory::clib(), tmp);
+	}
+
+	// sorts the given buf in ascending order using operator< on the workers of the given fabric
+	template<typename T>
+	inline static void
+	buf_sort_parallel(Fabric f, Buf<T>& self)
+	{
+		buf_sort_parallel(f, self, Sort_Less{});
+	}
+}
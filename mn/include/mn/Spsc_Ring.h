@@ -0,0 +1,346 @@
+#pragma once
+
+#include "mn/Base.h"
+#include "mn/Memory.h"
+#include "mn/Thread.h"
+#include "mn/Assert.h"
+
+#include <string.h>
+
+#include <atomic>
+#include <new>
+
+namespace mn
+{
+	// the size of the cache line which the spsc ring separates its producer and consumer data on
+	constexpr size_t SPSC_RING_CACHE_LINE_SIZE = 64;
+	// count of times the blocking push and pop retry before they put the thread to sleep
+	constexpr size_t SPSC_RING_SPIN_COUNT = 128;
+
+	// a lock free single producer single consumer ring buffer, it's useful for pipelines where one thread produces
+	// values and another one consumes them (e.g. a reader thread which feeds a parser worker), exactly one thread
+	// should push and exactly one thread should pop, the producer and the consumer each own an index on its own
+	// cache line and each keeps a cached copy of the other side's index so they only touch the other side's cache
+	// line when the cached copy says the ring is full (or empty), the indices grow forever and are masked with the
+	// capacity (which is a power of two) on access, note that it copies values using memcpy
+	template<typename T>
+	struct ISpsc_Ring
+	{
+		// read only after creation, memory is the allocated block which this ring is placed in after aligning it
+		alignas(SPSC_RING_CACHE_LINE_SIZE) Allocator allocator;
+		Block memory;
+		T* ptr;
+		size_t cap;
+
+		// producer side, the index of the next value to push and the last seen consumer index
+		alignas(SPSC_RING_CACHE_LINE_SIZE) std::atomic<size_t> tail;
+		size_t cached_head;
+
+		// consumer side, the index of the next value to pop and the last seen producer index
+		alignas(SPSC_RING_CACHE_LINE_SIZE) std::atomic<size_t> head;
+		size_t cached_tail;
+
+		// blocking side, it's only written when a thread goes to sleep or the ring is closed
+		alignas(SPSC_RING_CACHE_LINE_SIZE) std::atomic<int32_t> producer_waiting;
+		std::atomic<int32_t> consumer_waiting;
+		std::atomic<bool> closed;
+	};
+	template<typename T>
+	using Spsc_Ring = ISpsc_Ring<T>*;
+
+	// creates a new spsc ring which can hold the given count of values (rounded up to a power of two)
+	template<typename T>
+	inline static Spsc_Ring<T>
+	spsc_ring_new(size_t cap, Allocator allocator = allocator_top())
+	{
+		size_t request_cap = 2;
+		while (request_cap < cap)
+			request_cap *= 2;
+
+		Block memory{};
+		auto self = ::new (alloc_aligned_from(allocator, sizeof(ISpsc_Ring<T>), SPSC_RING_CACHE_LINE_SIZE, memory)) ISpsc_Ring<T>{};
+		self->allocator = allocator;
+		self->memory = memory;
+		self->ptr = (T*)alloc_from(allocator, request_cap * sizeof(T), alignof(T)).ptr;
+		self->cap = request_cap;
+		return self;
+	}
+
+	// frees the given spsc ring, note this doesn't free any complex data structure stored in it
+	template<typename T>
+	inline static void
+	spsc_ring_free(Spsc_Ring<T> self)
+	{
+		if (self == nullptr)
+			return;
+
+		auto allocator = self->allocator;
+		auto memory = self->memory;
+		free_from(allocator, Block{self->ptr, self->cap * sizeof(T)});
+		self->~ISpsc_Ring<T>();
+		free_from(allocator, memory);
+	}
+
+	// destruct overload for spsc ring, it calls destruct on each value which wasn't popped then frees the ring
+	template<typename T>
+	inline static void
+	destruct(Spsc_Ring<T> self)
+	{
+		if (self == nullptr)
+			return;
+
+		size_t tail = self->tail.load();
+		for (size_t i = self->head.load(); i != tail; ++i)
+			destruct(self->ptr[i & (self->cap - 1)]);
+		spsc_ring_free(self);
+	}
+
+	// returns the count of values in the spsc ring, it's only a snapshot when the other thread is active
+	template<typename T>
+	inline static size_t
+	spsc_ring_count(Spsc_Ring<T> self)
+	{
+		size_t head = self->head.load(std::memory_order_acquire);
+		size_t tail = self->tail.load(std::memory_order_acquire);
+		return tail - head;
+	}
+
+	// tries to push up to the given count of values into the spsc ring and publishes them at once, it returns the count
+	// of pushed values which is less than the given count if the ring is full, it should only be called by the producer
+	template<typename T>
+	inline static size_t
+	spsc_ring_try_push_n(Spsc_Ring<T> self, const T* ptr, size_t count)
+	{
+		size_t tail = self->tail.load(std::memory_order_relaxed);
+		size_t available = self->cap - (tail - self->cached_head);
+		if (available < count)
+		{
+			self->cached_head = self->head.load(std::memory_order_acquire);
+			available = self->cap - (tail - self->cached_head);
+			if (count > available)
+				count = available;
+		}
+
+		if (count == 0)
+			return 0;
+
+		// copy the values in at most two segments, one before wrapping around and one after
+		size_t index = tail & (self->cap - 1);
+		size_t first_count = self->cap - index;
+		if (first_count > count)
+			first_count = count;
+		::memcpy(self->ptr + index, ptr, first_count * sizeof(T));
+		::memcpy(self->ptr, ptr + first_count, (count - first_count) * sizeof(T));
+
+		self->tail.store(tail + count, std::memory_order_release);
+		return count;
+	}
+
+	// tries to push the given value into the spsc ring and returns whether it succeeded, it fails if the ring is full,
+	// it should only be called by the producer
+	template<typename T>
+	inline static bool
+	spsc_ring_try_push(Spsc_Ring<T> self, const T& value)
+	{
+		size_t tail = self->tail.load(std::memory_order_relaxed);
+		if (tail - self->cached_head == self->cap)
+		{
+			self->cached_head = self->head.load(std::memory_order_acquire);
+			if (tail - self->cached_head == self->cap)
+				return false;
+		}
+
+		self->ptr[tail & (self->cap - 1)] = value;
+		self->tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// tries to pop up to the given count of values from the spsc ring into the given array and releases their slots at
+	// once, it returns the count of popped values which is less than the given count if the ring doesn't have enough
+	// values, it should only be called by the consumer
+	template<typename T>
+	inline static size_t
+	spsc_ring_try_pop_n(Spsc_Ring<T> self, T* ptr, size_t count)
+	{
+		size_t head = self->head.load(std::memory_order_relaxed);
+		size_t available = self->cached_tail - head;
+		if (available < count)
+		{
+			self->cached_tail = self->tail.load(std::memory_order_acquire);
+			available = self->cached_tail - head;
+			if (count > available)
+				count = available;
+		}
+
+		if (count == 0)
+			return 0;
+
+		size_t index = head & (self->cap - 1);
+		size_t first_count = self->cap - index;
+		if (first_count > count)
+			first_count = count;
+		::memcpy(ptr, self->ptr + index, first_count * sizeof(T));
+		::memcpy(ptr + first_count, self->ptr, (count - first_count) * sizeof(T));
+
+		self->head.store(head + count, std::memory_order_release);
+		return count;
+	}
+
+	// tries to pop a value from the spsc ring into the given value and returns whether it succeeded, it fails if the
+	// ring is empty, it should only be called by the consumer
+	template<typename T>
+	inline static bool
+	spsc_ring_try_pop(Spsc_Ring<T> self, T& value)
+	{
+		size_t head = self->head.load(std::memory_order_relaxed);
+		if (head == self->cached_tail)
+		{
+			self->cached_tail = self->tail.load(std::memory_order_acquire);
+			if (head == self->cached_tail)
+				return false;
+		}
+
+		value = self->ptr[head & (self->cap - 1)];
+		self->head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// wakes up the given side if it's sleeping, the fence orders the index store before the waiting flag load and it
+	// pairs with the fence in _spsc_ring_sleep so that either the sleeper sees the new index or we see its flag
+	inline static void
+	_spsc_ring_wake(std::atomic<int32_t>& waiting)
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (waiting.load(std::memory_order_relaxed) != 0)
+		{
+			waiting.store(0, std::memory_order_relaxed);
+			futex_wake_one(&waiting);
+		}
+	}
+
+	// puts the calling thread to sleep until the other side wakes it up, unless the given condition became true after
+	// we announced that we're going to sleep
+	template<typename TFunc>
+	inline static void
+	_spsc_ring_sleep(std::atomic<int32_t>& waiting, TFunc&& ready)
+	{
+		waiting.store(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (ready() == false)
+			futex_wait(&waiting, 1);
+		waiting.store(0, std::memory_order_relaxed);
+	}
+
+	// pushes the given values into the spsc ring, if the ring is full it blocks until the consumer pops values, it
+	// returns false if the ring is closed before all the values are pushed, it should only be called by the producer
+	// note: the blocking functions wake up the other side and the try functions don't, so if one side uses the
+	// blocking functions the other side should use them as well
+	template<typename T>
+	inline static bool
+	spsc_ring_push_n(Spsc_Ring<T> self, const T* ptr, size_t count)
+	{
+		size_t spin_count = 0;
+		while (count > 0)
+		{
+			if (self->closed.load(std::memory_order_acquire))
+				return false;
+
+			if (size_t pushed_count = spsc_ring_try_push_n(self, ptr, count))
+			{
+				_spsc_ring_wake(self->consumer_waiting);
+				ptr += pushed_count;
+				count -= pushed_count;
+				spin_count = 0;
+				continue;
+			}
+
+			if (spin_count < SPSC_RING_SPIN_COUNT)
+			{
+				++spin_count;
+				continue;
+			}
+
+			_spsc_ring_sleep(self->producer_waiting, [self]{
+				return self->tail.load(std::memory_order_relaxed) - self->head.load(std::memory_order_relaxed) < self->cap ||
+					self->closed.load(std::memory_order_relaxed);
+			});
+		}
+		return true;
+	}
+
+	// pushes the given value into the spsc ring, if the ring is full it blocks until the consumer pops a value, it
+	// returns false if the ring is closed, it should only be called by the producer
+	template<typename T>
+	inline static bool
+	spsc_ring_push(Spsc_Ring<T> self, const T& value)
+	{
+		return spsc_ring_push_n(self, &value, 1);
+	}
+
+	// pops up to the given count of values from the spsc ring into the given array, if the ring is empty it blocks
+	// until the producer pushes values, it returns the count of popped values which is 0 only if the ring is closed
+	// and empty, it should only be called by the consumer
+	template<typename T>
+	inline static size_t
+	spsc_ring_pop_n(Spsc_Ring<T> self, T* ptr, size_t count)
+	{
+		if (count == 0)
+			return 0;
+
+		size_t spin_count = 0;
+		while (true)
+		{
+			if (size_t popped_count = spsc_ring_try_pop_n(self, ptr, count))
+			{
+				_spsc_ring_wake(self->producer_waiting);
+				return popped_count;
+			}
+
+			// the producer might have pushed its last values then closed the ring so we check one more time
+			if (self->closed.load(std::memory_order_acquire))
+				return spsc_ring_try_pop_n(self, ptr, count);
+
+			if (spin_count < SPSC_RING_SPIN_COUNT)
+			{
+				++spin_count;
+				continue;
+			}
+
+			_spsc_ring_sleep(self->consumer_waiting, [self]{
+				return self->tail.load(std::memory_order_relaxed) != self->head.load(std::memory_order_relaxed) ||
+					self->closed.load(std::memory_order_relaxed);
+			});
+		}
+	}
+
+	// pops a value from the spsc ring into the given value, if the ring is empty it blocks until the producer pushes a
+	// value, it returns false if the ring is closed and empty, it should only be called by the consumer
+	template<typename T>
+	inline static bool
+	spsc_ring_pop(Spsc_Ring<T> self, T& value)
+	{
+		return spsc_ring_pop_n(self, &value, 1) == 1;
+	}
+
+	// closes the given spsc ring and wakes up any sleeping thread, after closing the producer can't push any more
+	// values and the consumer can pop the remaining values then its pops will fail
+	template<typename T>
+	inline static void
+	spsc_ring_close(Spsc_Ring<T> self)
+	{
+		self->closed.store(true, std::memory_order_release);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		self->producer_waiting.store(0, std::memory_order_relaxed);
+		self->consumer_waiting.store(0, std::memory_order_relaxed);
+		futex_wake_all(&self->producer_waiting);
+		futex_wake_all(&self->consumer_waiting);
+	}
+
+	// returns whether the given spsc ring is closed
+	template<typename T>
+	inline static bool
+	spsc_ring_closed(Spsc_Ring<T> self)
+	{
+		return self->closed.load(std::memory_order_acquire);
+	}
+}
@@ -535,7 +535,17 @@ namespace mn
 		inline size_t
 		operator()(const Str& str) const
 		{
-			return str.count ? murmur_hash(str.ptr, str.count) : 0;
+			return str.count ? hash_bytes(str.ptr, str.count) : 0;
+		}
+	};
+
+	template<>
+	struct Stable_Hash<Str>
+	{
+		inline size_t
+		operator()(const Str& str) const
+		{
+			return str.count ? hash_bytes_stable(str.ptr, str.count) : 0;
 		}
 	};
 
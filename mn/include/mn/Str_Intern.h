@@ -3,46 +3,62 @@
 #include "mn/Exports.h"
 #include "mn/Str.h"
 #include "mn/Map.h"
+#include "mn/Buf.h"
+#include "mn/Thread.h"
+#include "mn/memory/Arena.h"
 
 namespace mn
 {
+	// size of the arena chunks which the interned strings are stored in
+	constexpr size_t STR_INTERN_ARENA_BLOCK_SIZE = 64ULL * 1024ULL;
+
 	// string interning structure
 	// string interning is an operation in which all of the unique strings is stored once
 	// and every time a duplicate is encountered it returns a pointer to the same stored string
 	// it's used mainly to avoid string compare functions since all you have to do now is compare
 	// the string pointers if they are the same then they have the same content
+	// the strings bytes are stored in big arena chunks which never move so the returned pointers are stable, and each
+	// unique string gets a 32 bit id which is its index in the order of interning
 	struct Str_Intern
 	{
-		Str tmp_str;
-		Set<Str> strings;
+		Allocator allocator;
+		memory::Arena* arena;
+		// maps each interned string to its id, the keys point into the arena
+		Map<Str, uint32_t> ids;
+		// the interned strings by id
+		Buf<Str> strings;
 	};
 
-	// creates a new string interner
+	// creates a new string interner with the given allocator
 	inline static Str_Intern
-	str_intern_new()
+	str_intern_with_allocator(Allocator allocator)
 	{
-		return Str_Intern {
-			str_new(),
-			set_new<Str>()
-		};
+		Str_Intern self{};
+		self.allocator = allocator;
+		self.arena = alloc_construct_from<memory::Arena>(allocator, STR_INTERN_ARENA_BLOCK_SIZE, allocator);
+		self.ids = map_with_allocator<Str, uint32_t>(allocator);
+		self.strings = buf_with_allocator<Str>(allocator);
+		return self;
 	}
 
-	// creates a new string interner with the given allocator
+	// creates a new string interner
 	inline static Str_Intern
-	str_intern_with_allocator(Allocator allocator)
+	str_intern_new()
 	{
-		return Str_Intern {
-			str_with_allocator(allocator),
-			set_with_allocator<Str>(allocator)
-		};
+		return str_intern_with_allocator(allocator_top());
 	}
 
 	// frees the given string interner
 	inline static void
 	str_intern_free(Str_Intern& self)
 	{
-		str_free(self.tmp_str);
-		destruct(self.strings);
+		if (self.arena == nullptr)
+			return;
+
+		map_free(self.ids);
+		buf_free(self.strings);
+		free_destruct_from(self.allocator, self.arena);
+		self.arena = nullptr;
 	}
 
 	// destruct overload for string intern free
@@ -52,6 +68,20 @@ namespace mn
 		str_intern_free(self);
 	}
 
+	// returns the count of unique strings in the string interner
+	inline static size_t
+	str_intern_count(const Str_Intern& self)
+	{
+		return self.strings.count;
+	}
+
+	// returns the interned string of the given id
+	inline static Str
+	str_intern_str(const Str_Intern& self, uint32_t id)
+	{
+		return self.strings[id];
+	}
+
 	// interns the given a string and returns the string pointer to the interned string
 	MN_EXPORT const char*
 	str_intern(Str_Intern& self, const char* str);
@@ -60,7 +90,101 @@ namespace mn
 	MN_EXPORT const char*
 	str_intern(Str_Intern& self, const Str& str);
 
-	// interns the given a string and returns the string pointer to the interned string
+	// interns the given a string and returns the string pointer to the interned string, the string is hashed and
+	// compared in place so it's only copied if it's not interned yet
 	MN_EXPORT const char*
 	str_intern(Str_Intern& self, const char* begin, const char* end);
-}
\ No newline at end of file
+
+	// interns the given string and returns its id
+	MN_EXPORT uint32_t
+	str_intern_id(Str_Intern& self, const char* str);
+
+	// interns the given string and returns its id
+	MN_EXPORT uint32_t
+	str_intern_id(Str_Intern& self, const Str& str);
+
+	// interns the given string and returns its id, the string is hashed and compared in place so it's only copied if
+	// it's not interned yet
+	MN_EXPORT uint32_t
+	str_intern_id(Str_Intern& self, const char* begin, const char* end);
+
+	// default count of shards in a concurrent string interner
+	constexpr size_t CONCURRENT_STR_INTERN_DEFAULT_SHARDS_COUNT = 16;
+
+	// a thread safe string interner which is useful to share one symbol table between multiple threads (e.g. fabric
+	// workers), the strings are distributed over a power of two count of shards where each shard is a string interner
+	// with its own read-write mutex, so interning an existing string only takes a read lock, the ids are unique across
+	// the shards because the low bits of each id is the index of its shard
+	struct Concurrent_Str_Intern
+	{
+		struct alignas(64) Shard
+		{
+			Mutex_RW mtx;
+			Str_Intern intern;
+		};
+
+		Allocator allocator;
+		// the allocated block which the shards are placed in after aligning them
+		Block memory;
+		Shard* shards;
+		size_t shards_count;
+		// count of the low bits of the ids which hold the shard index
+		uint32_t shard_bits;
+	};
+
+	// creates a new concurrent string interner with the given allocator and count of shards (rounded up to a power of
+	// two)
+	MN_EXPORT Concurrent_Str_Intern
+	concurrent_str_intern_with_allocator(Allocator allocator, size_t shards_count = CONCURRENT_STR_INTERN_DEFAULT_SHARDS_COUNT);
+
+	// creates a new concurrent string interner with the given count of shards (rounded up to a power of two)
+	inline static Concurrent_Str_Intern
+	concurrent_str_intern_new(size_t shards_count = CONCURRENT_STR_INTERN_DEFAULT_SHARDS_COUNT)
+	{
+		return concurrent_str_intern_with_allocator(allocator_top(), shards_count);
+	}
+
+	// frees the given concurrent string interner
+	MN_EXPORT void
+	concurrent_str_intern_free(Concurrent_Str_Intern& self);
+
+	// destruct overload for concurrent string intern free
+	inline static void
+	destruct(Concurrent_Str_Intern& self)
+	{
+		concurrent_str_intern_free(self);
+	}
+
+	// returns the count of unique strings in the concurrent string interner, the count might be stale by the time it
+	// returns if other threads are interning strings
+	MN_EXPORT size_t
+	concurrent_str_intern_count(const Concurrent_Str_Intern& self);
+
+	// returns the interned string of the given id
+	MN_EXPORT Str
+	concurrent_str_intern_str(const Concurrent_Str_Intern& self, uint32_t id);
+
+	// interns the given a string and returns the string pointer to the interned string
+	MN_EXPORT const char*
+	concurrent_str_intern(Concurrent_Str_Intern& self, const char* str);
+
+	// interns the given a string and returns the string pointer to the interned string
+	MN_EXPORT const char*
+	concurrent_str_intern(Concurrent_Str_Intern& self, const Str& str);
+
+	// interns the given a string and returns the string pointer to the interned string
+	MN_EXPORT const char*
+	concurrent_str_intern(Concurrent_Str_Intern& self, const char* begin, const char* end);
+
+	// interns the given string and returns its id
+	MN_EXPORT uint32_t
+	concurrent_str_intern_id(Concurrent_Str_Intern& self, const char* str);
+
+	// interns the given string and returns its id
+	MN_EXPORT uint32_t
+	concurrent_str_intern_id(Concurrent_Str_Intern& self, const Str& str);
+
+	// interns the given string and returns its id
+	MN_EXPORT uint32_t
+	concurrent_str_intern_id(Concurrent_Str_Intern& self, const char* begin, const char* end);
+}
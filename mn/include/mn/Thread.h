@@ -5,6 +5,12 @@
 
 #include <stdint.h>
 
+#include <atomic>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+#endif
+
 #define mn_mutex_new_with_srcloc(name) mn::mutex_new_with_srcloc([&](const char* func_name) -> const mn::Source_Location* { const static mn::Source_Location srcloc { name, func_name, __FILE__, __LINE__, 0 }; return &srcloc; }(__FUNCTION__))
 #define mn_mutex_rw_new_with_srcloc(name) mn::mutex_rw_new_with_srcloc([&](const char* func_name) -> const mn::Source_Location* { const static mn::Source_Location srcloc { name, func_name, __FILE__, __LINE__, 0 }; return &srcloc; }(__FUNCTION__))
 
@@ -13,9 +19,6 @@ namespace mn
 	// mutex handle
 	typedef struct IMutex* Mutex;
 
-	MN_EXPORT Mutex
-	_leak_allocator_mutex();
-
 	// creates a new mutex with the given source location info, which is useful for debugging and profiling
 	MN_EXPORT Mutex
 	mutex_new_with_srcloc(const Source_Location* srcloc);
@@ -123,6 +126,30 @@ namespace mn
 	MN_EXPORT void
 	thread_sleep(uint32_t milliseconds);
 
+	// count of thread_spin_wait calls which only pause the cpu before it starts yielding the calling thread
+	constexpr size_t THREAD_SPIN_PAUSE_COUNT = 64;
+
+	// waits a little while spinning on a lock or a state which is owned by another thread, the first
+	// THREAD_SPIN_PAUSE_COUNT calls hint the cpu that this is a spin loop, and the later calls yield the rest of the time
+	// slice using thread_sleep(0) so a preempted owner gets to run, spin_count should start at 0 and each call updates it
+	inline static void
+	thread_spin_wait(size_t& spin_count)
+	{
+		if (spin_count < THREAD_SPIN_PAUSE_COUNT)
+		{
+			++spin_count;
+			#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+				_mm_pause();
+			#elif defined(__aarch64__) || defined(__arm__)
+				__asm__ __volatile__("yield");
+			#endif
+		}
+		else
+		{
+			thread_sleep(0);
+		}
+	}
+
 	// returns the id of the calling thread
 	MN_EXPORT void*
 	thread_id();
@@ -301,4 +328,18 @@ namespace mn
 			waitgroup_wait(handle);
 		}
 	};
+
+	// blocks the calling thread while the given value is equal to the expected value, it's the OS primitive (futex on
+	// linux, WaitOnAddress on windows, and ulock on mac) which the other sync primitives are built on, it might return
+	// spuriously so it should be called in a loop which rechecks the value
+	MN_EXPORT void
+	futex_wait(std::atomic<int32_t>* value, int32_t expected);
+
+	// wakes up one thread which is blocked in futex_wait on the given value
+	MN_EXPORT void
+	futex_wake_one(std::atomic<int32_t>* value);
+
+	// wakes up all the threads which are blocked in futex_wait on the given value
+	MN_EXPORT void
+	futex_wake_all(std::atomic<int32_t>* value);
 }
@@ -204,7 +204,17 @@ namespace mn
 		size_t
 		operator()(const UUID &v) const
 		{
-			return murmur_hash(Block{(void *)v.bytes, size_t(sizeof(v.bytes))});
+			return hash_bytes(v.bytes, sizeof(v.bytes));
+		}
+	};
+
+	template<>
+	struct Stable_Hash<UUID>
+	{
+		size_t
+		operator()(const UUID &v) const
+		{
+			return hash_bytes_stable(v.bytes, sizeof(v.bytes));
 		}
 	};
 } // namespace mn
@@ -20,4 +20,10 @@ namespace mn
 	// frees a block from OS virtual memory
 	MN_EXPORT void
 	virtual_free(Block block);
+
+	// resizes the given block of OS virtual memory while preserving its content, the block might be moved to another
+	// address, it returns an empty block if the OS doesn't support it or it failed, in which case the given block is
+	// still valid
+	MN_EXPORT Block
+	virtual_realloc(Block block, size_t size);
 }
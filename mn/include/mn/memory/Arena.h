@@ -24,6 +24,14 @@ namespace mn::memory
 			Node* next;
 		};
 
+		// a registered destructor, it's allocated from the arena itself and linked in reverse registration order
+		struct Destructor
+		{
+			void (*destroy)(void* ptr);
+			void* ptr;
+			Destructor* next;
+		};
+
 		struct State
 		{
 			Node* head;
@@ -31,10 +39,13 @@ namespace mn::memory
 			size_t total_mem;
 			size_t used_mem;
 			size_t highwater_mem;
+			Destructor* destructors;
 		};
 
 		Interface* meta;
 		Node* head;
+		// list of the registered destructors, the last registered one is at the head
+		Destructor* destructors;
 		// contains the block size in bytes, this is the granularity of allocation/free
 		size_t block_size;
 		// total amount of memory used in bytes, including fragmentation and other wasted memory
@@ -48,6 +59,11 @@ namespace mn::memory
 		size_t clear_all_readjust_threshold;
 		size_t clear_all_current_highwater;
 		size_t clear_all_previous_highwater;
+		// list of the nodes which were released by restore and kept for reuse instead of being freed to the meta
+		// allocator, the arena keeps at most spare_mem_cap bytes of them (default is 0 which keeps none)
+		Node* spare_head;
+		size_t spare_mem;
+		size_t spare_mem_cap;
 
 		// creates a new arena allocator with the given block size (in bytes), and the meta allocator (defaults to system malloc)
 		MN_EXPORT
@@ -73,6 +89,11 @@ namespace mn::memory
 		MN_EXPORT void
 		free(Block block) override;
 
+		// resizes the given block in place if it's the last allocation and the current node has enough space, it
+		// returns an empty block otherwise
+		MN_EXPORT Block
+		realloc(Block block, size_t size, uint8_t alignment) override;
+
 		// reserves the given amount of memory
 		MN_EXPORT void
 		grow(size_t size);
@@ -94,6 +115,11 @@ namespace mn::memory
 
 		MN_EXPORT void
 		restore(State state);
+
+		// registers the given destroy function to be called with the given ptr when the arena is cleared, freed, or
+		// restored to a checkpoint before this call, destructors are called in reverse registration order
+		MN_EXPORT void
+		destructor_register(void (*destroy)(void* ptr), void* ptr);
 	};
 }
 
@@ -133,4 +159,45 @@ namespace mn
 	{
 		self->restore(state);
 	}
+
+	// registers the given destroy function to be called with the given ptr when the arena is cleared, freed, or
+	// restored to a checkpoint before this call
+	inline static void
+	allocator_arena_destructor_register(memory::Arena* self, void (*destroy)(void* ptr), void* ptr)
+	{
+		self->destructor_register(destroy, ptr);
+	}
+
+	// a scoped arena lifetime, it takes a checkpoint of the given arena on construction and restores it on
+	// destruction which calls the destructors of all the objects constructed using arena_construct in this scope
+	// it's useful for bump allocating the whole lifetime of a request, example:
+	// {
+	// 	mn::Arena_Scope scope{arena};
+	// 	auto name = mn::arena_construct<mn::Str>(arena, mn::str_from_c("request"));
+	// 	...
+	// } // name is destructed and the arena memory is reclaimed here
+	struct Arena_Scope
+	{
+		memory::Arena* arena;
+		memory::Arena::State state;
+
+		Arena_Scope(memory::Arena* arena_)
+			:arena(arena_), state(arena_->checkpoint())
+		{}
+
+		Arena_Scope(const Arena_Scope&) = delete;
+
+		Arena_Scope(Arena_Scope&&) = delete;
+
+		Arena_Scope&
+		operator=(const Arena_Scope&) = delete;
+
+		Arena_Scope&
+		operator=(Arena_Scope&&) = delete;
+
+		~Arena_Scope()
+		{
+			arena->restore(state);
+		}
+	};
 }
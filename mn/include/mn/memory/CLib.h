@@ -27,6 +27,10 @@ namespace mn::memory
 		// frees the given block, if the block is empty it does nothing
 		MN_EXPORT void
 		free(Block block) override;
+
+		// uses realloc to resize the given block
+		MN_EXPORT Block
+		realloc(Block block, size_t size, uint8_t alignment) override;
 	};
 
 	// returns the global instance of the libc allocator
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "mn/Exports.h"
+#include "mn/memory/Interface.h"
+#include "mn/memory/Virtual.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace mn::memory
+{
+	// a thread safe buddy allocator which can be shared between multiple threads (ex. fabric workers), instead of
+	// intrusive free lists it keeps a free bitmap per order (block size) and finds free blocks using bit scans, each
+	// order has its own lock and no two locks are held at the same time, so threads allocating different sizes don't
+	// contend with each other, and a bitmask of the non empty orders lets alloc go straight to the order it will split
+	struct Concurrent_Buddy: Interface
+	{
+		// smallest block size is (2**MIN_ALLOC_LOG2) bytes
+		constexpr static inline size_t MIN_ALLOC_LOG2 = 4;
+		// size of the header which precedes each allocation and holds its order
+		constexpr static inline size_t HEADER_SIZE = 8;
+		constexpr static inline size_t MAX_ORDER_COUNT = 64;
+
+		// free blocks bitmap of a single order, block i is free if the bit (63 - i % 64) in words[i / 64] is set,
+		// summary is a second level bitmap with the same layout in which each bit indicates a non empty word, this
+		// way finding a free block is two leading_zeros scans away
+		struct alignas(64) Order
+		{
+			std::atomic_flag lock;
+			uint64_t* words;
+			uint64_t* summary;
+			size_t words_count;
+			size_t summary_count;
+			size_t free_count;
+		};
+
+		Interface* meta;
+		Block memory;
+		uint8_t* base_ptr;
+
+		// maximum allocation size is set to (2**max_alloc_log2)
+		size_t max_alloc_log2;
+		size_t max_alloc;
+
+		// order 0 is the smallest block size (2**MIN_ALLOC_LOG2) and order (order_count - 1) is the whole heap
+		size_t order_count;
+		// bit i is set if order i has at least one free block
+		std::atomic<uint64_t> nonempty_orders;
+		// splits and merges take a block out of one order before they publish the result in another order, so
+		// nonempty_orders might be empty for a moment while the heap isn't, the low 32 bits count the splits and merges
+		// in progress and the high 32 bits count the started ones, alloc only reports out of memory if it sees
+		// nonempty_orders empty while no split or merge has been in progress or started
+		std::atomic<uint64_t> pending_moves;
+		// the orders are allocated from clib aligned to the cache line, they are not stored inline because the
+		// allocator itself is allocated by allocators which don't respect its alignment
+		Block orders_memory;
+		Order* orders;
+
+		// creates a new instance of concurrent buddy allocator, the heap size is rounded up to the next power of 2
+		MN_EXPORT
+		Concurrent_Buddy(size_t heap_size, Interface* meta = virtual_mem());
+
+		// frees the given instance of the allocator
+		MN_EXPORT
+		~Concurrent_Buddy() override;
+
+		// allocates a block with the given size and alignement
+		MN_EXPORT Block
+		alloc(size_t size, uint8_t alignment) override;
+
+		// passes the call down to underlying allocator
+		MN_EXPORT void
+		commit(Block block) override;
+
+		// passes the call down to underlying allocator
+		MN_EXPORT void
+		release(Block block) override;
+
+		// frees the given block, in case the block is empty it does nothing
+		MN_EXPORT void
+		free(Block block) override;
+	};
+}
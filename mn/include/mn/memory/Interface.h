@@ -15,5 +15,9 @@ namespace mn::memory
 		virtual void commit(Block block) = 0;
 		virtual void release(Block block) = 0;
 		virtual void free(Block block) = 0;
+		// resizes the given block to the new size in place or by moving it while preserving its content, it returns
+		// an empty block if the allocator can't do that, in which case the given block is still valid and the caller
+		// should fallback to alloc, copy and free, the default implementation doesn't support it
+		virtual Block realloc(Block, size_t, uint8_t) { return {}; }
 	};
 }
@@ -5,6 +5,9 @@
 #include "mn/Base.h"
 #include "mn/Str.h"
 #include "mn/Thread.h"
+#include "mn/Stream.h"
+
+#include <atomic>
 
 #include <stdint.h>
 #include <stddef.h>
@@ -14,19 +17,44 @@ namespace mn::memory
 	// a full leak detector with call stack traces, which tracks allocations and their locations. if the program exists
 	// without freeing a block of memory it will report the leak to stderr along with the allocation location in terms
 	// of call stack and filenames and lines of each call
+	// the tracking lists are sharded by the block address so allocating threads rarely contend on the same lock, and
+	// only the raw call stack addresses are captured at allocation time, symbolization is deferred to report time
 	struct Leak: Interface
 	{
 		constexpr static inline int CALLSTACK_MAX_FRAMES = 20;
+		// count of tracking lists shards, must be power of 2
+		constexpr static inline size_t SHARD_COUNT = 64;
+
 		struct Node
 		{
 			size_t size;
+			size_t callstack_count;
 			void* callstack[CALLSTACK_MAX_FRAMES];
 			Node* next;
 			Node* prev;
 		};
 
-		Node* head;
-		Mutex mtx;
+		struct alignas(64) Shard
+		{
+			std::atomic_flag lock;
+			Node* head;
+			// count of the tracked blocks in this shard, it lets the report reserve the space of a shard's records
+			// before locking it
+			size_t count;
+		};
+
+		// controls the layout of the leak report
+		enum REPORT_MODE
+		{
+			// reports each leaked block along with its call stack and content
+			REPORT_MODE_EACH,
+			// groups the leaked blocks by their unique call stack and reports the count and bytes of each call stack
+			// sorted by leaked bytes, it's more useful when the same location leaks a lot of blocks
+			REPORT_MODE_GROUPED,
+		};
+
+		Shard shards[SHARD_COUNT];
+		REPORT_MODE report_mode;
 		bool report_on_destruct;
 
 		// creates a new instance of the leak detector allocator
@@ -56,9 +84,14 @@ namespace mn::memory
 		// prints the memory leak report, it's useful in case you want to report alive memory in a custom point before
 		// program exit, and you can indicate to it that you don't want it to report memory leaks on program exit by
 		// setting the report_on_destruct boolean to false, if you set it to true it will still report memory leaks
-		// on program exit
+		// on program exit, the report layout is controlled by report_mode
 		MN_EXPORT void
 		report(bool report_on_destruct);
+
+		// writes the memory leak report grouped by unique call stack to the given stream, it returns the count of
+		// leaked blocks
+		MN_EXPORT size_t
+		report_grouped_to(Stream out);
 	};
 
 	// returns the global instance of memory leak detector
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "mn/Exports.h"
+#include "mn/memory/Interface.h"
+#include "mn/memory/CLib.h"
+#include "mn/Base.h"
+#include "mn/Stream.h"
+
+#include <atomic>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace mn::memory
+{
+	// an opt-in statistics allocator which wraps another allocator (the meta allocator) and keeps track of live bytes,
+	// peak bytes, alloc/free counts, a histogram of allocation sizes, and a per thread breakdown of these numbers
+	// the counters are sharded per thread so wrapping a hot allocator doesn't serialize the allocating threads, you can
+	// give each subsystem its own instance to find out which one is responsible for the memory growth
+	struct Stats: Interface
+	{
+		// count of counter shards, threads are mapped to shards in round robin fashion, so in case you have more
+		// threads than shards a single shard will aggregate the numbers of multiple threads
+		constexpr static inline size_t SHARD_COUNT = 32;
+		// count of size classes, size class 0 holds allocations of size 1 byte and size class i holds allocations
+		// in the range (2^(i-1), 2^i] bytes, the last size class holds everything bigger than that
+		constexpr static inline size_t SIZE_CLASS_COUNT = 40;
+		// peak memory is re-evaluated each time a shard allocates this amount of bytes, which means that the
+		// reported peak might miss spikes which are smaller than (SHARD_COUNT * PEAK_SAMPLE_BYTES)
+		constexpr static inline size_t PEAK_SAMPLE_BYTES = 64ULL * 1024ULL;
+
+		// a snapshot of the allocator counters
+		struct Counters
+		{
+			// bytes currently allocated, it can be negative in a per thread breakdown if the thread frees memory
+			// which was allocated by other threads
+			int64_t live_bytes;
+			// peak of the live bytes, only available in the total counters
+			int64_t peak_bytes;
+			// total amount of allocated bytes over the lifetime of the allocator
+			uint64_t allocated_bytes;
+			uint64_t alloc_count;
+			uint64_t free_count;
+			uint64_t size_classes[SIZE_CLASS_COUNT];
+		};
+
+		struct alignas(64) Shard
+		{
+			// id of the first thread which used this shard
+			std::atomic<void*> thread;
+			std::atomic<int64_t> live_bytes;
+			std::atomic<uint64_t> allocated_bytes;
+			std::atomic<uint64_t> alloc_count;
+			std::atomic<uint64_t> free_count;
+			std::atomic<uint64_t> unsampled_bytes;
+			std::atomic<uint64_t> size_classes[SIZE_CLASS_COUNT];
+		};
+
+		Interface* meta;
+		const char* name;
+		std::atomic<int64_t> peak_bytes;
+		// the shards are allocated from clib aligned to the cache line, they are not stored inline because the stats
+		// allocator itself is allocated by allocators which don't respect its alignment
+		Block shards_memory;
+		Shard* shards;
+
+		// creates a new statistics allocator with the given name (should outlive the allocator) which forwards the
+		// calls to the given meta allocator (defaults to clib)
+		MN_EXPORT
+		Stats(const char* name, Interface* meta = clib());
+
+		// frees the shards of the statistics allocator
+		MN_EXPORT
+		~Stats() override;
+
+		// allocates the block from the meta allocator and records it
+		MN_EXPORT Block
+		alloc(size_t size, uint8_t alignment) override;
+
+		// passes the call down to underlying allocator
+		MN_EXPORT void
+		commit(Block block) override;
+
+		// passes the call down to underlying allocator
+		MN_EXPORT void
+		release(Block block) override;
+
+		// frees the given block to the meta allocator and records it, if the block is empty it does nothing
+		MN_EXPORT void
+		free(Block block) override;
+
+		// returns the sum of all the shards counters
+		MN_EXPORT Counters
+		snapshot();
+
+		// returns the counters of the given shard index
+		MN_EXPORT Counters
+		shard_snapshot(size_t shard_index) const;
+
+		// resets all the counters back to zero, note that it doesn't touch the live allocations so the live bytes
+		// will be off if you reset while having live allocations
+		MN_EXPORT void
+		reset();
+
+		// writes a human readable report of the counters, size classes histogram, and per thread breakdown
+		MN_EXPORT void
+		dump(Stream out);
+	};
+
+	// returns the lower bound (exclusive) and upper bound (inclusive) of the given size class in bytes
+	inline static void
+	stats_size_class_range(size_t size_class, uint64_t& lower, uint64_t& upper)
+	{
+		lower = size_class == 0 ? 0 : (1ULL << (size_class - 1));
+		upper = size_class + 1 == Stats::SIZE_CLASS_COUNT ? UINT64_MAX : (1ULL << size_class);
+	}
+}
+
+namespace mn
+{
+	// creates a new statistics allocator with the given name which wraps the given meta allocator
+	// read more about statistics allocator in Stats.h
+	inline static memory::Stats*
+	allocator_stats_new(const char* name, Allocator meta = memory::clib())
+	{
+		return alloc_construct<memory::Stats>(name, meta);
+	}
+
+	// returns a snapshot of the total counters of the given statistics allocator
+	inline static memory::Stats::Counters
+	allocator_stats_snapshot(memory::Stats* self)
+	{
+		return self->snapshot();
+	}
+
+	// writes a human readable report of the given statistics allocator to the given stream
+	inline static void
+	allocator_stats_dump(memory::Stats* self, Stream out)
+	{
+		self->dump(out);
+	}
+}
@@ -29,6 +29,10 @@ namespace mn::memory
 		// frees the given memory block, if the block is empty it does nothing
 		MN_EXPORT void
 		free(Block block) override;
+
+		// resizes the given block using mremap on linux, it returns an empty block on other platforms
+		MN_EXPORT Block
+		realloc(Block block, size_t size, uint8_t alignment) override;
 	};
 
 	// returns the global virtual memory allocator instance
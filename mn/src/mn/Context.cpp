@@ -10,7 +10,10 @@
 
 #include <fmt/color.h>
 
+#include <atomic>
+
 #include <stdio.h>
+#include <string.h>
 
 namespace mn
 {
@@ -19,6 +22,8 @@ namespace mn
 	static Thread_Profile_Interface THREAD;
 	thread_local bool PROFILING_DISABLED = false;
 
+	static std::atomic<size_t> TMP_BLOCK_SIZE_DEFAULT = Context::TMP_DEFAULT_BLOCK_SIZE;
+
 	struct Context_Wrapper
 	{
 		Context self;
@@ -31,8 +36,11 @@ namespace mn
 		~Context_Wrapper()
 		{
 			#if DEBUG
+			if (self._allocator_tmp)
+			{
 				fprintf(stderr, "Temp Allocator %p: %zu bytes used at exit, %zu bytes highwater mark\n",
-					(void*)&self._allocator_tmp, self._allocator_tmp.used_mem, self._allocator_tmp.highwater_mem);
+					(void*)self._allocator_tmp, self._allocator_tmp->used_mem, self._allocator_tmp->highwater_mem);
+			}
 			#endif
 
 			context_free(&self);
@@ -46,14 +54,29 @@ namespace mn
 		return &_CONTEXT;
 	}
 	thread_local Context* _CURRENT_CONTEXT = nullptr;
+	// cache of the current context top allocator, it's a trivial thread local so accessing it doesn't go through
+	// any thread local initialization guard
+	thread_local Allocator _CURRENT_ALLOCATOR_TOP = nullptr;
+
+	inline static void
+	_context_allocator_top_update(Context* self)
+	{
+		_CURRENT_ALLOCATOR_TOP = self->_allocator_stack[self->_allocator_stack_count - 1];
+	}
 
 
 	//API
 	void
 	context_init(Context* self)
 	{
-		for (size_t i = 0; i < Context::ALLOCATOR_CAPACITY; ++i)
-			self->_allocator_stack[i] = nullptr;
+		// the clib allocator frees the context memory when the thread exits, constructing it before the context makes
+		// sure it's destroyed after it at process exit, even if the first use of clib is the lazily created tmp arena
+		memory::clib();
+
+		for (size_t i = 0; i < Context::ALLOCATOR_INLINE_CAPACITY; ++i)
+			self->_allocator_stack_inline[i] = nullptr;
+		self->_allocator_stack = self->_allocator_stack_inline;
+		self->_allocator_stack_capacity = Context::ALLOCATOR_INLINE_CAPACITY;
 
 			#if DEBUG
 				#if MN_LEAK
@@ -66,33 +89,68 @@ namespace mn
 			#endif
 		self->_allocator_stack_count = 1;
 
-		self->reader_tmp = reader_new(nullptr, memory::clib());
+		self->_allocator_tmp = nullptr;
+		self->_allocator_tmp_block_size = TMP_BLOCK_SIZE_DEFAULT.load(std::memory_order_relaxed);
+		self->_allocator_tmp_spare_mem_cap = 0;
+
+		self->reader_tmp = nullptr;
 	}
 
 	void
 	context_free(Context* self)
 	{
-		self->_allocator_tmp.free_all();
-		reader_free(self->reader_tmp);
+		if (self->_allocator_stack != self->_allocator_stack_inline)
+		{
+			memory::clib()->free(Block{self->_allocator_stack, self->_allocator_stack_capacity * sizeof(Allocator)});
+			self->_allocator_stack = self->_allocator_stack_inline;
+			self->_allocator_stack_capacity = Context::ALLOCATOR_INLINE_CAPACITY;
+			self->_allocator_stack_count = 1;
+		}
+
+		if (self->_allocator_tmp)
+		{
+			free_destruct_from(memory::clib(), self->_allocator_tmp);
+			self->_allocator_tmp = nullptr;
+		}
+
+		if (self->reader_tmp)
+		{
+			reader_free(self->reader_tmp);
+			self->reader_tmp = nullptr;
+		}
 	}
 
 	Context*
 	context_local(Context* new_context)
 	{
 		if (_CURRENT_CONTEXT == nullptr)
+		{
 			_CURRENT_CONTEXT = &_context_wrapper()->self;
+			_context_allocator_top_update(_CURRENT_CONTEXT);
+		}
 
 		if(new_context == nullptr)
 			return _CURRENT_CONTEXT;
 
 		Context* res = _CURRENT_CONTEXT;
 		_CURRENT_CONTEXT = new_context;
+		_context_allocator_top_update(_CURRENT_CONTEXT);
 		return res;
 	}
 
+	void
+	context_tmp_block_size_default_set(size_t block_size)
+	{
+		mn_assert(block_size != 0);
+		TMP_BLOCK_SIZE_DEFAULT.store(block_size, std::memory_order_relaxed);
+	}
+
 	Allocator
 	allocator_top()
 	{
+		if (auto res = _CURRENT_ALLOCATOR_TOP)
+			return res;
+
 		Context* self = context_local();
 		return self->_allocator_stack[self->_allocator_stack_count - 1];
 	}
@@ -101,16 +159,27 @@ namespace mn
 	allocator_push(Allocator allocator)
 	{
 		Context* self = context_local();
-		mn_assert(self->_allocator_stack_count < Context::ALLOCATOR_CAPACITY);
+		if (self->_allocator_stack_count == self->_allocator_stack_capacity)
+		{
+			auto new_capacity = self->_allocator_stack_capacity * 2;
+			auto new_stack = (Allocator*)memory::clib()->alloc(new_capacity * sizeof(Allocator), alignof(Allocator)).ptr;
+			::memcpy(new_stack, self->_allocator_stack, self->_allocator_stack_count * sizeof(Allocator));
+			if (self->_allocator_stack != self->_allocator_stack_inline)
+				memory::clib()->free(Block{self->_allocator_stack, self->_allocator_stack_capacity * sizeof(Allocator)});
+			self->_allocator_stack = new_stack;
+			self->_allocator_stack_capacity = new_capacity;
+		}
 		self->_allocator_stack[self->_allocator_stack_count++] = allocator;
+		_CURRENT_ALLOCATOR_TOP = allocator;
 	}
 
 	void
 	allocator_pop()
 	{
 		Context* self = context_local();
-		mn_assert(self->_allocator_stack_count > 0);
+		mn_assert(self->_allocator_stack_count > 1);
 		--self->_allocator_stack_count;
+		_context_allocator_top_update(self);
 	}
 
 	namespace memory
@@ -118,14 +187,42 @@ namespace mn
 		Arena*
 		tmp()
 		{
-			return &context_local()->_allocator_tmp;
+			auto self = context_local();
+			if (self->_allocator_tmp == nullptr)
+			{
+				self->_allocator_tmp = alloc_construct_from<memory::Arena>(memory::clib(), self->_allocator_tmp_block_size, memory::clib());
+				self->_allocator_tmp->spare_mem_cap = self->_allocator_tmp_spare_mem_cap;
+			}
+			return self->_allocator_tmp;
+		}
+
+		void
+		tmp_block_size_set(size_t block_size)
+		{
+			mn_assert(block_size != 0);
+			auto self = context_local();
+			self->_allocator_tmp_block_size = block_size;
+			if (self->_allocator_tmp)
+				self->_allocator_tmp->block_size = block_size;
+		}
+
+		void
+		tmp_spare_mem_cap_set(size_t spare_mem_cap)
+		{
+			auto self = context_local();
+			self->_allocator_tmp_spare_mem_cap = spare_mem_cap;
+			if (self->_allocator_tmp)
+				self->_allocator_tmp->spare_mem_cap = spare_mem_cap;
 		}
 	}
 
 	Reader
 	reader_tmp()
 	{
-		return context_local()->reader_tmp;
+		auto self = context_local();
+		if (self->reader_tmp == nullptr)
+			self->reader_tmp = reader_new(nullptr, memory::clib());
+		return self->reader_tmp;
 	}
 
 	Memory_Profile_Interface
@@ -13,6 +13,7 @@ namespace mn
 {
 	constexpr static auto DEFAULT_COOP_BLOCKING_THRESHOLD = 10;
 	constexpr static auto DEFAULT_EXTR_BLOCKING_THRESHOLD = 1000;
+	constexpr static size_t DEFAULT_SCRATCH_RETAINED_MEMORY_CAP = 4ULL * 1024ULL * 1024ULL;
 
 	// Worker
 	struct IWorker
@@ -85,15 +86,36 @@ namespace mn
 		Thread sysmon;
 	};
 
+	// runs the given function in a scratch scope of the worker's tmp allocator, the tmp memory it allocates is reclaimed
+	// once it returns, the tmp allocator isn't created here so workers which never use it don't pay for it
+	template<typename TFunc>
+	inline static void
+	_worker_scratch_scope(TFunc&& f)
+	{
+		auto context = context_local();
+		// an empty state restores the tmp allocator which was created inside the function back to empty
+		memory::Arena::State checkpoint{};
+		if (context->_allocator_tmp)
+			checkpoint = context->_allocator_tmp->checkpoint();
+		f();
+		if (context->_allocator_tmp)
+			context->_allocator_tmp->restore(checkpoint);
+	}
+
 	static void
 	_worker_main(void* worker)
 	{
 		auto self = (Worker)worker;
 		LOCAL_WORKER = self;
 
+		if (self->fabric)
+			memory::tmp_spare_mem_cap_set(self->fabric->settings.scratch_retained_memory_cap);
+		else
+			memory::tmp_spare_mem_cap_set(DEFAULT_SCRATCH_RETAINED_MEMORY_CAP);
+
 		if (self->fabric)
 			if (self->fabric->settings.on_worker_start)
-				self->fabric->settings.on_worker_start();
+				_worker_scratch_scope([&]{ self->fabric->settings.on_worker_start(); });
 
 		while(true)
 		{
@@ -125,35 +147,36 @@ namespace mn
 					ring_pop_front(self->job_q);
 				}
 
-				self->atomic_job_start_time_in_ms.store(time_in_millis());
-				self->atomic_disable_block_timing = false;
-				self->atomic_current_job_kind.store(job.kind);
-				if (job.kind == Fabric_Task::KIND_TIMER)
-				{
-					job.as_timer->task();
-				}
-				else
-				{
-					fabric_task_run(job);
-				}
-				self->atomic_disable_block_timing = true;
-				self->atomic_job_start_time_in_ms.store(0);
-				self->atomic_current_job_kind.store(Fabric_Task::KIND_ONESHOT);
-				if (job.kind == Fabric_Task::KIND_TIMER)
-				{
-					// we don't free timer tasks because they are owned by fabric itself
-					[[maybe_unused]] auto count = job.as_timer->running_instances.fetch_sub(1);
-					mn_assert(count > 0);
-				}
-				else
-				{
-					fabric_task_free(job);
-				}
-				memory::tmp()->clear_all();
+				_worker_scratch_scope([&]{
+					self->atomic_job_start_time_in_ms.store(time_in_millis());
+					self->atomic_disable_block_timing = false;
+					self->atomic_current_job_kind.store(job.kind);
+					if (job.kind == Fabric_Task::KIND_TIMER)
+					{
+						job.as_timer->task();
+					}
+					else
+					{
+						fabric_task_run(job);
+					}
+					self->atomic_disable_block_timing = true;
+					self->atomic_job_start_time_in_ms.store(0);
+					self->atomic_current_job_kind.store(Fabric_Task::KIND_ONESHOT);
+					if (job.kind == Fabric_Task::KIND_TIMER)
+					{
+						// we don't free timer tasks because they are owned by fabric itself
+						[[maybe_unused]] auto count = job.as_timer->running_instances.fetch_sub(1);
+						mn_assert(count > 0);
+					}
+					else
+					{
+						fabric_task_free(job);
+					}
+				});
 				if (self->fabric)
 				{
 					if (self->fabric->settings.after_each_job)
-						self->fabric->settings.after_each_job();
+						_worker_scratch_scope([&]{ self->fabric->settings.after_each_job(); });
 					self->fabric->atomic_available_jobs.fetch_sub(1);
 					waitgroup_done(self->fabric->jobs_wg);
 				}
@@ -585,8 +608,7 @@ namespace mn
 
 					mutex_lock(min_worker->mtx);
 
-					for (auto job: tmp_jobs)
-						ring_push_back(min_worker->job_q, job);
+					ring_push_back_n(min_worker->job_q, tmp_jobs);
 					buf_clear(tmp_jobs);
 
 					mutex_unlock(min_worker->mtx);
@@ -743,9 +765,7 @@ namespace mn
 		}
 
 		mutex_lock(self->mtx);
-		ring_reserve(self->job_q, count);
-		for (size_t i = 0; i < count; ++i)
-			ring_push_back(self->job_q, ptr[i]);
+		ring_push_back_n(self->job_q, ptr, count);
 		mutex_unlock(self->mtx);
 		cond_var_notify(self->cv);
 	}
@@ -807,6 +827,10 @@ namespace mn
 			settings.put_aside_worker_count = settings.workers_count / 2;
 		if (settings.blocking_workers_threshold == 0.0f)
 			settings.blocking_workers_threshold = 0.5f;
+		if (settings.scratch_retained_memory_cap == 0)
+			settings.scratch_retained_memory_cap = DEFAULT_SCRATCH_RETAINED_MEMORY_CAP;
+		else if (settings.scratch_retained_memory_cap == FABRIC_SCRATCH_RETAIN_NOTHING)
+			settings.scratch_retained_memory_cap = 0;
 
 
 		auto self = alloc_zerod<IFabric>();
@@ -0,0 +1,502 @@
+#include "mn/Heap_Profiler.h"
+#include "mn/Memory.h"
+#include "mn/Map.h"
+#include "mn/Debug.h"
+#include "mn/Thread.h"
+#include "mn/Fmt.h"
+#include "mn/Defer.h"
+#include "mn/Assert.h"
+
+#include <atomic>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#if MN_COMPILER_MSVC
+	#include <intrin.h>
+	#define HEAP_PROFILER_NOINLINE __declspec(noinline)
+	#define HEAP_PROFILER_RETURN_ADDRESS() _ReturnAddress()
+#else
+	#define HEAP_PROFILER_NOINLINE __attribute__((noinline))
+	#define HEAP_PROFILER_RETURN_ADDRESS() __builtin_return_address(0)
+#endif
+
+namespace mn
+{
+	constexpr static size_t HEAP_PROFILER_MAX_FRAMES = 32;
+	// frames of the profiler itself (callstack_capture and the alloc hook) which we skip in case we couldn't measure
+	// the frames of the allocator interface
+	constexpr static size_t HEAP_PROFILER_DEFAULT_SKIP_FRAMES = 2;
+	constexpr static size_t HEAP_PROFILER_MAX_SKIP_FRAMES = 16;
+	constexpr static size_t HEAP_PROFILER_LIVE_TABLE_CAPACITY = 16ULL * 1024ULL;
+	constexpr static size_t HEAP_PROFILER_LIVE_TABLE_MAX_PROBE = 64;
+	static void* const HEAP_PROFILER_TOMBSTONE = (void*)uintptr_t(1);
+
+	struct Heap_Stack
+	{
+		void* frames[HEAP_PROFILER_MAX_FRAMES];
+		size_t frames_count;
+
+		bool
+		operator==(const Heap_Stack& other) const
+		{
+			return frames_count == other.frames_count &&
+				::memcmp(frames, other.frames, frames_count * sizeof(void*)) == 0;
+		}
+	};
+
+	struct Heap_Stack_Hash
+	{
+		inline size_t
+		operator()(const Heap_Stack& stack) const
+		{
+			return hash_bytes(stack.frames, stack.frames_count * sizeof(void*));
+		}
+	};
+
+	// raw sampled numbers (unscaled)
+	struct Heap_Stack_Stats
+	{
+		uint64_t inuse_count;
+		uint64_t inuse_bytes;
+		uint64_t alloc_count;
+		uint64_t alloc_bytes;
+	};
+
+	struct Heap_Live_Slot
+	{
+		std::atomic<void*> ptr;
+		size_t stack_index;
+		size_t size;
+	};
+
+	struct IHeap_Profiler
+	{
+		size_t sample_interval;
+		Mutex mtx;
+		Map<Heap_Stack, Heap_Stack_Stats, Heap_Stack_Hash> stacks;
+		uint64_t sample_count;
+		std::atomic<uint64_t> atomic_dropped_live_samples;
+		std::atomic<size_t> atomic_live_samples;
+		Heap_Live_Slot* live_table;
+		// count of the frames between the callstack capture and the caller of the allocator, which are the profiler,
+		// the memory profiling hooks, and the allocator interface frames
+		size_t skip_frames;
+		bool running;
+		Memory_Profile_Interface old_interface;
+	};
+
+	thread_local bool HEAP_PROFILER_BUSY = false;
+	thread_local bool HEAP_PROFILER_THREAD_INITIALIZED = false;
+	thread_local int64_t HEAP_PROFILER_BYTES_UNTIL_SAMPLE = 0;
+	thread_local uint64_t HEAP_PROFILER_RNG = 0;
+	// when it's set the alloc hook captures the callstack into it without sampling, it's used to measure skip_frames
+	thread_local void** HEAP_PROFILER_CALIBRATION_FRAMES = nullptr;
+	thread_local size_t HEAP_PROFILER_CALIBRATION_FRAMES_COUNT = 0;
+
+	inline static uint64_t
+	_heap_profiler_rand()
+	{
+		// xorshift64*
+		auto x = HEAP_PROFILER_RNG;
+		x ^= x >> 12;
+		x ^= x << 25;
+		x ^= x >> 27;
+		HEAP_PROFILER_RNG = x;
+		return x * 0x2545F4914F6CDD1DULL;
+	}
+
+	// returns the bytes until the next sample which is exponentially distributed with the given mean, this is what
+	// makes the samples a poisson process over the allocated bytes
+	inline static int64_t
+	_heap_profiler_next_sample(size_t sample_interval)
+	{
+		if (HEAP_PROFILER_RNG == 0)
+			HEAP_PROFILER_RNG = hash_mix(size_t(uintptr_t(thread_id())), size_t(time_in_millis())) | 1;
+
+		// uniform in (0, 1]
+		double u = double((_heap_profiler_rand() >> 11) + 1) * (1.0 / 9007199254740992.0);
+		double res = -::log(u) * double(sample_interval);
+		return int64_t(res) + 1;
+	}
+
+	// expected number of allocations which a single sample of the given average size represents
+	inline static double
+	_heap_profiler_scale(double count, double bytes, size_t sample_interval)
+	{
+		if (count == 0 || sample_interval <= 1)
+			return 1;
+		double avg_size = bytes / count;
+		return 1.0 / (1.0 - ::exp(-avg_size / double(sample_interval)));
+	}
+
+	inline static size_t
+	_heap_profiler_live_slot(void* ptr)
+	{
+		auto h = uint64_t(uintptr_t(ptr) >> 4) * 0x9E3779B97F4A7C15ULL;
+		return size_t(h >> 32) & (HEAP_PROFILER_LIVE_TABLE_CAPACITY - 1);
+	}
+
+	// inserts the given sampled pointer into the live table, it reuses the first empty or tombstone slot of the probe
+	// sequence, it should be called while holding the profiler mutex
+	inline static void
+	_heap_profiler_live_insert(Heap_Profiler self, void* ptr, size_t stack_index, size_t size)
+	{
+		auto ix = _heap_profiler_live_slot(ptr);
+		for (size_t i = 0; i < HEAP_PROFILER_LIVE_TABLE_MAX_PROBE; ++i)
+		{
+			auto& slot = self->live_table[(ix + i) & (HEAP_PROFILER_LIVE_TABLE_CAPACITY - 1)];
+			auto slot_ptr = slot.ptr.load(std::memory_order_relaxed);
+			if (slot_ptr != nullptr && slot_ptr != HEAP_PROFILER_TOMBSTONE)
+				continue;
+
+			// the pointer is not handed to the user yet, so no one can look it up until we return
+			slot.stack_index = stack_index;
+			slot.size = size;
+			slot.ptr.store(ptr, std::memory_order_release);
+			self->atomic_live_samples.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		// couldn't track it, so its free won't be observed and it will be reported as alive
+		self->atomic_dropped_live_samples.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// turns the tombstones which end with an empty slot back into empty slots, so the tombstones of the freed samples
+	// don't pile up and make the probe sequences longer over time, a live pointer is never after an empty slot in its
+	// probe sequence so the lock free lookups still find it, it should be called while holding the profiler mutex
+	inline static void
+	_heap_profiler_live_compact(Heap_Profiler self, size_t ix)
+	{
+		constexpr auto MASK = HEAP_PROFILER_LIVE_TABLE_CAPACITY - 1;
+		if (self->live_table[(ix + 1) & MASK].ptr.load(std::memory_order_relaxed) != nullptr)
+			return;
+
+		for (size_t i = 0; i < HEAP_PROFILER_LIVE_TABLE_CAPACITY; ++i)
+		{
+			auto& slot = self->live_table[(ix - i) & MASK];
+			if (slot.ptr.load(std::memory_order_relaxed) != HEAP_PROFILER_TOMBSTONE)
+				break;
+			slot.ptr.store(nullptr, std::memory_order_release);
+		}
+	}
+
+	static void
+	_heap_profiler_alloc(void* profiler, void* ptr, size_t size)
+	{
+		if (ptr == nullptr || size == 0 || HEAP_PROFILER_BUSY)
+			return;
+
+		if (HEAP_PROFILER_CALIBRATION_FRAMES)
+		{
+			HEAP_PROFILER_CALIBRATION_FRAMES_COUNT = callstack_capture(HEAP_PROFILER_CALIBRATION_FRAMES, HEAP_PROFILER_MAX_FRAMES + HEAP_PROFILER_MAX_SKIP_FRAMES);
+			return;
+		}
+
+		auto self = (Heap_Profiler)profiler;
+		if (HEAP_PROFILER_THREAD_INITIALIZED == false)
+		{
+			HEAP_PROFILER_BYTES_UNTIL_SAMPLE = _heap_profiler_next_sample(self->sample_interval);
+			HEAP_PROFILER_THREAD_INITIALIZED = true;
+		}
+
+		HEAP_PROFILER_BYTES_UNTIL_SAMPLE -= int64_t(size);
+		if (HEAP_PROFILER_BYTES_UNTIL_SAMPLE > 0)
+			return;
+
+		HEAP_PROFILER_BUSY = true;
+		mn_defer{HEAP_PROFILER_BUSY = false;};
+
+		HEAP_PROFILER_BYTES_UNTIL_SAMPLE = _heap_profiler_next_sample(self->sample_interval);
+
+		void* frames[HEAP_PROFILER_MAX_FRAMES + HEAP_PROFILER_MAX_SKIP_FRAMES];
+		auto skip_frames = self->skip_frames;
+		auto frames_count = callstack_capture(frames, HEAP_PROFILER_MAX_FRAMES + skip_frames);
+
+		Heap_Stack stack{};
+		if (frames_count > skip_frames)
+		{
+			stack.frames_count = frames_count - skip_frames;
+			::memcpy(stack.frames, frames + skip_frames, stack.frames_count * sizeof(void*));
+		}
+
+		mutex_lock(self->mtx);
+		{
+			auto it = map_lookup(self->stacks, stack);
+			if (it == nullptr)
+				it = map_insert(self->stacks, stack, Heap_Stack_Stats{});
+			it->value.inuse_count += 1;
+			it->value.inuse_bytes += size;
+			it->value.alloc_count += 1;
+			it->value.alloc_bytes += size;
+			++self->sample_count;
+			_heap_profiler_live_insert(self, ptr, it - map_begin(self->stacks), size);
+		}
+		mutex_unlock(self->mtx);
+	}
+
+	static void
+	_heap_profiler_free(void* profiler, void* ptr, size_t)
+	{
+		auto self = (Heap_Profiler)profiler;
+		if (ptr == nullptr || self->atomic_live_samples.load(std::memory_order_relaxed) == 0)
+			return;
+
+		// most of the freed pointers are not sampled so we search for it without locking first
+		auto ix = _heap_profiler_live_slot(ptr);
+		for (size_t i = 0; i < HEAP_PROFILER_LIVE_TABLE_MAX_PROBE; ++i)
+		{
+			auto slot_index = (ix + i) & (HEAP_PROFILER_LIVE_TABLE_CAPACITY - 1);
+			auto& slot = self->live_table[slot_index];
+			auto slot_ptr = slot.ptr.load(std::memory_order_acquire);
+			if (slot_ptr == nullptr)
+				return;
+
+			if (slot_ptr != ptr)
+				continue;
+
+			mutex_lock(self->mtx);
+			// the table might have been cleared before we acquired the lock
+			if (slot.ptr.load(std::memory_order_relaxed) == ptr)
+			{
+				slot.ptr.store(HEAP_PROFILER_TOMBSTONE, std::memory_order_relaxed);
+				_heap_profiler_live_compact(self, slot_index);
+				self->atomic_live_samples.fetch_sub(1, std::memory_order_relaxed);
+
+				if (slot.stack_index < self->stacks.count)
+				{
+					auto& stats = self->stacks.values[slot.stack_index].value;
+					if (stats.inuse_count > 0)
+					{
+						stats.inuse_count -= 1;
+						stats.inuse_bytes -= slot.size;
+					}
+				}
+			}
+			mutex_unlock(self->mtx);
+			return;
+		}
+	}
+
+	// measures the count of frames which the sampled callstacks should skip, it allocates through the allocator
+	// interface with the calibration frames set, and searches the captured callstack for the return address of this
+	// function, everything before this function's frame is the profiler and the allocator interface
+	HEAP_PROFILER_NOINLINE static size_t
+	_heap_profiler_calibrate(Allocator allocator)
+	{
+		void* frames[HEAP_PROFILER_MAX_FRAMES + HEAP_PROFILER_MAX_SKIP_FRAMES];
+		HEAP_PROFILER_CALIBRATION_FRAMES = frames;
+		HEAP_PROFILER_CALIBRATION_FRAMES_COUNT = 0;
+		auto block = allocator->alloc(1, alignof(char));
+		HEAP_PROFILER_CALIBRATION_FRAMES = nullptr;
+		allocator->free(block);
+
+		auto caller = HEAP_PROFILER_RETURN_ADDRESS();
+		for (size_t i = 1; i < HEAP_PROFILER_CALIBRATION_FRAMES_COUNT && i <= HEAP_PROFILER_MAX_SKIP_FRAMES; ++i)
+			if (frames[i] == caller)
+				return i - 1;
+		return HEAP_PROFILER_DEFAULT_SKIP_FRAMES;
+	}
+
+	inline static void
+	_heap_profiler_write_maps([[maybe_unused]] Stream out)
+	{
+		#if OS_LINUX
+		auto f = ::fopen("/proc/self/maps", "rb");
+		if (f == nullptr)
+			return;
+		char buffer[4096];
+		while (true)
+		{
+			auto read_size = ::fread(buffer, 1, sizeof(buffer), f);
+			if (read_size == 0)
+				break;
+			stream_write(out, Block{buffer, read_size});
+		}
+		::fclose(f);
+		#endif
+	}
+
+	// API
+	Heap_Profiler
+	heap_profiler_new(size_t sample_interval)
+	{
+		auto self = alloc_zerod_from<IHeap_Profiler>(memory::clib());
+		self->sample_interval = sample_interval > 0 ? sample_interval : 1;
+		self->mtx = mutex_new("Heap Profiler Mutex");
+		self->stacks = map_with_allocator<Heap_Stack, Heap_Stack_Stats, Heap_Stack_Hash>(memory::clib());
+		self->atomic_dropped_live_samples = 0;
+		self->atomic_live_samples = 0;
+		auto live_table_block = alloc_from(memory::clib(), HEAP_PROFILER_LIVE_TABLE_CAPACITY * sizeof(Heap_Live_Slot), alignof(Heap_Live_Slot));
+		block_zero(live_table_block);
+		self->live_table = (Heap_Live_Slot*)live_table_block.ptr;
+		self->skip_frames = HEAP_PROFILER_DEFAULT_SKIP_FRAMES;
+		return self;
+	}
+
+	void
+	heap_profiler_free(Heap_Profiler self)
+	{
+		if (self == nullptr)
+			return;
+
+		mn_assert_msg(self->running == false, "heap profiler should be stopped before it's freed");
+		HEAP_PROFILER_BUSY = true;
+		map_free(self->stacks);
+		mutex_free(self->mtx);
+		free_from(memory::clib(), Block{self->live_table, HEAP_PROFILER_LIVE_TABLE_CAPACITY * sizeof(Heap_Live_Slot)});
+		free_from(memory::clib(), self);
+		HEAP_PROFILER_BUSY = false;
+	}
+
+	void
+	heap_profiler_start(Heap_Profiler self)
+	{
+		if (self->running)
+			return;
+		self->old_interface = memory_profile_interface_set(heap_profiler_interface(self));
+		self->skip_frames = _heap_profiler_calibrate(allocator_top());
+		self->running = true;
+	}
+
+	void
+	heap_profiler_stop(Heap_Profiler self)
+	{
+		if (self->running == false)
+			return;
+		memory_profile_interface_set(self->old_interface);
+		self->running = false;
+	}
+
+	Memory_Profile_Interface
+	heap_profiler_interface(Heap_Profiler self)
+	{
+		Memory_Profile_Interface res{};
+		res.self = self;
+		res.profile_alloc = _heap_profiler_alloc;
+		res.profile_free = _heap_profiler_free;
+		return res;
+	}
+
+	void
+	heap_profiler_dump_pprof(Heap_Profiler self, Stream out)
+	{
+		HEAP_PROFILER_BUSY = true;
+		mn_defer{HEAP_PROFILER_BUSY = false;};
+
+		mutex_lock(self->mtx);
+		mn_defer{mutex_unlock(self->mtx);};
+
+		Heap_Stack_Stats total{};
+		for (const auto& [_, stats]: self->stacks)
+		{
+			total.inuse_count += stats.inuse_count;
+			total.inuse_bytes += stats.inuse_bytes;
+			total.alloc_count += stats.alloc_count;
+			total.alloc_bytes += stats.alloc_bytes;
+		}
+
+		print_to(out, "heap profile: {}: {} [{}: {}] @ heap_v2/{}\n",
+			total.inuse_count, total.inuse_bytes, total.alloc_count, total.alloc_bytes, self->sample_interval);
+
+		for (const auto& [stack, stats]: self->stacks)
+		{
+			print_to(out, "{}: {} [{}: {}] @", stats.inuse_count, stats.inuse_bytes, stats.alloc_count, stats.alloc_bytes);
+			for (size_t i = 0; i < stack.frames_count; ++i)
+				print_to(out, " {:#x}", uintptr_t(stack.frames[i]));
+			print_to(out, "\n");
+		}
+
+		print_to(out, "\nMAPPED_LIBRARIES:\n");
+		_heap_profiler_write_maps(out);
+	}
+
+	void
+	heap_profiler_dump_collapsed(Heap_Profiler self, Stream out, HEAP_PROFILE_VALUE value)
+	{
+		HEAP_PROFILER_BUSY = true;
+		mn_defer{HEAP_PROFILER_BUSY = false;};
+
+		mutex_lock(self->mtx);
+		mn_defer{mutex_unlock(self->mtx);};
+
+		for (const auto& [stack, stats]: self->stacks)
+		{
+			double count = 0, bytes = 0;
+			switch (value)
+			{
+			case HEAP_PROFILE_VALUE_INUSE_BYTES:
+				count = double(stats.inuse_count);
+				bytes = double(stats.inuse_bytes);
+				break;
+			case HEAP_PROFILE_VALUE_ALLOC_BYTES:
+				count = double(stats.alloc_count);
+				bytes = double(stats.alloc_bytes);
+				break;
+			default:
+				mn_unreachable();
+				break;
+			}
+
+			if (count == 0)
+				continue;
+
+			auto estimated_bytes = uint64_t(bytes * _heap_profiler_scale(count, bytes, self->sample_interval));
+			// collapsed stacks are written root first
+			for (size_t i = 0; i < stack.frames_count; ++i)
+			{
+				if (i > 0)
+					print_to(out, ";");
+				print_to(out, "{:#x}", uintptr_t(stack.frames[stack.frames_count - i - 1]));
+			}
+			print_to(out, " {}\n", estimated_bytes);
+		}
+	}
+
+	Heap_Profile_Summary
+	heap_profiler_summary(Heap_Profiler self)
+	{
+		mutex_lock(self->mtx);
+		mn_defer{mutex_unlock(self->mtx);};
+
+		Heap_Profile_Summary res{};
+		res.sample_count = self->sample_count;
+		res.dropped_live_samples = self->atomic_dropped_live_samples.load(std::memory_order_relaxed);
+		res.unique_callstacks = self->stacks.count;
+		for (const auto& [_, stats]: self->stacks)
+		{
+			if (stats.inuse_count > 0)
+			{
+				auto scale = _heap_profiler_scale(double(stats.inuse_count), double(stats.inuse_bytes), self->sample_interval);
+				res.inuse_count += uint64_t(double(stats.inuse_count) * scale);
+				res.inuse_bytes += uint64_t(double(stats.inuse_bytes) * scale);
+			}
+
+			if (stats.alloc_count > 0)
+			{
+				auto scale = _heap_profiler_scale(double(stats.alloc_count), double(stats.alloc_bytes), self->sample_interval);
+				res.alloc_count += uint64_t(double(stats.alloc_count) * scale);
+				res.alloc_bytes += uint64_t(double(stats.alloc_bytes) * scale);
+			}
+		}
+		return res;
+	}
+
+	void
+	heap_profiler_clear(Heap_Profiler self)
+	{
+		HEAP_PROFILER_BUSY = true;
+		mn_defer{HEAP_PROFILER_BUSY = false;};
+
+		mutex_lock(self->mtx);
+		mn_defer{mutex_unlock(self->mtx);};
+
+		for (size_t i = 0; i < HEAP_PROFILER_LIVE_TABLE_CAPACITY; ++i)
+			self->live_table[i].ptr.store(nullptr, std::memory_order_relaxed);
+		self->atomic_live_samples.store(0, std::memory_order_relaxed);
+		self->atomic_dropped_live_samples.store(0, std::memory_order_relaxed);
+		map_clear(self->stacks);
+		self->sample_count = 0;
+	}
+}
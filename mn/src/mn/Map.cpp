@@ -0,0 +1,24 @@
+#include "mn/Map.h"
+#include "mn/UUID.h"
+
+namespace mn
+{
+	uint64_t hash_seed_global = HASH_SEED_DEFAULT;
+
+	void
+	hash_seed_set(uint64_t seed)
+	{
+		hash_seed_global = seed;
+	}
+
+	void
+	hash_seed_randomize()
+	{
+		// uuid v4 is generated from the OS crypto random generator
+		auto uuid = uuid_generate();
+		uint64_t parts[2];
+		static_assert(sizeof(parts) == sizeof(uuid.bytes));
+		::memcpy(parts, uuid.bytes, sizeof(parts));
+		hash_seed_set(parts[0] ^ parts[1]);
+	}
+}
@@ -3,6 +3,8 @@
 #include "mn/Assert.h"
 #include "mn/Fmt.h"
 
+#include <math.h>
+
 namespace mn
 {
 	// regex_compiler
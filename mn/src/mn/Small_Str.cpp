@@ -0,0 +1,69 @@
+#include "mn/Small_Str.h"
+
+namespace mn
+{
+	// ensures the given small string can hold the given count of characters including the null terminator
+	inline static void
+	_small_str_reserve(Small_Str& self, size_t cap)
+	{
+		size_t old_cap = self.is_heap ? self.heap.cap : SMALL_STR_INLINE_CAPACITY;
+		if (cap <= old_cap)
+			return;
+
+		if (self.allocator == nullptr)
+			self.allocator = allocator_top();
+
+		size_t next_cap = size_t(old_cap * 1.5f);
+		size_t request_cap = next_cap > cap ? next_cap : cap;
+		auto memory = alloc_from(self.allocator, request_cap, alignof(char));
+		::memcpy(memory.ptr, small_str_ptr(self), self.count + 1);
+		if (self.is_heap)
+			free_from(self.allocator, Block{self.heap.ptr, self.heap.cap});
+		self.heap.ptr = (char*)memory.ptr;
+		self.heap.cap = request_cap;
+		self.is_heap = 1;
+	}
+
+	Small_Str
+	small_str_from_substr(const char* begin, const char* end, Allocator allocator)
+	{
+		mn_assert_msg(end >= begin, "Invalid substring");
+
+		auto self = small_str_with_allocator(allocator);
+		small_str_block_push(self, Block{(void*)begin, size_t(end - begin)});
+		return self;
+	}
+
+	void
+	small_str_free(Small_Str& self)
+	{
+		if (self.is_heap)
+			free_from(self.allocator, Block{self.heap.ptr, self.heap.cap});
+		self.is_heap = 0;
+		self.count = 0;
+		self.inline_storage[0] = '\0';
+	}
+
+	void
+	small_str_resize(Small_Str& self, size_t size)
+	{
+		_small_str_reserve(self, size + 1);
+		self.count = size;
+		small_str_ptr(self)[size] = '\0';
+	}
+
+	void
+	small_str_block_push(Small_Str& self, Block block)
+	{
+		size_t self_len = self.count;
+		small_str_resize(self, self.count + block.size);
+		if (block.size)
+			::memcpy(small_str_ptr(self) + self_len, block.ptr, block.size);
+	}
+
+	Small_Str
+	small_str_clone(const Small_Str& other, Allocator allocator)
+	{
+		return small_str_from_substr(small_str_ptr(other), small_str_ptr(other) + other.count, allocator);
+	}
+}
@@ -1,37 +1,229 @@
 #include "mn/Str_Intern.h"
 #include "mn/Assert.h"
 
+#include <string.h>
+
 namespace mn
 {
-	const char*
-	str_intern(Str_Intern& self, const char* str)
+	// returns a string which views the given bytes without copying them, it's only used as a lookup key
+	inline static Str
+	_str_intern_view(const char* ptr, size_t count)
+	{
+		Str self{};
+		self.ptr = (char*)ptr;
+		self.count = count;
+		return self;
+	}
+
+	// copies the given string into the arena and assigns the next id to it, the string shouldn't be interned already
+	inline static uint32_t
+	_str_intern_add(Str_Intern& self, const Str& view)
 	{
-		if(auto it = set_lookup(self.strings, str_lit(str)))
+		mn_assert_msg(self.strings.count < UINT32_MAX, "string interner ids overflow");
+
+		auto block = self.arena->alloc(view.count + 1, alignof(char));
+		if (view.count > 0)
+			::memcpy(block.ptr, view.ptr, view.count);
+		((char*)block.ptr)[view.count] = '\0';
+
+		Str str{};
+		str.ptr = (char*)block.ptr;
+		str.count = view.count;
+		str.cap = view.count + 1;
+		str.allocator = self.arena;
+
+		auto id = uint32_t(self.strings.count);
+		buf_push(self.strings, str);
+		map_insert(self.ids, str, id);
+		return id;
+	}
+
+	inline static uint32_t
+	_str_intern_id(Str_Intern& self, const Str& view)
+	{
+		if (auto it = map_lookup(self.ids, view))
+			return it->value;
+		return _str_intern_add(self, view);
+	}
+
+	inline static Concurrent_Str_Intern::Shard&
+	_concurrent_str_intern_shard(const Concurrent_Str_Intern& self, const Str& view)
+	{
+		return self.shards[hash_shard_index(Hash<Str>()(view), self.shards_count)];
+	}
+
+	inline static uint32_t
+	_concurrent_str_intern_id(Concurrent_Str_Intern& self, const Str& view, const char** ptr)
+	{
+		auto& shard = _concurrent_str_intern_shard(self, view);
+		auto shard_index = uint32_t(&shard - self.shards);
+
+		// fast path, most strings are already interned so we only need a read lock
+		mutex_read_lock(shard.mtx);
+		if (auto it = map_lookup(shard.intern.ids, view))
 		{
-			return it->ptr;
+			auto local_id = it->value;
+			if (ptr)
+				*ptr = shard.intern.strings[local_id].ptr;
+			mutex_read_unlock(shard.mtx);
+			return (local_id << self.shard_bits) | shard_index;
 		}
-		return set_insert(self.strings, str_from_c(str, self.tmp_str.allocator))->ptr;
+		mutex_read_unlock(shard.mtx);
+
+		// slow path, another thread might have interned the string before we acquire the write lock so we search again
+		mutex_write_lock(shard.mtx);
+		auto local_id = _str_intern_id(shard.intern, view);
+		mn_assert_msg((uint64_t(local_id) << self.shard_bits) <= UINT32_MAX, "concurrent string interner ids overflow");
+		if (ptr)
+			*ptr = shard.intern.strings[local_id].ptr;
+		mutex_write_unlock(shard.mtx);
+		return (local_id << self.shard_bits) | shard_index;
+	}
+
+	// API
+	const char*
+	str_intern(Str_Intern& self, const char* str)
+	{
+		return str_intern(self, str, str + ::strlen(str));
 	}
 
 	const char*
 	str_intern(Str_Intern& self, const Str& str)
 	{
-		if(auto it = set_lookup(self.strings, str))
+		return self.strings[_str_intern_id(self, str)].ptr;
+	}
+
+	const char*
+	str_intern(Str_Intern& self, const char* begin, const char* end)
+	{
+		mn_assert_msg(end >= begin, "Invalid SubStr");
+		return self.strings[_str_intern_id(self, _str_intern_view(begin, end - begin))].ptr;
+	}
+
+	uint32_t
+	str_intern_id(Str_Intern& self, const char* str)
+	{
+		return str_intern_id(self, str, str + ::strlen(str));
+	}
+
+	uint32_t
+	str_intern_id(Str_Intern& self, const Str& str)
+	{
+		return _str_intern_id(self, str);
+	}
+
+	uint32_t
+	str_intern_id(Str_Intern& self, const char* begin, const char* end)
+	{
+		mn_assert_msg(end >= begin, "Invalid SubStr");
+		return _str_intern_id(self, _str_intern_view(begin, end - begin));
+	}
+
+	Concurrent_Str_Intern
+	concurrent_str_intern_with_allocator(Allocator allocator, size_t shards_count)
+	{
+		using Shard = Concurrent_Str_Intern::Shard;
+
+		size_t count = 1;
+		uint32_t bits = 0;
+		while (count < shards_count)
 		{
-			return it->ptr;
+			count <<= 1;
+			++bits;
 		}
-		return set_insert(self.strings, str_clone(str, self.tmp_str.allocator))->ptr;
+
+		Concurrent_Str_Intern self{};
+		self.allocator = allocator;
+		self.shards_count = count;
+		self.shard_bits = bits;
+		self.shards = (Shard*)alloc_aligned_from(allocator, sizeof(Shard) * count, alignof(Shard), self.memory);
+		for (size_t i = 0; i < count; ++i)
+		{
+			self.shards[i].mtx = mutex_rw_new("Concurrent_Str_Intern");
+			self.shards[i].intern = str_intern_with_allocator(allocator);
+		}
+		return self;
+	}
+
+	void
+	concurrent_str_intern_free(Concurrent_Str_Intern& self)
+	{
+		if (self.shards == nullptr)
+			return;
+
+		for (size_t i = 0; i < self.shards_count; ++i)
+		{
+			mutex_rw_free(self.shards[i].mtx);
+			str_intern_free(self.shards[i].intern);
+		}
+		free_from(self.allocator, self.memory);
+		self.memory = Block{};
+		self.shards = nullptr;
+		self.shards_count = 0;
+	}
+
+	size_t
+	concurrent_str_intern_count(const Concurrent_Str_Intern& self)
+	{
+		size_t res = 0;
+		for (size_t i = 0; i < self.shards_count; ++i)
+		{
+			mutex_read_lock(self.shards[i].mtx);
+			res += str_intern_count(self.shards[i].intern);
+			mutex_read_unlock(self.shards[i].mtx);
+		}
+		return res;
+	}
+
+	Str
+	concurrent_str_intern_str(const Concurrent_Str_Intern& self, uint32_t id)
+	{
+		auto& shard = self.shards[id & (self.shards_count - 1)];
+		mutex_read_lock(shard.mtx);
+		auto res = str_intern_str(shard.intern, id >> self.shard_bits);
+		mutex_read_unlock(shard.mtx);
+		return res;
 	}
 
 	const char*
-	str_intern(Str_Intern& self, const char* begin, const char* end)
+	concurrent_str_intern(Concurrent_Str_Intern& self, const char* str)
+	{
+		return concurrent_str_intern(self, str, str + ::strlen(str));
+	}
+
+	const char*
+	concurrent_str_intern(Concurrent_Str_Intern& self, const Str& str)
+	{
+		const char* res = nullptr;
+		_concurrent_str_intern_id(self, str, &res);
+		return res;
+	}
+
+	const char*
+	concurrent_str_intern(Concurrent_Str_Intern& self, const char* begin, const char* end)
+	{
+		mn_assert_msg(end >= begin, "Invalid SubStr");
+		const char* res = nullptr;
+		_concurrent_str_intern_id(self, _str_intern_view(begin, end - begin), &res);
+		return res;
+	}
+
+	uint32_t
+	concurrent_str_intern_id(Concurrent_Str_Intern& self, const char* str)
+	{
+		return concurrent_str_intern_id(self, str, str + ::strlen(str));
+	}
+
+	uint32_t
+	concurrent_str_intern_id(Concurrent_Str_Intern& self, const Str& str)
+	{
+		return _concurrent_str_intern_id(self, str, nullptr);
+	}
+
+	uint32_t
+	concurrent_str_intern_id(Concurrent_Str_Intern& self, const char* begin, const char* end)
 	{
 		mn_assert_msg(end >= begin, "Invalid SubStr");
-		str_clear(self.tmp_str);
-		buf_resize(self.tmp_str, end - begin + 1);
-		--self.tmp_str.count;
-		::memcpy(self.tmp_str.ptr, begin, self.tmp_str.count);
-		self.tmp_str.ptr[self.tmp_str.count] = '\0';
-		return str_intern(self, self.tmp_str);
-	}
-}
\ No newline at end of file
+		return _concurrent_str_intern_id(self, _str_intern_view(begin, end - begin), nullptr);
+	}
+}
@@ -33,4 +33,14 @@ namespace mn
 	{
 		munmap(block.ptr, block.size);
 	}
+
+	Block
+	virtual_realloc(Block block, size_t size)
+	{
+		// mremap fails if the block spans multiple mappings (ex. partially committed block)
+		auto ptr = mremap(block.ptr, block.size, size, MREMAP_MAYMOVE);
+		if (ptr == MAP_FAILED)
+			return {};
+		return Block{ptr, size};
+	}
 }
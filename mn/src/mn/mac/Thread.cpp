@@ -19,40 +19,16 @@
 
 #include <chrono>
 
+// the ulock functions are the futex like primitive of darwin, they are not in the public headers but they are what
+// libc++ uses to implement std::atomic::wait
+extern "C" int __ulock_wait(uint32_t operation, void* addr, uint64_t value, uint32_t timeout);
+extern "C" int __ulock_wake(uint32_t operation, void* addr, uint64_t wake_value);
+#define UL_COMPARE_AND_WAIT 1
+#define ULF_WAKE_ALL 0x00000100
+#define ULF_NO_ERRNO 0x01000000
+
 namespace mn
 {
-	struct Leak_Allocator_Mutex
-	{
-		Source_Location srcloc;
-		IMutex self;
-
-		Leak_Allocator_Mutex()
-		{
-			srcloc.name = "allocators mutex";
-			srcloc.function = "mn::_leak_allocator_mutex";
-			srcloc.file = __FILE__;
-			srcloc.line = __LINE__;
-			srcloc.color = 0;
-			self.name = srcloc.name;
-			self.srcloc = &srcloc;
-			[[maybe_unused]] int result = pthread_mutex_init(&self.handle, NULL);
-			mn_assert(result == 0);
-			self.profile_user_data = _mutex_new(&self, self.name);
-		}
-
-		~Leak_Allocator_Mutex()
-		{
-			_mutex_free(&self, self.profile_user_data);
-		}
-	};
-
-	Mutex
-	_leak_allocator_mutex()
-	{
-		static Leak_Allocator_Mutex mtx;
-		return &mtx.self;
-	}
-
 	static void
 	ms2ts(struct timespec *ts, unsigned long ms)
 	{
@@ -748,4 +724,25 @@ namespace mn
 
 		return self->count;
 	}
+
+	void
+	futex_wait(std::atomic<int32_t>* value, int32_t expected)
+	{
+		worker_block_ahead();
+		mn_defer{worker_block_clear();};
+
+		__ulock_wait(UL_COMPARE_AND_WAIT | ULF_NO_ERRNO, (void*)value, uint32_t(expected), 0);
+	}
+
+	void
+	futex_wake_one(std::atomic<int32_t>* value)
+	{
+		__ulock_wake(UL_COMPARE_AND_WAIT | ULF_NO_ERRNO, (void*)value, 0);
+	}
+
+	void
+	futex_wake_all(std::atomic<int32_t>* value)
+	{
+		__ulock_wake(UL_COMPARE_AND_WAIT | ULF_WAKE_ALL | ULF_NO_ERRNO, (void*)value, 0);
+	}
 }
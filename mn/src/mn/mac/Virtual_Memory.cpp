@@ -33,4 +33,11 @@ namespace mn
 	{
 		munmap(block.ptr, block.size);
 	}
+
+	Block
+	virtual_realloc(Block, size_t)
+	{
+		// macos has no mremap
+		return {};
+	}
 }
@@ -4,11 +4,64 @@
 
 namespace mn::memory
 {
+	inline static size_t
+	_arena_padding(uint8_t* ptr, uint8_t alignment)
+	{
+		return (alignment - (uintptr_t(ptr) & (alignment - 1))) & (alignment - 1);
+	}
+
+	// calls the registered destructors until we reach the given one (exclusive)
+	inline static void
+	_arena_destruct_until(Arena* self, Arena::Destructor* until)
+	{
+		while (self->destructors != until)
+		{
+			auto it = self->destructors;
+			self->destructors = it->next;
+			it->destroy(it->ptr);
+		}
+	}
+
+	// keeps the given node in the spare list if it fits in the spare memory cap, otherwise frees it
+	inline static void
+	_arena_node_release(Arena* self, Arena::Node* node)
+	{
+		if (self->spare_mem + node->mem.size <= self->spare_mem_cap)
+		{
+			node->next = self->spare_head;
+			self->spare_head = node;
+			self->spare_mem += node->mem.size;
+		}
+		else
+		{
+			self->meta->free(Block{ node, node->mem.size + sizeof(Arena::Node) });
+		}
+	}
+
+	// takes the first spare node which can hold the given size out of the spare list
+	inline static Arena::Node*
+	_arena_node_reuse(Arena* self, size_t size)
+	{
+		for (auto it = &self->spare_head; *it != nullptr; it = &(*it)->next)
+		{
+			auto node = *it;
+			if (node->mem.size >= size)
+			{
+				*it = node->next;
+				self->spare_mem -= node->mem.size;
+				node->alloc_head = (uint8_t*)node->mem.ptr;
+				return node;
+			}
+		}
+		return nullptr;
+	}
+
 	Arena::Arena(size_t block_size, Interface* meta)
 	{
 		mn_assert(block_size != 0);
 		this->meta = meta;
 		this->head = nullptr;
+		this->destructors = nullptr;
 		this->block_size = block_size;
 		this->total_mem = 0;
 		this->used_mem = 0;
@@ -16,6 +69,9 @@ namespace mn::memory
 		this->clear_all_readjust_threshold = 4ULL * 1024ULL * 1024ULL;
 		this->clear_all_current_highwater = 0;
 		this->clear_all_previous_highwater = 0;
+		this->spare_head = nullptr;
+		this->spare_mem = 0;
+		this->spare_mem_cap = 0;
 	}
 
 	Arena::~Arena()
@@ -24,16 +80,35 @@ namespace mn::memory
 	}
 
 	Block
-	Arena::alloc(size_t size, uint8_t)
+	Arena::alloc(size_t size, uint8_t alignment)
 	{
 		if (size == 0)
 			return {};
 
-		grow(size);
+		if (alignment == 0)
+			alignment = 1;
+
+		size_t padding = 0;
+		if (this->head != nullptr)
+		{
+			padding = _arena_padding(this->head->alloc_head, alignment);
+			size_t node_used_mem = this->head->alloc_head - (uint8_t*)this->head->mem.ptr;
+			size_t node_free_mem = this->head->mem.size - node_used_mem;
+			if (node_free_mem < size + padding)
+			{
+				grow(size + alignment - 1);
+				padding = _arena_padding(this->head->alloc_head, alignment);
+			}
+		}
+		else
+		{
+			grow(size + alignment - 1);
+			padding = _arena_padding(this->head->alloc_head, alignment);
+		}
 
-		uint8_t* ptr = this->head->alloc_head;
-		this->head->alloc_head += size;
-		this->used_mem += size;
+		uint8_t* ptr = this->head->alloc_head + padding;
+		this->head->alloc_head += size + padding;
+		this->used_mem += size + padding;
 		this->highwater_mem = this->highwater_mem > this->used_mem ? this->highwater_mem : this->used_mem;
 		this->clear_all_current_highwater = this->clear_all_current_highwater > this->used_mem ? this->clear_all_current_highwater : this->used_mem;
 
@@ -57,6 +132,28 @@ namespace mn::memory
 	{
 	}
 
+	Block
+	Arena::realloc(Block block, size_t size, uint8_t)
+	{
+		if (this->head == nullptr || size == 0)
+			return {};
+
+		// only the top allocation can be resized
+		auto block_end = (uint8_t*)block.ptr + block.size;
+		if (block_end != this->head->alloc_head)
+			return {};
+
+		auto node_end = (uint8_t*)this->head->mem.ptr + this->head->mem.size;
+		if (size > block.size && size - block.size > size_t(node_end - block_end))
+			return {};
+
+		this->head->alloc_head = (uint8_t*)block.ptr + size;
+		this->used_mem = this->used_mem - block.size + size;
+		this->highwater_mem = this->highwater_mem > this->used_mem ? this->highwater_mem : this->used_mem;
+		this->clear_all_current_highwater = this->clear_all_current_highwater > this->used_mem ? this->clear_all_current_highwater : this->used_mem;
+		return Block{ block.ptr, size };
+	}
+
 	void
 	Arena::grow(size_t size)
 	{
@@ -68,6 +165,14 @@ namespace mn::memory
 				return;
 		}
 
+		if (auto spare_node = _arena_node_reuse(this, size))
+		{
+			this->total_mem += spare_node->mem.size;
+			spare_node->next = this->head;
+			this->head = spare_node;
+			return;
+		}
+
 		size_t request_size = size > this->block_size ? size : this->block_size;
 		request_size += sizeof(Node);
 
@@ -84,6 +189,8 @@ namespace mn::memory
 	void
 	Arena::free_all()
 	{
+		_arena_destruct_until(this, nullptr);
+
 		while (this->head)
 		{
 			Node* next = this->head->next;
@@ -93,11 +200,21 @@ namespace mn::memory
 		this->head = nullptr;
 		this->total_mem = 0;
 		this->used_mem = 0;
+
+		while (this->spare_head)
+		{
+			Node* next = this->spare_head->next;
+			meta->free(Block{ this->spare_head, this->spare_head->mem.size + sizeof(Node) });
+			this->spare_head = next;
+		}
+		this->spare_mem = 0;
 	}
 
 	void
 	Arena::clear_all()
 	{
+		_arena_destruct_until(this, nullptr);
+
 		size_t delta = 0;
 		if (this->clear_all_current_highwater > this->clear_all_previous_highwater)
 			delta = this->clear_all_current_highwater - this->clear_all_previous_highwater;
@@ -144,16 +261,19 @@ namespace mn::memory
 		s.total_mem = this->total_mem;
 		s.used_mem = this->used_mem;
 		s.highwater_mem = this->highwater_mem;
+		s.destructors = this->destructors;
 		return s;
 	}
 
 	void
 	Arena::restore(State s)
 	{
+		_arena_destruct_until(this, s.destructors);
+
 		while (this->head != s.head)
 		{
 			Node* next = this->head->next;
-			meta->free(Block{ this->head, this->head->mem.size + sizeof(Node) });
+			_arena_node_release(this, this->head);
 			this->head = next;
 		}
 		mn_assert(this->head == s.head);
@@ -163,4 +283,14 @@ namespace mn::memory
 		this->total_mem = s.total_mem;
 		this->used_mem = s.used_mem;
 	}
+
+	void
+	Arena::destructor_register(void (*destroy)(void*), void* ptr)
+	{
+		auto destructor = (Destructor*)this->alloc(sizeof(Destructor), alignof(Destructor)).ptr;
+		destructor->destroy = destroy;
+		destructor->ptr = ptr;
+		destructor->next = this->destructors;
+		this->destructors = destructor;
+	}
 }
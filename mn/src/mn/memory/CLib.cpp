@@ -40,6 +40,23 @@ namespace mn::memory
 		::free(block.ptr);
 	}
 
+	Block
+	CLib::realloc(Block block, size_t size, uint8_t)
+	{
+		if (size == 0)
+			return {};
+
+		// the old pointer can't be used after realloc so we report its free first
+		_memory_profile_free(block.ptr, block.size);
+		Block res{};
+		res.ptr = ::realloc(block.ptr, size);
+		if (res.ptr == nullptr)
+			panic("system out of memory");
+		res.size = size;
+		_memory_profile_alloc(res.ptr, res.size);
+		return res;
+	}
+
 	CLib*
 	clib()
 	{
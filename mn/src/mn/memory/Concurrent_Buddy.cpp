@@ -0,0 +1,289 @@
+#include "mn/memory/Concurrent_Buddy.h"
+#include "mn/Memory.h"
+#include "mn/Thread.h"
+#include "mn/Bits.h"
+#include "mn/Assert.h"
+
+#include <string.h>
+
+namespace mn::memory
+{
+	inline static size_t
+	_concurrent_buddy_log2_ceil(size_t v)
+	{
+		if (v <= 1)
+			return 0;
+		return 64 - leading_zeros(uint64_t(v - 1));
+	}
+
+	inline static uint64_t
+	_concurrent_buddy_bit(size_t index)
+	{
+		return 1ULL << (63 - (index & 63));
+	}
+
+	inline static void
+	_concurrent_buddy_lock(Concurrent_Buddy::Order& order)
+	{
+		size_t spin_count = 0;
+		while (order.lock.test_and_set(std::memory_order_acquire))
+			thread_spin_wait(spin_count);
+	}
+
+	inline static void
+	_concurrent_buddy_unlock(Concurrent_Buddy::Order& order)
+	{
+		order.lock.clear(std::memory_order_release);
+	}
+
+	// marks the start of a split or a merge, it should be called before the block is taken out of its order
+	inline static void
+	_concurrent_buddy_move_begin(Concurrent_Buddy* self)
+	{
+		self->pending_moves.fetch_add((1ULL << 32) + 1, std::memory_order_acq_rel);
+	}
+
+	// marks the end of a split or a merge, it should be called after the result is published in its order
+	inline static void
+	_concurrent_buddy_move_end(Concurrent_Buddy* self)
+	{
+		self->pending_moves.fetch_sub(1, std::memory_order_release);
+	}
+
+	// the following functions should be called while holding the order lock
+	inline static void
+	_concurrent_buddy_set(Concurrent_Buddy* self, size_t order_index, size_t index)
+	{
+		auto& order = self->orders[order_index];
+		auto word_index = index >> 6;
+		order.words[word_index] |= _concurrent_buddy_bit(index);
+		order.summary[word_index >> 6] |= _concurrent_buddy_bit(word_index);
+		if (order.free_count++ == 0)
+			self->nonempty_orders.fetch_or(1ULL << order_index, std::memory_order_release);
+	}
+
+	inline static void
+	_concurrent_buddy_clear(Concurrent_Buddy* self, size_t order_index, size_t index)
+	{
+		auto& order = self->orders[order_index];
+		auto word_index = index >> 6;
+		order.words[word_index] &= ~_concurrent_buddy_bit(index);
+		if (order.words[word_index] == 0)
+			order.summary[word_index >> 6] &= ~_concurrent_buddy_bit(word_index);
+		if (--order.free_count == 0)
+			self->nonempty_orders.fetch_and(~(1ULL << order_index), std::memory_order_release);
+	}
+
+	inline static bool
+	_concurrent_buddy_is_set(const Concurrent_Buddy::Order& order, size_t index)
+	{
+		return (order.words[index >> 6] & _concurrent_buddy_bit(index)) != 0;
+	}
+
+	// finds the first free block in the given order and marks it as used, returns SIZE_MAX if there's none
+	inline static size_t
+	_concurrent_buddy_take_first(Concurrent_Buddy* self, size_t order_index)
+	{
+		auto& order = self->orders[order_index];
+		for (size_t i = 0; i < order.summary_count; ++i)
+		{
+			if (order.summary[i] == 0)
+				continue;
+
+			auto word_index = (i << 6) + size_t(leading_zeros(order.summary[i]));
+			auto index = (word_index << 6) + size_t(leading_zeros(order.words[word_index]));
+			_concurrent_buddy_clear(self, order_index, index);
+			return index;
+		}
+		return SIZE_MAX;
+	}
+
+	// returns the index of a block of the given order, or SIZE_MAX in case we are out of memory
+	inline static size_t
+	_concurrent_buddy_alloc_order(Concurrent_Buddy* self, size_t order_index)
+	{
+		size_t spin_count = 0;
+		while (true)
+		{
+			// find the smallest order which has free blocks and can fit this request, so we don't lock empty orders
+			auto pending_moves = self->pending_moves.load(std::memory_order_acquire);
+			auto mask = self->nonempty_orders.load(std::memory_order_acquire) & ~((1ULL << order_index) - 1);
+			if (mask == 0)
+			{
+				// the orders might look empty only because another thread is splitting or merging a block, so we
+				// report out of memory only if no split or merge was in progress or has started since we looked
+				if ((pending_moves & 0xFFFFFFFFULL) == 0 && self->pending_moves.load(std::memory_order_acquire) == pending_moves)
+					return SIZE_MAX;
+				thread_spin_wait(spin_count);
+				continue;
+			}
+			auto found_order_index = size_t(63 - leading_zeros(mask & (~mask + 1)));
+
+			auto split = found_order_index > order_index;
+			if (split)
+				_concurrent_buddy_move_begin(self);
+
+			auto& order = self->orders[found_order_index];
+			_concurrent_buddy_lock(order);
+			auto index = _concurrent_buddy_take_first(self, found_order_index);
+			_concurrent_buddy_unlock(order);
+
+			// another thread took the last free block of this order, try again
+			if (index == SIZE_MAX)
+			{
+				if (split)
+					_concurrent_buddy_move_end(self);
+				continue;
+			}
+
+			// split the block down to the requested order, we keep the left half and publish the right half as free
+			while (found_order_index > order_index)
+			{
+				--found_order_index;
+				index *= 2;
+				auto& lower_order = self->orders[found_order_index];
+				_concurrent_buddy_lock(lower_order);
+				_concurrent_buddy_set(self, found_order_index, index + 1);
+				_concurrent_buddy_unlock(lower_order);
+			}
+			if (split)
+				_concurrent_buddy_move_end(self);
+			return index;
+		}
+	}
+
+	inline static void
+	_concurrent_buddy_free_order(Concurrent_Buddy* self, size_t order_index, size_t index)
+	{
+		auto merge = false;
+		while (true)
+		{
+			auto& order = self->orders[order_index];
+			_concurrent_buddy_lock(order);
+
+			// if the buddy is free we merge with it and free the parent block instead, note that the merge happens
+			// while we hold the order lock so two buddies freed concurrently will always be merged
+			auto buddy = index ^ 1;
+			if (order_index + 1 < self->order_count && _concurrent_buddy_is_set(order, buddy))
+			{
+				if (merge == false)
+				{
+					_concurrent_buddy_move_begin(self);
+					merge = true;
+				}
+				_concurrent_buddy_clear(self, order_index, buddy);
+				_concurrent_buddy_unlock(order);
+				index >>= 1;
+				++order_index;
+				continue;
+			}
+
+			_concurrent_buddy_set(self, order_index, index);
+			_concurrent_buddy_unlock(order);
+			break;
+		}
+		if (merge)
+			_concurrent_buddy_move_end(self);
+	}
+
+	Concurrent_Buddy::Concurrent_Buddy(size_t heap_size, Interface* meta_)
+	{
+		meta = meta_;
+
+		max_alloc_log2 = _concurrent_buddy_log2_ceil(heap_size);
+		if (max_alloc_log2 < MIN_ALLOC_LOG2)
+			max_alloc_log2 = MIN_ALLOC_LOG2;
+		max_alloc = 1ULL << max_alloc_log2;
+		order_count = max_alloc_log2 - MIN_ALLOC_LOG2 + 1;
+		mn_assert(order_count <= MAX_ORDER_COUNT);
+
+		// the heap is followed by the bitmaps of all the orders
+		size_t bitmaps_size = 0;
+		for (size_t i = 0; i < order_count; ++i)
+		{
+			size_t blocks_count = 1ULL << (order_count - i - 1);
+			size_t words_count = (blocks_count + 63) / 64;
+			size_t summary_count = (words_count + 63) / 64;
+			bitmaps_size += (words_count + summary_count) * sizeof(uint64_t);
+		}
+
+		memory = meta->alloc(max_alloc + bitmaps_size, alignof(uint64_t));
+		// all the memory is committed upfront, just like the buddy allocator
+		meta->commit(memory);
+
+		base_ptr = (uint8_t*)memory.ptr;
+		auto bitmaps_ptr = (uint64_t*)(base_ptr + max_alloc);
+		::memset(bitmaps_ptr, 0, bitmaps_size);
+
+		orders = (Order*)alloc_aligned_from(clib(), sizeof(Order) * order_count, alignof(Order), orders_memory);
+		for (size_t i = 0; i < order_count; ++i)
+		{
+			auto& order = *::new (orders + i) Order{};
+			order.lock.clear();
+			order.free_count = 0;
+			size_t blocks_count = 1ULL << (order_count - i - 1);
+			order.words_count = (blocks_count + 63) / 64;
+			order.summary_count = (order.words_count + 63) / 64;
+			order.words = bitmaps_ptr;
+			bitmaps_ptr += order.words_count;
+			order.summary = bitmaps_ptr;
+			bitmaps_ptr += order.summary_count;
+		}
+
+		// the whole heap starts as a single free block in the last order
+		nonempty_orders = 0;
+		pending_moves = 0;
+		_concurrent_buddy_set(this, order_count - 1, 0);
+	}
+
+	Concurrent_Buddy::~Concurrent_Buddy()
+	{
+		meta->release(memory);
+		meta->free(memory);
+		free_from(clib(), orders_memory);
+	}
+
+	Block
+	Concurrent_Buddy::alloc(size_t size, uint8_t)
+	{
+		if (size == 0 || size + HEADER_SIZE > max_alloc)
+			return {};
+
+		auto size_log2 = _concurrent_buddy_log2_ceil(size + HEADER_SIZE);
+		size_t order_index = size_log2 > MIN_ALLOC_LOG2 ? size_log2 - MIN_ALLOC_LOG2 : 0;
+
+		auto index = _concurrent_buddy_alloc_order(this, order_index);
+		if (index == SIZE_MAX)
+			return {};
+
+		auto ptr = base_ptr + (index << (order_index + MIN_ALLOC_LOG2));
+		*(uint64_t*)ptr = order_index;
+		return Block{ptr + HEADER_SIZE, size};
+	}
+
+	void
+	Concurrent_Buddy::commit(Block)
+	{
+		// do nothing
+	}
+
+	void
+	Concurrent_Buddy::release(Block)
+	{
+		// do nothing
+	}
+
+	void
+	Concurrent_Buddy::free(Block block)
+	{
+		if (block_is_empty(block))
+			return;
+
+		auto ptr = (uint8_t*)block.ptr - HEADER_SIZE;
+		mn_assert(ptr >= base_ptr && ptr < base_ptr + max_alloc);
+
+		auto order_index = size_t(*(uint64_t*)ptr);
+		auto index = size_t(ptr - base_ptr) >> (order_index + MIN_ALLOC_LOG2);
+		_concurrent_buddy_free_order(this, order_index, index);
+	}
+}
@@ -4,16 +4,125 @@
 #include "mn/Context.h"
 #include "mn/File.h"
 #include "mn/OS.h"
+#include "mn/Map.h"
+#include "mn/Buf.h"
+#include "mn/Thread.h"
+#include "mn/Fmt.h"
+#include "mn/Defer.h"
+
+#include <algorithm>
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 namespace mn::memory
 {
+	struct Leak_Callstack
+	{
+		void** frames;
+		size_t count;
+
+		bool
+		operator==(const Leak_Callstack& other) const
+		{
+			return count == other.count && ::memcmp(frames, other.frames, count * sizeof(void*)) == 0;
+		}
+	};
+
+	struct Leak_Callstack_Hash
+	{
+		inline size_t
+		operator()(const Leak_Callstack& callstack) const
+		{
+			return hash_bytes(callstack.frames, callstack.count * sizeof(void*));
+		}
+	};
+
+	// a copy of a live block's tracking info which is taken while holding the shard lock, so the report can be
+	// symbolized and printed after the lock is released
+	struct Leak_Record
+	{
+		constexpr static inline size_t CONTENT_MAX_BYTES = 128;
+
+		void* callstack[Leak::CALLSTACK_MAX_FRAMES];
+		size_t callstack_count;
+		size_t size;
+		char content[CONTENT_MAX_BYTES];
+	};
+
+	struct Leak_Group
+	{
+		void* callstack[Leak::CALLSTACK_MAX_FRAMES];
+		size_t callstack_count;
+		size_t count;
+		size_t size;
+	};
+
+	inline static Leak::Shard&
+	_leak_shard(Leak* self, Leak::Node* node)
+	{
+		auto h = uint64_t(uintptr_t(node) >> 4) * 0x9E3779B97F4A7C15ULL;
+		return self->shards[(h >> 32) & (Leak::SHARD_COUNT - 1)];
+	}
+
+	inline static void
+	_leak_shard_lock(Leak::Shard& shard)
+	{
+		size_t spin_count = 0;
+		while (shard.lock.test_and_set(std::memory_order_acquire))
+			thread_spin_wait(spin_count);
+	}
+
+	inline static void
+	_leak_shard_unlock(Leak::Shard& shard)
+	{
+		shard.lock.clear(std::memory_order_release);
+	}
+
+	// copies the tracking info of all the live blocks into the given records buf one shard at a time, the space of a
+	// shard's records is reserved before locking it so the shard lock is only held for the copies, it returns the total
+	// size of the live blocks
+	inline static size_t
+	_leak_snapshot(Leak* self, Buf<Leak_Record>& records)
+	{
+		size_t size = 0;
+		for (auto& shard: self->shards)
+		{
+			while (true)
+			{
+				_leak_shard_lock(shard);
+				auto count = shard.count;
+				if (records.count + count <= records.cap)
+					break;
+				_leak_shard_unlock(shard);
+				buf_reserve(records, count);
+			}
+
+			for (auto it = shard.head; it != nullptr; it = it->next)
+			{
+				Leak_Record record{};
+				::memcpy(record.callstack, it->callstack, it->callstack_count * sizeof(void*));
+				record.callstack_count = it->callstack_count;
+				record.size = it->size;
+				::memcpy(record.content, it + 1, it->size > Leak_Record::CONTENT_MAX_BYTES ? Leak_Record::CONTENT_MAX_BYTES : it->size);
+				buf_push(records, record);
+				size += it->size;
+			}
+			_leak_shard_unlock(shard);
+		}
+		return size;
+	}
+
 	Leak::Leak()
 	{
-		this->head = nullptr;
-		this->mtx = _leak_allocator_mutex();
+		for (auto& shard: this->shards)
+		{
+			shard.lock.clear();
+			shard.head = nullptr;
+			shard.count = 0;
+		}
+		this->report_mode = REPORT_MODE_EACH;
 		this->report_on_destruct = true;
 	}
 
@@ -35,15 +144,18 @@ namespace mn::memory
 			panic("system out of memory");
 
 		ptr->size = size;
+		ptr->callstack_count = callstack_capture(ptr->callstack, Leak::CALLSTACK_MAX_FRAMES);
 		ptr->prev = nullptr;
-		mutex_lock(this->mtx);
-			ptr->next = this->head;
-			if (this->head != nullptr)
-				this->head->prev = ptr;
-			this->head = ptr;
-		mutex_unlock(this->mtx);
-
-		callstack_capture(ptr->callstack, Leak::CALLSTACK_MAX_FRAMES);
+
+		auto& shard = _leak_shard(this, ptr);
+		_leak_shard_lock(shard);
+			ptr->next = shard.head;
+			if (shard.head != nullptr)
+				shard.head->prev = ptr;
+			shard.head = ptr;
+			++shard.count;
+		_leak_shard_unlock(shard);
+
 		auto res = Block{ ptr + 1, size };
 		_memory_profile_alloc(res.ptr, res.size);
 		return res;
@@ -68,16 +180,18 @@ namespace mn::memory
 		{
 			Node* ptr = ((Node*)block.ptr) - 1;
 
-			mutex_lock(this->mtx);
-			if (ptr == this->head)
-				this->head = ptr->next;
+			auto& shard = _leak_shard(this, ptr);
+			_leak_shard_lock(shard);
+			if (ptr == shard.head)
+				shard.head = ptr->next;
 
 			if (ptr->prev)
 				ptr->prev->next = ptr->next;
 
 			if (ptr->next)
 				ptr->next->prev = ptr->prev;
-			mutex_unlock(this->mtx);
+			--shard.count;
+			_leak_shard_unlock(shard);
 
 			_memory_profile_free(block.ptr, block.size);
 			::free(ptr);
@@ -88,23 +202,30 @@ namespace mn::memory
 	Leak::report(bool report_on_destruct_)
 	{
 		this->report_on_destruct = report_on_destruct_;
-		if (this->head == nullptr)
+
+		if (this->report_mode == REPORT_MODE_GROUPED)
+		{
+			report_grouped_to(file_stderr());
 			return;
+		}
 
-		size_t count = 0;
-		size_t size = 0;
-		auto it = head;
-		while (it)
+		// we use the clib allocator here since the leak allocator might be the one at the top of the allocator stack
+		auto records = buf_with_allocator<Leak_Record>(clib());
+		mn_defer{buf_free(records);};
+		auto size = _leak_snapshot(this, records);
+		auto count = records.count;
+
+		for (const auto& record: records)
 		{
-			::fprintf(stderr, "Leak size: %zu, call stack:\n", it->size);
+			::fprintf(stderr, "Leak size: %zu, call stack:\n", record.size);
 			#if DEBUG
-				callstack_print_to(it->callstack, Leak::CALLSTACK_MAX_FRAMES, file_stderr());
+				callstack_print_to((void**)record.callstack, record.callstack_count, file_stderr());
 			#else
 				::fprintf(stderr, "run in debug mode to get call stack info\n");
 			#endif
 
-			auto ptr = (char*)(it + 1);
-			size_t len = it->size > 128 ? 128 : it->size;
+			auto ptr = record.content;
+			size_t len = record.size > Leak_Record::CONTENT_MAX_BYTES ? Leak_Record::CONTENT_MAX_BYTES : record.size;
 
 			::fprintf(stderr, "content bytes[%zu]: {", len);
 			for (size_t i = 0; i < len; ++i)
@@ -120,12 +241,64 @@ namespace mn::memory
 			for (size_t i = 0; i < len; ++i)
 				::fprintf(stderr, "%c", ptr[i]);
 			::fprintf(stderr, "'\n\n");
+		}
+
+		if (count > 0)
+			::fprintf(stderr, "Leaks count: %zu, Leaks size(bytes): %zu\n", count, size);
+	}
+
+	size_t
+	Leak::report_grouped_to(Stream out)
+	{
+		// we use the clib allocator here since the leak allocator might be the one at the top of the allocator stack
+		auto records = buf_with_allocator<Leak_Record>(clib());
+		mn_defer{buf_free(records);};
+		auto groups = buf_with_allocator<Leak_Group>(clib());
+		mn_defer{buf_free(groups);};
+
+		// the locks are only held while taking the snapshot, the aggregation, symbolization, and printing happen after
+		// we unlock so that the given stream can allocate from this allocator
+		auto size = _leak_snapshot(this, records);
+		auto count = records.count;
 
-			++count;
-			size += it->size;
-			it = it->next;
+		auto groups_by_callstack = map_with_allocator<Leak_Callstack, size_t, Leak_Callstack_Hash>(clib());
+		mn_defer{map_free(groups_by_callstack);};
+		for (auto& record: records)
+		{
+			auto callstack = Leak_Callstack{record.callstack, record.callstack_count};
+			auto group = map_lookup(groups_by_callstack, callstack);
+			if (group == nullptr)
+			{
+				group = map_insert(groups_by_callstack, callstack, groups.count);
+				Leak_Group new_group{};
+				::memcpy(new_group.callstack, record.callstack, record.callstack_count * sizeof(void*));
+				new_group.callstack_count = record.callstack_count;
+				buf_push(groups, new_group);
+			}
+			groups[group->value].count += 1;
+			groups[group->value].size += record.size;
+		}
+
+		if (count == 0)
+			return 0;
+
+		std::sort(begin(groups), end(groups), [](const Leak_Group& a, const Leak_Group& b) {
+			return a.size > b.size;
+		});
+
+		// we only symbolize each unique call stack once
+		for (const auto& group: groups)
+		{
+			print_to(out, "Leaks count: {}, Leaks size(bytes): {}, call stack:\n", group.count, group.size);
+			#if DEBUG
+				callstack_print_to((void**)group.callstack, group.callstack_count, out);
+			#else
+				print_to(out, "run in debug mode to get call stack info\n");
+			#endif
+			print_to(out, "\n");
 		}
-		::fprintf(stderr, "Leaks count: %zu, Leaks size(bytes): %zu\n", count, size);
+		print_to(out, "Leaks count: {}, Leaks size(bytes): {}, Unique call stacks: {}\n", count, size, groups.count);
+		return count;
 	}
 
 	Leak*
@@ -0,0 +1,216 @@
+#include "mn/memory/Stats.h"
+#include "mn/Memory.h"
+#include "mn/Bits.h"
+#include "mn/Thread.h"
+#include "mn/Fmt.h"
+#include "mn/Assert.h"
+
+namespace mn::memory
+{
+	static std::atomic<size_t> STATS_SHARD_GENERATOR = 0;
+	thread_local size_t STATS_SHARD_INDEX = SIZE_MAX;
+
+	inline static size_t
+	_stats_shard_index()
+	{
+		if (STATS_SHARD_INDEX == SIZE_MAX)
+			STATS_SHARD_INDEX = STATS_SHARD_GENERATOR.fetch_add(1) % Stats::SHARD_COUNT;
+		return STATS_SHARD_INDEX;
+	}
+
+	inline static size_t
+	_stats_size_class(size_t size)
+	{
+		if (size <= 1)
+			return 0;
+		size_t size_class = 64 - leading_zeros(uint64_t(size - 1));
+		return size_class < Stats::SIZE_CLASS_COUNT ? size_class : Stats::SIZE_CLASS_COUNT - 1;
+	}
+
+	inline static Stats::Shard&
+	_stats_local_shard(Stats* self)
+	{
+		auto& shard = self->shards[_stats_shard_index()];
+		if (shard.thread.load(std::memory_order_relaxed) == nullptr)
+		{
+			void* expected = nullptr;
+			shard.thread.compare_exchange_strong(expected, thread_id(), std::memory_order_relaxed);
+		}
+		return shard;
+	}
+
+	inline static void
+	_stats_sample_peak(Stats* self)
+	{
+		int64_t live_bytes = 0;
+		for (size_t i = 0; i < Stats::SHARD_COUNT; ++i)
+			live_bytes += self->shards[i].live_bytes.load(std::memory_order_relaxed);
+
+		auto peak = self->peak_bytes.load(std::memory_order_relaxed);
+		while (live_bytes > peak)
+		{
+			if (self->peak_bytes.compare_exchange_weak(peak, live_bytes, std::memory_order_relaxed))
+				break;
+		}
+	}
+
+	Stats::Stats(const char* name_, Interface* meta_)
+	{
+		this->meta = meta_;
+		this->name = name_;
+		this->shards = (Shard*)alloc_aligned_from(clib(), sizeof(Shard) * SHARD_COUNT, alignof(Shard), this->shards_memory);
+		for (size_t i = 0; i < SHARD_COUNT; ++i)
+			::new (this->shards + i) Shard{};
+		this->reset();
+	}
+
+	Stats::~Stats()
+	{
+		free_from(clib(), this->shards_memory);
+	}
+
+	Block
+	Stats::alloc(size_t size, uint8_t alignment)
+	{
+		auto res = meta->alloc(size, alignment);
+		if (block_is_empty(res))
+			return res;
+
+		auto& shard = _stats_local_shard(this);
+		shard.live_bytes.fetch_add(res.size, std::memory_order_relaxed);
+		shard.allocated_bytes.fetch_add(res.size, std::memory_order_relaxed);
+		shard.alloc_count.fetch_add(1, std::memory_order_relaxed);
+		shard.size_classes[_stats_size_class(res.size)].fetch_add(1, std::memory_order_relaxed);
+
+		auto unsampled = shard.unsampled_bytes.fetch_add(res.size, std::memory_order_relaxed) + res.size;
+		if (unsampled >= PEAK_SAMPLE_BYTES)
+		{
+			shard.unsampled_bytes.store(0, std::memory_order_relaxed);
+			_stats_sample_peak(this);
+		}
+		return res;
+	}
+
+	void
+	Stats::commit(Block block)
+	{
+		meta->commit(block);
+	}
+
+	void
+	Stats::release(Block block)
+	{
+		meta->release(block);
+	}
+
+	void
+	Stats::free(Block block)
+	{
+		if (block_is_empty(block))
+			return;
+
+		auto& shard = _stats_local_shard(this);
+		shard.live_bytes.fetch_sub(block.size, std::memory_order_relaxed);
+		shard.free_count.fetch_add(1, std::memory_order_relaxed);
+		meta->free(block);
+	}
+
+	Stats::Counters
+	Stats::snapshot()
+	{
+		_stats_sample_peak(this);
+
+		Counters res{};
+		for (size_t i = 0; i < SHARD_COUNT; ++i)
+		{
+			auto shard = shard_snapshot(i);
+			res.live_bytes += shard.live_bytes;
+			res.allocated_bytes += shard.allocated_bytes;
+			res.alloc_count += shard.alloc_count;
+			res.free_count += shard.free_count;
+			for (size_t j = 0; j < SIZE_CLASS_COUNT; ++j)
+				res.size_classes[j] += shard.size_classes[j];
+		}
+		res.peak_bytes = this->peak_bytes.load(std::memory_order_relaxed);
+		return res;
+	}
+
+	Stats::Counters
+	Stats::shard_snapshot(size_t shard_index) const
+	{
+		mn_assert(shard_index < SHARD_COUNT);
+		const auto& shard = shards[shard_index];
+
+		Counters res{};
+		res.live_bytes = shard.live_bytes.load(std::memory_order_relaxed);
+		res.allocated_bytes = shard.allocated_bytes.load(std::memory_order_relaxed);
+		res.alloc_count = shard.alloc_count.load(std::memory_order_relaxed);
+		res.free_count = shard.free_count.load(std::memory_order_relaxed);
+		for (size_t i = 0; i < SIZE_CLASS_COUNT; ++i)
+			res.size_classes[i] = shard.size_classes[i].load(std::memory_order_relaxed);
+		return res;
+	}
+
+	void
+	Stats::reset()
+	{
+		this->peak_bytes.store(0, std::memory_order_relaxed);
+		for (size_t i = 0; i < SHARD_COUNT; ++i)
+		{
+			auto& shard = this->shards[i];
+			shard.thread.store(nullptr, std::memory_order_relaxed);
+			shard.live_bytes.store(0, std::memory_order_relaxed);
+			shard.allocated_bytes.store(0, std::memory_order_relaxed);
+			shard.alloc_count.store(0, std::memory_order_relaxed);
+			shard.free_count.store(0, std::memory_order_relaxed);
+			shard.unsampled_bytes.store(0, std::memory_order_relaxed);
+			for (auto& size_class: shard.size_classes)
+				size_class.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	void
+	Stats::dump(Stream out)
+	{
+		auto total = snapshot();
+		print_to(out, "Allocator '{}': live {} bytes, peak {} bytes, allocated {} bytes, allocs {}, frees {}\n",
+			name ? name : "<unnamed>",
+			total.live_bytes,
+			total.peak_bytes,
+			total.allocated_bytes,
+			total.alloc_count,
+			total.free_count
+		);
+
+		print_to(out, "  size classes:\n");
+		for (size_t i = 0; i < SIZE_CLASS_COUNT; ++i)
+		{
+			if (total.size_classes[i] == 0)
+				continue;
+
+			uint64_t lower = 0, upper = 0;
+			stats_size_class_range(i, lower, upper);
+			if (upper == UINT64_MAX)
+				print_to(out, "    ({}, inf] bytes: {}\n", lower, total.size_classes[i]);
+			else
+				print_to(out, "    ({}, {}] bytes: {}\n", lower, upper, total.size_classes[i]);
+		}
+
+		print_to(out, "  threads:\n");
+		for (size_t i = 0; i < SHARD_COUNT; ++i)
+		{
+			auto thread = shards[i].thread.load(std::memory_order_relaxed);
+			if (thread == nullptr)
+				continue;
+
+			auto shard = shard_snapshot(i);
+			print_to(out, "    thread {}: live {} bytes, allocated {} bytes, allocs {}, frees {}\n",
+				thread,
+				shard.live_bytes,
+				shard.allocated_bytes,
+				shard.alloc_count,
+				shard.free_count
+			);
+		}
+	}
+}
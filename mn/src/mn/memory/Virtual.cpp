@@ -31,6 +31,18 @@ namespace mn::memory
 		virtual_free(block);
 	}
 
+	Block
+	Virtual::realloc(Block block, size_t size, uint8_t)
+	{
+		Block res = virtual_realloc(block, size);
+		if (res.ptr)
+		{
+			_memory_profile_free(block.ptr, block.size);
+			_memory_profile_alloc(res.ptr, res.size);
+		}
+		return res;
+	}
+
 	Virtual*
 	virtual_mem()
 	{
@@ -20,38 +20,6 @@
 
 namespace mn
 {
-	struct Leak_Allocator_Mutex
-	{
-		Source_Location srcloc;
-		IMutex self;
-
-		Leak_Allocator_Mutex()
-		{
-			srcloc.name = "allocators mutex";
-			srcloc.function = "mn::_leak_allocator_mutex";
-			srcloc.file = __FILE__;
-			srcloc.line = __LINE__;
-			srcloc.color = 0;
-			self.name = srcloc.name;
-			self.srcloc = &srcloc;
-			InitializeCriticalSectionAndSpinCount(&self.cs, 1<<14);
-			self.profile_user_data = _mutex_new(&self, self.name);
-		}
-
-		~Leak_Allocator_Mutex()
-		{
-			DeleteCriticalSection(&self.cs);
-			_mutex_free(&self, self.profile_user_data);
-		}
-	};
-
-	Mutex
-	_leak_allocator_mutex()
-	{
-		static Leak_Allocator_Mutex mtx;
-		return &mtx.self;
-	}
-
 	// Deadlock detector
 	struct Mutex_Thread_Owner
 	{
@@ -774,4 +742,25 @@ namespace mn
 		mn_defer{LeaveCriticalSection(&self->cs);};
 		return self->count;
 	}
+
+	void
+	futex_wait(std::atomic<int32_t>* value, int32_t expected)
+	{
+		worker_block_ahead();
+		mn_defer{worker_block_clear();};
+
+		WaitOnAddress((volatile VOID*)value, &expected, sizeof(expected), INFINITE);
+	}
+
+	void
+	futex_wake_one(std::atomic<int32_t>* value)
+	{
+		WakeByAddressSingle((PVOID)value);
+	}
+
+	void
+	futex_wake_all(std::atomic<int32_t>* value)
+	{
+		WakeByAddressAll((PVOID)value);
+	}
 }
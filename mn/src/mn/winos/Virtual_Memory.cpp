@@ -37,4 +37,11 @@ namespace mn
 		[[maybe_unused]] auto result = VirtualFree(block.ptr, 0, MEM_RELEASE);
 		mn_assert(result != FALSE);
 	}
+
+	Block
+	virtual_realloc(Block, size_t)
+	{
+		// windows has no way to resize a reserved region
+		return {};
+	}
 }
@@ -1,7 +1,20 @@
 #define DOCTEST_CONFIG_IMPLEMENT
 #include <doctest/doctest.h>
 
+#include <mn/Memory.h>
+
+#include <string.h>
+
 int main(int argc, char** argv) {
+	// the child mode of the "process exit" test, it touches the lazily created tmp arena then exits normally so the
+	// parent can check that the static and thread local destructors run without crashing
+	if (argc == 2 && strcmp(argv[1], "--mn-exit-child") == 0)
+	{
+		auto block = mn::memory::tmp()->alloc(64, alignof(int));
+		memset(block.ptr, 0, block.size);
+		return 0;
+	}
+
 	doctest::Context context;
 	context.applyCommandLine(argc, argv);
 	int res = context.run(); // run
@@ -2,16 +2,31 @@
 
 #include <mn/Memory.h>
 #include <mn/Buf.h>
+#include <mn/Small_Buf.h>
+#include <mn/Small_Str.h>
 #include <mn/Str.h>
 #include <mn/Map.h>
+#include <mn/Concurrent_Map.h>
+#include <mn/Cache.h>
+#include <mn/Concurrent_Cache.h>
+#include <mn/Ordered_Map.h>
+#include <mn/Sort.h>
+#include <mn/Heap.h>
+#include <mn/Bloom_Filter.h>
+#include <mn/Cuckoo_Filter.h>
+#include <mn/Bitset.h>
+#include <mn/Soa_Buf.h>
 #include <mn/Pool.h>
 #include <mn/Memory_Stream.h>
 #include <mn/Virtual_Memory.h>
 #include <mn/IO.h>
 #include <mn/Str_Intern.h>
 #include <mn/Ring.h>
+#include <mn/Spsc_Ring.h>
 #include <mn/OS.h>
 #include <mn/memory/Leak.h>
+#include <mn/memory/Stats.h>
+#include <mn/Heap_Profiler.h>
 #include <mn/Task.h>
 #include <mn/Path.h>
 #include <mn/Fmt.h>
@@ -28,10 +43,13 @@
 #include <mn/Msgpack.h>
 #include <mn/IPC.h>
 
+#include <atomic>
 #include <chrono>
 #include <iostream>
 #include <sstream>
 
+#include <stdlib.h>
+
 #define ANKERL_NANOBENCH_IMPLEMENT 1
 #include <nanobench.h>
 
@@ -45,6 +63,37 @@ namespace mn
 	}
 }
 
+// seed of the xorshift32 generator which the randomized tests use so their sequences are reproducible
+constexpr uint32_t TEST_RANDOM_SEED = 2463534242;
+
+// advances the given xorshift32 state and returns the next random number
+inline static uint32_t
+test_random_next(uint32_t& x)
+{
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return x;
+}
+
+// runs the given count of random operations over the keys in [0, keys_count), each operation calls either the insert
+// or the remove function (`void(int key)`) with a random key, the sequence is the same on every run
+template<typename TInsert, typename TRemove>
+inline static void
+test_random_insert_remove(int ops_count, int keys_count, TInsert&& insert, TRemove&& remove)
+{
+	uint32_t x = TEST_RANDOM_SEED;
+	for (int i = 0; i < ops_count; ++i)
+	{
+		auto r = test_random_next(x);
+		auto key = int(r % keys_count);
+		if (r & 0x10000)
+			insert(key);
+		else
+			remove(key);
+	}
+}
+
 TEST_CASE("allocation")
 {
 	auto b = mn::alloc(sizeof(int), alignof(int));
@@ -103,6 +152,16 @@ TEST_CASE("tmp allocator")
 	mn::memory::tmp()->free_all();
 }
 
+TEST_CASE("process exits cleanly after using the tmp allocator")
+{
+	// the child touches the lazily created tmp arena and exits, the static and thread local destructors shouldn't
+	// crash at exit
+	auto exe = mn::path_executable(mn::memory::tmp());
+	auto cmd = mn::strf(mn::memory::tmp(), "\"{}\" --mn-exit-child", exe);
+	CHECK(::system(cmd.ptr) == 0);
+	mn::memory::tmp()->free_all();
+}
+
 TEST_CASE("buf push")
 {
 	auto arr = mn::buf_new<int>();
@@ -161,6 +220,111 @@ TEST_CASE("buf resize")
 	mn::buf_free(arr);
 }
 
+TEST_CASE("small buf")
+{
+	auto arr = mn::small_buf_new<int, 4>();
+	for (int i = 0; i < 4; ++i)
+		mn::small_buf_push(arr, i);
+	CHECK(mn::small_buf_is_inline(arr));
+	CHECK(mn::str_tmpf("{}", arr) == "[4]{0: 0, 1: 1, 2: 2, 3: 3 }");
+
+	// clones of an inline small buf are independent
+	auto inline_clone = mn::clone(arr);
+	CHECK(mn::small_buf_is_inline(inline_clone));
+	inline_clone[0] = 42;
+	CHECK(arr[0] == 0);
+	mn::small_buf_free(inline_clone);
+
+	for (int i = 4; i < 20; ++i)
+		mn::small_buf_push(arr, i);
+	CHECK(mn::small_buf_is_inline(arr) == false);
+	CHECK(arr.count == 20);
+	for (int i = 0; i < 20; ++i)
+		CHECK(arr[i] == i);
+
+	mn::small_buf_insert(arr, 0, -1);
+	CHECK(arr[0] == -1);
+	mn::small_buf_remove_ordered(arr, 0);
+	CHECK(arr[0] == 0);
+	CHECK(mn::small_buf_top(arr) == 19);
+
+	auto arr_clone = mn::clone(arr);
+	CHECK(arr_clone.count == arr.count);
+	int sum = 0;
+	for (auto v: arr_clone)
+		sum += v;
+	CHECK(sum == 190);
+	mn::small_buf_free(arr_clone);
+
+	auto bytes = mn::msgpack_encode(arr);
+	REQUIRE(bytes.err == false);
+	mn_defer{mn::str_free(bytes.val);};
+	auto decoded = mn::small_buf_new<int, 4>();
+	CHECK(!mn::msgpack_decode(bytes.val, decoded));
+	CHECK(decoded.count == 20);
+	CHECK(decoded[19] == 19);
+	mn::small_buf_free(decoded);
+	mn::small_buf_free(arr);
+
+	auto strs = mn::small_buf_new<mn::Str, 2>();
+	mn::small_buf_push(strs, mn::str_from_c("a"));
+	mn::small_buf_push(strs, mn::str_from_c("b"));
+	mn::small_buf_push(strs, mn::str_from_c("c"));
+	CHECK(strs[2] == "c");
+	mn::destruct(strs);
+}
+
+TEST_CASE("small str")
+{
+	CHECK(sizeof(mn::Small_Str) <= sizeof(mn::Str));
+
+	auto name = mn::small_str_from_c("Mostafa");
+	CHECK(mn::small_str_is_inline(name));
+	CHECK(name == "Mostafa");
+	CHECK(mn::str_tmpf("{}", name) == "Mostafa");
+
+	// a string with 15 bytes fits inline
+	mn::small_str_push(name, " Saad Ab");
+	CHECK(name.count == 15);
+	CHECK(mn::small_str_is_inline(name));
+	mn::small_str_push(name, "del-Hameed");
+	CHECK(mn::small_str_is_inline(name) == false);
+	CHECK(name == "Mostafa Saad Abdel-Hameed");
+	CHECK(::strlen(mn::small_str_ptr(name)) == name.count);
+	CHECK(mn::str_find(mn::small_str_view(name), "Saad", 0) == 8);
+
+	auto name_clone = clone(name);
+	CHECK(name_clone == name);
+	CHECK(mn::small_str_ptr(name_clone) != mn::small_str_ptr(name));
+	mn::small_str_free(name_clone);
+
+	// small strings hash equal to strings with the same content
+	auto key = mn::small_str_from_c("key");
+	CHECK(mn::Hash<mn::Small_Str>{}(key) == mn::Hash<mn::Str>{}(mn::str_lit("key")));
+	CHECK(name < key);
+	CHECK(key != name);
+
+	auto map = mn::map_new<mn::Small_Str, int>();
+	mn::map_insert(map, clone(key), 1);
+	mn::map_insert(map, clone(name), 2);
+	CHECK(mn::map_lookup(map, mn::small_str_from_c("key", mn::memory::tmp()))->value == 1);
+	CHECK(mn::map_lookup(map, mn::small_str_from_c("nope", mn::memory::tmp())) == nullptr);
+	mn::destruct(map);
+
+	auto bytes = mn::msgpack_encode(name);
+	REQUIRE(bytes.err == false);
+	mn_defer{mn::str_free(bytes.val);};
+	auto decoded = mn::small_str_new();
+	CHECK(!mn::msgpack_decode(bytes.val, decoded));
+	CHECK(decoded == name);
+	mn::small_str_free(decoded);
+
+	mn::small_str_clear(key);
+	CHECK(key == "");
+	mn::small_str_free(key);
+	mn::small_str_free(name);
+}
+
 TEST_CASE("str push")
 {
 	auto str = mn::str_new();
@@ -442,6 +606,415 @@ TEST_CASE("map general cases")
 	mn::map_free(num);
 }
 
+// a bad hash which puts all the keys in few probe sequences to stress the group probing
+struct Colliding_Hash
+{
+	inline size_t
+	operator()(int value) const
+	{
+		return size_t(value % 3);
+	}
+};
+
+TEST_CASE("hash bytes")
+{
+	const char text[] = "the quick brown fox jumps over the lazy dog, the quick brown fox jumps over the lazy dog";
+
+	// all the lengths which go through the different paths of the hash function
+	for (size_t len = 0; len < sizeof(text) - 1; ++len)
+	{
+		CHECK(mn::hash_bytes(text, len) == mn::hash_bytes(text, len));
+		CHECK(mn::hash_bytes(text, len) != mn::hash_bytes(text, len + 1));
+	}
+
+	auto str = mn::str_lit("identifier");
+	auto small_str = mn::small_str_from_c("identifier");
+	mn_defer{mn::small_str_free(small_str);};
+	CHECK(mn::Hash<mn::Str>{}(str) == mn::hash_bytes(mn::block_from(str)));
+	CHECK(mn::Hash<mn::Small_Str>{}(small_str) == mn::Hash<mn::Str>{}(str));
+
+	auto old_seed = mn::hash_seed_global;
+	auto old_hash = mn::hash_bytes(text, 5);
+	mn::hash_seed_set(old_seed + 1);
+	CHECK(mn::hash_bytes(text, 5) != old_hash);
+	mn::hash_seed_set(old_seed);
+	CHECK(mn::hash_bytes(text, 5) == old_hash);
+	CHECK(mn::wyhash(text, 5, 1) != mn::wyhash(text, 5, 2));
+}
+
+TEST_CASE("concurrent map")
+{
+	struct Shared
+	{
+		mn::Concurrent_Map<int, int> map;
+		std::atomic<int> make_count;
+	};
+
+	Shared shared{mn::concurrent_map_new<int, int>(8), 0};
+	mn_defer{mn::concurrent_map_free(shared.map);};
+
+	// all the threads race on the same keys and each key should be constructed exactly once
+	auto threads = mn::buf_new<mn::Thread>();
+	for (size_t i = 0; i < 4; ++i)
+	{
+		mn::buf_push(threads, mn::thread_new([](void* arg) {
+			auto self = (Shared*)arg;
+			for (int j = 0; j < 1000; ++j)
+			{
+				auto value = mn::concurrent_map_get_or_insert(self->map, j, [self](int key) {
+					self->make_count.fetch_add(1);
+					return key * 2;
+				});
+				mn_assert(value == j * 2);
+			}
+		}, &shared));
+	}
+	for (auto thread: threads)
+	{
+		mn::thread_join(thread);
+		mn::thread_free(thread);
+	}
+	mn::buf_free(threads);
+
+	CHECK(shared.make_count.load() == 1000);
+	CHECK(mn::concurrent_map_count(shared.map) == 1000);
+
+	for (int i = 0; i < 1000; i += 2)
+		CHECK(mn::concurrent_map_remove(shared.map, i));
+	CHECK(mn::concurrent_map_remove(shared.map, 0) == false);
+	CHECK(mn::concurrent_map_count(shared.map) == 500);
+
+	int value = 0;
+	CHECK(mn::concurrent_map_lookup(shared.map, 2, value) == false);
+	CHECK(mn::concurrent_map_lookup(shared.map, 3, value));
+	CHECK(value == 6);
+
+	mn::concurrent_map_insert(shared.map, 3, 7);
+	CHECK(mn::concurrent_map_lookup(shared.map, 3, value));
+	CHECK(value == 7);
+
+	int sum = 0;
+	mn::concurrent_map_each(shared.map, [&sum](int key, int&) { sum += key; });
+	CHECK(sum == 250000);
+
+	mn::concurrent_map_clear(shared.map);
+	CHECK(mn::concurrent_map_count(shared.map) == 0);
+	CHECK(mn::concurrent_map_contains(shared.map, 3) == false);
+}
+
+TEST_CASE("concurrent map owned values")
+{
+	auto map = mn::concurrent_map_new<mn::Str, mn::Str>(4);
+	mn_defer{mn::destruct(map);};
+	CHECK((uintptr_t(map.shards) & 63) == 0);
+
+	// the key is borrowed and cloned on insert, and the returned value is a clone which the caller owns
+	auto key = mn::str_from_c("key");
+	auto value = mn::concurrent_map_get_or_insert(map, key, [](const mn::Str& k) { return mn::strf("value of {}", k); });
+	mn::str_free(key);
+	CHECK(value == "value of key");
+	mn::str_free(value);
+
+	mn::Str looked_up{};
+	CHECK(mn::concurrent_map_lookup(map, mn::str_lit("key"), looked_up));
+	CHECK(looked_up == "value of key");
+	mn::str_free(looked_up);
+
+	value = mn::concurrent_map_get_or_insert(map, mn::str_lit("key"), [](const mn::Str&) { return mn::str_from_c("unused"); });
+	CHECK(value == "value of key");
+	mn::str_free(value);
+}
+
+TEST_CASE("cache")
+{
+	struct Evicted
+	{
+		mn::Buf<int> keys;
+	};
+
+	Evicted evicted{mn::buf_new<int>()};
+	mn_defer{mn::buf_free(evicted.keys);};
+
+	mn::Cache_Settings<int, mn::Str> settings{};
+	settings.budget = 10;
+	settings.cost = mn::Task<size_t(const int&, const mn::Str&)>::make([](const int&, const mn::Str& value) { return value.count; });
+	settings.on_evict = mn::Task<void(int&, mn::Str&)>::make([&evicted](int& key, mn::Str& value) {
+		mn::buf_push(evicted.keys, key);
+		mn::str_free(value);
+	});
+	auto cache = mn::cache_new<int, mn::Str>(settings);
+	mn_defer{mn::destruct(cache);};
+
+	mn::cache_insert(cache, 1, mn::str_from_c("aaa"));
+	mn::cache_insert(cache, 2, mn::str_from_c("bbb"));
+	mn::cache_insert(cache, 3, mn::str_from_c("ccc"));
+	CHECK(mn::cache_count(cache) == 3);
+	CHECK(mn::cache_cost(cache) == 9);
+
+	// touching 1 makes 2 the least recently used entry
+	auto value = mn::cache_lookup(cache, 1);
+	REQUIRE(value != nullptr);
+	CHECK(*value == "aaa");
+	CHECK(mn::cache_lookup(cache, 4) == nullptr);
+
+	mn::cache_insert(cache, 4, mn::str_from_c("dd"));
+	CHECK(mn::cache_count(cache) == 3);
+	CHECK(mn::cache_cost(cache) == 8);
+	REQUIRE(evicted.keys.count == 1);
+	CHECK(evicted.keys[0] == 2);
+	CHECK(mn::cache_peek(cache, 2) == nullptr);
+
+	// replacing a key evicts its old entry
+	mn::cache_insert(cache, 3, mn::str_from_c("c"));
+	REQUIRE(evicted.keys.count == 2);
+	CHECK(evicted.keys[1] == 3);
+	CHECK(mn::cache_cost(cache) == 6);
+
+	auto order = mn::buf_new<int>();
+	mn_defer{mn::buf_free(order);};
+	mn::cache_each(cache, [&order](const int& key, mn::Str&) { mn::buf_push(order, key); });
+	REQUIRE(order.count == 3);
+	CHECK(order[0] == 3);
+	CHECK(order[1] == 4);
+	CHECK(order[2] == 1);
+
+	CHECK(mn::cache_remove(cache, 4));
+	CHECK(mn::cache_remove(cache, 4) == false);
+	CHECK(evicted.keys[2] == 4);
+
+	// an entry bigger than the budget evicts all the others
+	mn::cache_insert(cache, 5, mn::str_from_c("eeeeeeeeeeee"));
+	CHECK(mn::cache_count(cache) == 1);
+	CHECK(mn::cache_cost(cache) == 12);
+	CHECK(evicted.keys.count == 5);
+
+	mn::cache_trim(cache, 0);
+	CHECK(mn::cache_count(cache) == 0);
+	CHECK(mn::cache_cost(cache) == 0);
+
+	for (int i = 0; i < 100; ++i)
+		mn::cache_insert(cache, i, mn::str_from_c("x"));
+	CHECK(mn::cache_count(cache) == 10);
+	for (int i = 90; i < 100; ++i)
+		CHECK(mn::cache_peek(cache, i) != nullptr);
+	// the slots are reused from the free list so the slab only holds one more slot than the budget allows, which is
+	// the new entry before the least recently used one is evicted
+	CHECK(cache.entries.count == 11);
+}
+
+TEST_CASE("concurrent cache")
+{
+	struct Shared
+	{
+		mn::Concurrent_Cache<int, int> cache;
+		std::atomic<int> evict_count;
+	};
+
+	Shared shared{{}, 0};
+	mn::Cache_Settings<int, int> settings{};
+	settings.budget = 64;
+	settings.cost = mn::Task<size_t(const int&, const int&)>::make([](const int&, const int&) { return size_t(1); });
+	settings.on_evict = mn::Task<void(int&, int&)>::make([&shared](int&, int&) { shared.evict_count.fetch_add(1); });
+	shared.cache = mn::concurrent_cache_new<int, int>(settings, 4);
+	mn_defer{mn::concurrent_cache_free(shared.cache);};
+
+	mn::Fabric_Settings fabric_settings{};
+	fabric_settings.workers_count = 4;
+	auto f = mn::fabric_new(fabric_settings);
+
+	mn::Auto_Waitgroup g;
+	for (int i = 0; i < 4; ++i)
+	{
+		g.add(1);
+		go(f, [&shared, &g] {
+			for (int j = 0; j < 1000; ++j)
+			{
+				auto value = mn::concurrent_cache_get_or_insert(shared.cache, j, [](int key) { return key * 2; });
+				mn_assert(value == j * 2);
+			}
+			g.done();
+		});
+	}
+	g.wait();
+	mn::fabric_free(f);
+
+	// each shard holds at most its slice of the budget
+	CHECK(mn::concurrent_cache_count(shared.cache) <= 64);
+	CHECK(mn::concurrent_cache_cost(shared.cache) == mn::concurrent_cache_count(shared.cache));
+
+	mn::concurrent_cache_insert(shared.cache, 2000, 7);
+	int value = 0;
+	CHECK(mn::concurrent_cache_lookup(shared.cache, 2000, value));
+	CHECK(value == 7);
+	CHECK(mn::concurrent_cache_lookup(shared.cache, -1, value) == false);
+	CHECK(mn::concurrent_cache_remove(shared.cache, 2000));
+	CHECK(mn::concurrent_cache_remove(shared.cache, 2000) == false);
+
+	auto count = mn::concurrent_cache_count(shared.cache);
+	auto evict_count = shared.evict_count.load();
+	mn::concurrent_cache_clear(shared.cache);
+	CHECK(mn::concurrent_cache_count(shared.cache) == 0);
+	CHECK(shared.evict_count.load() == evict_count + int(count));
+}
+
+TEST_CASE("concurrent cache owned values")
+{
+	// the returned values are clones so they outlive the evicted entries, and get_or_insert borrows the key
+	auto cache = mn::concurrent_cache_new<mn::Str, mn::Str>(2 * (sizeof(mn::Str) * 2), 1);
+	mn_defer{mn::destruct(cache);};
+
+	auto key = mn::str_from_c("name");
+	auto value = mn::concurrent_cache_get_or_insert(cache, key, [](const mn::Str& k) { return mn::strf("value of {}", k); });
+	CHECK(value == "value of name");
+	mn::str_free(key);
+
+	auto looked_up = mn::str_new();
+	CHECK(mn::concurrent_cache_lookup(cache, mn::str_lit("name"), looked_up));
+	CHECK(looked_up == "value of name");
+
+	// evict the entry, the strings we got should still be valid
+	mn::concurrent_cache_insert(cache, mn::str_from_c("a"), mn::str_from_c("1"));
+	mn::concurrent_cache_insert(cache, mn::str_from_c("b"), mn::str_from_c("2"));
+	CHECK(mn::concurrent_cache_lookup(cache, mn::str_lit("name"), looked_up) == false);
+	CHECK(value == "value of name");
+	CHECK(looked_up == "value of name");
+
+	mn::str_free(value);
+	mn::str_free(looked_up);
+}
+
+TEST_CASE("ordered map")
+{
+	constexpr int KEYS_COUNT = 20000;
+	auto exists = mn::buf_new<bool>();
+	mn::buf_resize_fill(exists, KEYS_COUNT, false);
+	auto map = mn::ordered_map_new<int, int>();
+
+	test_random_insert_remove(100000, KEYS_COUNT, [&](int key) {
+		CHECK(mn::ordered_map_insert(map, key, key * 2)->key == key);
+		exists[key] = true;
+	}, [&](int key) {
+		CHECK(mn::ordered_map_remove(map, key) == exists[key]);
+		exists[key] = false;
+	});
+
+	// iteration is in ascending order and visits every key exactly once
+	size_t count = 0;
+	int prev_key = -1;
+	for (const auto& [key, value]: map)
+	{
+		CHECK(key > prev_key);
+		CHECK(exists[key]);
+		CHECK(value == key * 2);
+		prev_key = key;
+		++count;
+	}
+	CHECK(map.count == count);
+	for (int key = 0; key < KEYS_COUNT; ++key)
+		CHECK((mn::ordered_map_lookup(map, key) != nullptr) == exists[key]);
+
+	// range queries
+	int expected_key = 100;
+	while (exists[expected_key] == false)
+		++expected_key;
+	CHECK(mn::ordered_map_lower_bound(map, 100)->key == expected_key);
+	CHECK(mn::ordered_map_upper_bound(map, expected_key - 1)->key == expected_key);
+	CHECK(mn::ordered_map_upper_bound(map, expected_key)->key > expected_key);
+	auto upper = mn::ordered_map_upper_bound(map, prev_key);
+	CHECK(upper == mn::ordered_map_end(map));
+	CHECK(mn::ordered_map_lower_bound(map, KEYS_COUNT) == mn::ordered_map_end(map));
+
+	auto copy = mn::ordered_map_memcpy_clone(map);
+	for (int key = 0; key < KEYS_COUNT; ++key)
+		mn::ordered_map_remove(map, key);
+	CHECK(map.count == 0);
+	CHECK(map.root == nullptr);
+	CHECK(copy.count == count);
+
+	mn::ordered_map_free(copy);
+	mn::ordered_map_free(map);
+	mn::buf_free(exists);
+}
+
+TEST_CASE("ordered map from sorted")
+{
+	auto entries = mn::buf_new<mn::Key_Value<mn::Str, int>>();
+	for (int i = 0; i < 1000; ++i)
+		mn::buf_push(entries, mn::Key_Value<mn::Str, int>{mn::strf("key_{:04}", i), i});
+
+	auto map = mn::ordered_map_from_sorted(entries);
+	mn::buf_free(entries);
+	CHECK(map.count == 1000);
+	CHECK(mn::ordered_map_lookup(map, mn::str_lit("key_0500"))->value == 500);
+
+	// prefix scan over the keys which start with key_01
+	int sum = 0;
+	for (auto it = mn::ordered_map_lower_bound(map, mn::str_lit("key_01")); it != mn::ordered_map_end(map); ++it)
+	{
+		if (mn::str_prefix(it->key, "key_01") == false)
+			break;
+		sum += it->value;
+	}
+	CHECK(sum == (100 + 199) * 100 / 2);
+
+	// removing the min key of a subtree keeps the separators valid even when the removed key is freed
+	for (int i = 0; i < 1000; i += 3)
+	{
+		auto key = mn::strf("key_{:04}", i);
+		auto entry = mn::ordered_map_lookup(map, key);
+		auto stored_key = entry->key;
+		CHECK(mn::ordered_map_remove(map, key));
+		mn::str_free(stored_key);
+		mn::str_free(key);
+	}
+	CHECK(map.count == 666);
+	CHECK(mn::ordered_map_lookup(map, mn::str_lit("key_0001"))->value == 1);
+	CHECK(mn::ordered_map_lookup(map, mn::str_lit("key_0999")) == nullptr);
+
+	auto small = mn::ordered_map_new<int, int>();
+	mn::ordered_map_insert(small, 2, 20);
+	mn::ordered_map_insert(small, 1, 10);
+	CHECK(mn::str_tmpf("{}", small) == "[2]{ 1: 10, 2: 20 }");
+	mn::ordered_map_free(small);
+
+	destruct(map);
+}
+
+TEST_CASE("set random insert and remove")
+{
+	constexpr int KEYS_COUNT = 2000;
+	bool exists[KEYS_COUNT] = {};
+	auto num = mn::set_new<int, Colliding_Hash>();
+	auto big = mn::set_new<int>();
+
+	test_random_insert_remove(20000, KEYS_COUNT, [&](int key) {
+		mn::set_insert(num, key);
+		mn::set_insert(big, key * 7919);
+		exists[key] = true;
+	}, [&](int key) {
+		CHECK(mn::set_remove(num, key) == exists[key]);
+		CHECK(mn::set_remove(big, key * 7919) == exists[key]);
+		exists[key] = false;
+	});
+
+	size_t count = 0;
+	for (int key = 0; key < KEYS_COUNT; ++key)
+	{
+		CHECK((mn::set_lookup(num, key) != nullptr) == exists[key]);
+		CHECK((mn::set_lookup(big, key * 7919) != nullptr) == exists[key]);
+		count += exists[key];
+	}
+	CHECK(num.count == count);
+	CHECK(big.count == count);
+
+	// values are dense and every one of them is reachable
+	for (auto key: num)
+		CHECK(*mn::set_lookup(num, key) == key);
+
+	mn::set_free(num);
+	mn::set_free(big);
+}
+
 TEST_CASE("Pool general case")
 {
 	auto pool = mn::pool_new(sizeof(int), 1024);
@@ -570,6 +1143,81 @@ TEST_CASE("Str_Intern general case")
 	mn::str_intern_free(intern);
 }
 
+TEST_CASE("Str_Intern ids")
+{
+	auto intern = mn::str_intern_new();
+	mn_defer{mn::str_intern_free(intern);};
+
+	const char* text = "let x = x + y";
+	auto x = mn::str_intern_id(intern, text + 4, text + 5);
+	auto y = mn::str_intern_id(intern, text + 12, text + 13);
+	CHECK(x != y);
+	CHECK(mn::str_intern_id(intern, "x") == x);
+	CHECK(mn::str_intern_id(intern, text + 8, text + 9) == x);
+	CHECK(mn::str_intern_count(intern) == 2);
+
+	// the interned strings are null terminated copies which don't move when more strings are interned
+	auto x_str = mn::str_intern_str(intern, x);
+	CHECK(x_str == "x");
+	CHECK(x_str.ptr[1] == '\0');
+	for (int i = 0; i < 10000; ++i)
+		mn::str_intern_id(intern, mn::str_tmpf("symbol {}", i));
+	CHECK(mn::str_intern_count(intern) == 10002);
+	CHECK(mn::str_intern_str(intern, x).ptr == x_str.ptr);
+	CHECK(mn::str_intern(intern, "x") == x_str.ptr);
+	CHECK(mn::str_intern_str(intern, mn::str_intern_id(intern, "symbol 9999")) == "symbol 9999");
+}
+
+TEST_CASE("concurrent Str_Intern")
+{
+	auto intern = mn::concurrent_str_intern_new(8);
+	mn_defer{mn::concurrent_str_intern_free(intern);};
+
+	struct Result
+	{
+		uint32_t ids[1000];
+		const char* ptrs[1000];
+	};
+	Result results[4];
+
+	mn::Fabric_Settings settings{};
+	settings.workers_count = 4;
+	auto f = mn::fabric_new(settings);
+
+	// all the workers race on interning the same symbols and they should agree on the ids and pointers
+	mn::Auto_Waitgroup g;
+	for (size_t i = 0; i < 4; ++i)
+	{
+		g.add(1);
+		go(f, [&intern, &g, result = &results[i]] {
+			for (int j = 0; j < 1000; ++j)
+			{
+				auto name = mn::str_tmpf("symbol {}", j);
+				result->ids[j] = mn::concurrent_str_intern_id(intern, name);
+				result->ptrs[j] = mn::concurrent_str_intern(intern, name.ptr, name.ptr + name.count);
+			}
+			g.done();
+		});
+	}
+	g.wait();
+	mn::fabric_free(f);
+
+	CHECK(mn::concurrent_str_intern_count(intern) == 1000);
+	for (size_t i = 1; i < 4; ++i)
+	{
+		CHECK(::memcmp(results[0].ids, results[i].ids, sizeof(results[0].ids)) == 0);
+		CHECK(::memcmp(results[0].ptrs, results[i].ptrs, sizeof(results[0].ptrs)) == 0);
+	}
+
+	for (int j = 0; j < 1000; ++j)
+	{
+		auto str = mn::concurrent_str_intern_str(intern, results[0].ids[j]);
+		CHECK(str.ptr == results[0].ptrs[j]);
+		CHECK(str == mn::str_tmpf("symbol {}", j));
+	}
+	CHECK(mn::concurrent_str_intern(intern, "symbol 7") == results[0].ptrs[7]);
+}
+
 TEST_CASE("simple data ring case")
 {
 	mn::allocator_push(mn::memory::leak());
@@ -632,6 +1280,484 @@ TEST_CASE("complex data ring case")
 	mn::allocator_pop();
 }
 
+TEST_CASE("bloom filter")
+{
+	auto filter = mn::bloom_filter_new<int>(10000, 0.01);
+	mn_defer{mn::bloom_filter_free(filter);};
+	CHECK(mn::bloom_filter_size(filter) % 64 == 0);
+	CHECK((uintptr_t(filter.blocks) & 63) == 0);
+
+	for (int i = 0; i < 10000; ++i)
+		mn::bloom_filter_insert(filter, i);
+	for (int i = 0; i < 10000; ++i)
+		CHECK(mn::bloom_filter_contains(filter, i));
+
+	size_t false_positives = 0;
+	for (int i = 10000; i < 110000; ++i)
+		if (mn::bloom_filter_contains(filter, i))
+			++false_positives;
+	CHECK(false_positives < 1500);
+
+	auto bytes = mn::msgpack_encode(filter);
+	REQUIRE(bytes.err == false);
+	mn_defer{mn::str_free(bytes.val);};
+
+	mn::Bloom_Filter<int> decoded{};
+	mn_defer{mn::bloom_filter_free(decoded);};
+	REQUIRE(mn::msgpack_decode(bytes.val, decoded) == false);
+	CHECK(decoded.blocks_count == filter.blocks_count);
+	CHECK(::memcmp(decoded.blocks, filter.blocks, mn::bloom_filter_size(filter)) == 0);
+	for (int i = 0; i < 10000; ++i)
+		CHECK(mn::bloom_filter_contains(decoded, i));
+
+	auto other = mn::bloom_filter_new<int>(10000, 0.01);
+	mn_defer{mn::bloom_filter_free(other);};
+	mn::bloom_filter_insert(other, -1);
+	mn::bloom_filter_union(decoded, other);
+	CHECK(mn::bloom_filter_contains(decoded, -1));
+
+	mn::bloom_filter_clear(filter);
+	CHECK(mn::bloom_filter_contains(filter, 0) == false);
+}
+
+TEST_CASE("cuckoo filter")
+{
+	auto filter = mn::cuckoo_filter_new<mn::Str>(10000);
+	mn_defer{mn::cuckoo_filter_free(filter);};
+	CHECK(mn::cuckoo_filter_capacity(filter) >= 10000);
+
+	auto keys = mn::buf_new<mn::Str>();
+	mn_defer{destruct(keys);};
+	for (int i = 0; i < 10000; ++i)
+		mn::buf_push(keys, mn::strf("key {}", i));
+
+	for (const auto& key: keys)
+		CHECK(mn::cuckoo_filter_insert(filter, key));
+	CHECK(mn::cuckoo_filter_count(filter) == 10000);
+	for (const auto& key: keys)
+		CHECK(mn::cuckoo_filter_contains(filter, key));
+
+	size_t false_positives = 0;
+	for (int i = 0; i < 100000; ++i)
+	{
+		auto key = mn::str_tmpf("other {}", i);
+		if (mn::cuckoo_filter_contains(filter, key))
+			++false_positives;
+	}
+	CHECK(false_positives < 100);
+
+	auto bytes = mn::msgpack_encode(filter);
+	REQUIRE(bytes.err == false);
+	mn_defer{mn::str_free(bytes.val);};
+
+	// remove half of the keys and make sure the other half is still there
+	for (size_t i = 0; i < keys.count; i += 2)
+		CHECK(mn::cuckoo_filter_remove(filter, keys[i]));
+	CHECK(mn::cuckoo_filter_count(filter) == 5000);
+	for (size_t i = 1; i < keys.count; i += 2)
+		CHECK(mn::cuckoo_filter_contains(filter, keys[i]));
+	size_t removed_found = 0;
+	for (size_t i = 0; i < keys.count; i += 2)
+		if (mn::cuckoo_filter_contains(filter, keys[i]))
+			++removed_found;
+	CHECK(removed_found < 10);
+
+	mn::Cuckoo_Filter<mn::Str> decoded{};
+	mn_defer{mn::cuckoo_filter_free(decoded);};
+	REQUIRE(mn::msgpack_decode(bytes.val, decoded) == false);
+	CHECK(mn::cuckoo_filter_count(decoded) == 10000);
+	for (const auto& key: keys)
+		CHECK(mn::cuckoo_filter_contains(decoded, key));
+
+	// the persisted filter is still valid in a process with another hash seed
+	auto old_seed = mn::hash_seed_global;
+	mn::hash_seed_set(old_seed + 1);
+	for (const auto& key: keys)
+		CHECK(mn::cuckoo_filter_contains(decoded, key));
+	mn::hash_seed_set(old_seed);
+
+	// fill a small filter until it refuses new keys
+	auto small = mn::cuckoo_filter_new<int>(64);
+	mn_defer{mn::cuckoo_filter_free(small);};
+	int inserted = 0;
+	while (mn::cuckoo_filter_insert(small, inserted))
+		++inserted;
+	CHECK(size_t(inserted) >= mn::cuckoo_filter_capacity(small) * 8 / 10);
+	for (int i = 0; i < inserted; ++i)
+		CHECK(mn::cuckoo_filter_contains(small, i));
+	CHECK(mn::cuckoo_filter_remove(small, 0));
+	CHECK(mn::cuckoo_filter_insert(small, 0));
+
+	mn::cuckoo_filter_clear(small);
+	CHECK(mn::cuckoo_filter_count(small) == 0);
+	CHECK(mn::cuckoo_filter_contains(small, 1) == false);
+}
+
+TEST_CASE("bitset")
+{
+	mn::Bitset<130> bits{};
+	CHECK(mn::bitset_any(bits) == false);
+	CHECK(mn::bitset_find_first(bits) == SIZE_MAX);
+	CHECK(mn::bitset_find_first_zero(bits) == 0);
+
+	mn::bitset_set(bits, 0);
+	mn::bitset_set(bits, 63);
+	mn::bitset_set(bits, 64);
+	mn::bitset_set(bits, 129);
+	CHECK(mn::bitset_get(bits, 63));
+	CHECK(mn::bitset_get(bits, 62) == false);
+	CHECK(mn::bitset_count_ones(bits) == 4);
+	CHECK(mn::bitset_find_first(bits) == 0);
+	CHECK(mn::bitset_find_first(bits, 1) == 63);
+	CHECK(mn::bitset_find_first(bits, 65) == 129);
+	CHECK(mn::bitset_find_first_zero(bits) == 1);
+	CHECK(mn::bitset_rank(bits, 64) == 2);
+	CHECK(mn::bitset_rank(bits, 130) == 4);
+	CHECK(mn::bitset_select(bits, 0) == 0);
+	CHECK(mn::bitset_select(bits, 2) == 64);
+	CHECK(mn::bitset_select(bits, 3) == 129);
+	CHECK(mn::bitset_select(bits, 4) == SIZE_MAX);
+
+	mn::bitset_set(bits, 63, false);
+	mn::bitset_flip(bits, 1);
+	mn::bitset_unset(bits, 0);
+	CHECK(mn::bitset_find_first(bits) == 1);
+
+	mn::Bitset<130> other{};
+	mn::bitset_fill(other, true);
+	CHECK(mn::bitset_count_ones(other) == 130);
+	CHECK(mn::bitset_find_first_zero(other) == SIZE_MAX);
+	mn::bitset_andnot(other, bits);
+	CHECK(mn::bitset_count_ones(other) == 127);
+	mn::bitset_xor(other, bits);
+	CHECK(mn::bitset_count_ones(other) == 130);
+	mn::bitset_and(other, bits);
+	CHECK(other == bits);
+	mn::bitset_fill(other, false);
+	mn::bitset_or(other, bits);
+	CHECK(other == bits);
+}
+
+TEST_CASE("bit buf")
+{
+	// we check the bit buffer against a Buf<bool> with the same random values
+	auto bits = mn::bit_buf_new();
+	mn_defer{mn::bit_buf_free(bits);};
+	auto bools = mn::buf_new<bool>();
+	mn_defer{mn::buf_free(bools);};
+
+	uint64_t random = 0x9e3779b97f4a7c15ULL;
+	for (size_t i = 0; i < 1000; ++i)
+	{
+		random ^= random << 13;
+		random ^= random >> 7;
+		random ^= random << 17;
+		bool value = (random % 3) == 0;
+		mn::bit_buf_push(bits, value);
+		mn::buf_push(bools, value);
+	}
+	CHECK(bits.count == 1000);
+	CHECK(bits.words.count == 16);
+
+	size_t ones = 0;
+	for (size_t i = 0; i < bools.count; ++i)
+	{
+		CHECK(mn::bit_buf_get(bits, i) == bools[i]);
+		CHECK(mn::bit_buf_rank(bits, i) == ones);
+		if (bools[i])
+		{
+			CHECK(mn::bit_buf_select(bits, ones) == i);
+			++ones;
+		}
+	}
+	CHECK(mn::bit_buf_count_ones(bits) == ones);
+	CHECK(mn::bit_buf_select(bits, ones) == SIZE_MAX);
+
+	size_t visited = 0;
+	for (auto i = mn::bit_buf_find_first(bits); i != SIZE_MAX; i = mn::bit_buf_find_first(bits, i + 1))
+	{
+		CHECK(bools[i]);
+		++visited;
+	}
+	CHECK(visited == ones);
+
+	auto inverted = mn::bit_buf_with_count(bits.count);
+	mn_defer{mn::bit_buf_free(inverted);};
+	mn::bit_buf_fill(inverted, true);
+	mn::bit_buf_xor(inverted, bits);
+	CHECK(mn::bit_buf_count_ones(inverted) == bits.count - ones);
+	CHECK(mn::bit_buf_find_first(inverted) == mn::bit_buf_find_first_zero(bits));
+
+	auto copy = mn::bit_buf_clone(bits);
+	mn_defer{mn::bit_buf_free(copy);};
+	CHECK(copy == bits);
+	mn::bit_buf_and(copy, inverted);
+	CHECK(mn::bit_buf_count_ones(copy) == 0);
+	mn::bit_buf_or(copy, inverted);
+	CHECK(copy == inverted);
+	mn::bit_buf_andnot(copy, inverted);
+	CHECK(mn::bit_buf_count_ones(copy) == 0);
+
+	// shrinking clears the removed bits so growing again brings back cleared bits
+	mn::bit_buf_fill(copy, true);
+	mn::bit_buf_resize(copy, 70);
+	CHECK(mn::bit_buf_count_ones(copy) == 70);
+	CHECK(mn::bit_buf_pop(copy));
+	mn::bit_buf_resize(copy, 200);
+	CHECK(mn::bit_buf_count_ones(copy) == 69);
+	CHECK(mn::bit_buf_find_first_zero(copy) == 69);
+
+	mn::bit_buf_clear(copy);
+	CHECK(copy.count == 0);
+	CHECK(mn::bit_buf_find_first(copy) == SIZE_MAX);
+}
+
+TEST_CASE("soa buf")
+{
+	auto particles = mn::soa_buf_new<float, double, uint8_t, mn::Str>();
+	mn_defer{mn::destruct(particles);};
+	CHECK(mn::soa_buf_empty(particles));
+
+	for (int i = 0; i < 1000; ++i)
+		CHECK(mn::soa_buf_push(particles, float(i), i * 2.0, uint8_t(i), mn::strf("{}", i)) == size_t(i));
+	CHECK(particles.count == 1000);
+
+	// each field lives in its own aligned array
+	for (auto ptr: particles.ptrs)
+		CHECK(uintptr_t(ptr) % mn::SOA_BUF_ALIGNMENT == 0);
+
+	auto xs = mn::soa_buf_field<0>(particles);
+	auto ys = mn::soa_buf_field<1>(particles);
+	auto tags = mn::soa_buf_field<2>(particles);
+	for (size_t i = 0; i < particles.count; ++i)
+	{
+		CHECK(xs[i] == float(i));
+		CHECK(ys[i] == i * 2.0);
+		CHECK(tags[i] == uint8_t(i));
+	}
+
+	auto row = particles[10];
+	CHECK(mn::soa_row_field<0>(row) == 10.0f);
+	CHECK(mn::soa_row_field<3>(row) == "10");
+	mn::soa_row_field<1>(row) = -1.0;
+	CHECK(ys[10] == -1.0);
+
+	const auto& cparticles = particles;
+	CHECK(mn::soa_row_field<1>(cparticles[10]) == -1.0);
+	CHECK(mn::soa_buf_field<0>(cparticles)[999] == 999.0f);
+
+	// unordered remove moves the last row into the removed one
+	mn::str_free(mn::soa_row_field<3>(particles[0]));
+	mn::soa_buf_remove(particles, 0);
+	CHECK(particles.count == 999);
+	CHECK(mn::soa_row_field<0>(particles[0]) == 999.0f);
+	CHECK(mn::soa_row_field<3>(particles[0]) == "999");
+
+	// ordered remove shifts the rows after the removed one
+	mn::str_free(mn::soa_row_field<3>(particles[1]));
+	mn::soa_buf_remove_ordered(particles, 1);
+	CHECK(particles.count == 998);
+	CHECK(mn::soa_row_field<0>(particles[1]) == 2.0f);
+	CHECK(mn::soa_row_field<3>(particles[997]) == "998");
+
+	auto copy = mn::soa_buf_clone(particles);
+	mn_defer{mn::destruct(copy);};
+	CHECK(copy.count == particles.count);
+	CHECK(mn::soa_row_field<3>(copy[500]) == mn::soa_row_field<3>(particles[500]));
+	CHECK(mn::soa_row_field<3>(copy[500]).ptr != mn::soa_row_field<3>(particles[500]).ptr);
+
+	auto numbers = mn::soa_buf_with_count<int, int>(100);
+	mn_defer{mn::soa_buf_free(numbers);};
+	for (size_t i = 0; i < numbers.count; ++i)
+	{
+		mn::soa_buf_field<0>(numbers)[i] = int(i);
+		mn::soa_buf_field<1>(numbers)[i] = int(i) * 3;
+	}
+	mn::soa_buf_resize(numbers, 1000);
+	CHECK(numbers.cap >= 1000);
+	CHECK(mn::soa_buf_field<1>(numbers)[99] == 297);
+	mn::soa_buf_pop(numbers);
+	CHECK(numbers.count == 999);
+	mn::soa_buf_clear(numbers);
+	CHECK(mn::soa_buf_empty(numbers));
+}
+
+TEST_CASE("ring bulk push and pop")
+{
+	auto r = mn::ring_new<int>();
+	mn_defer{mn::ring_free(r);};
+
+	int values[100];
+	for (int i = 0; i < 100; ++i)
+		values[i] = i;
+
+	// move the head near the end of the memory so the bulk operations wrap around
+	mn::ring_push_back_n(r, values, 10);
+	CHECK(r.cap == 16);
+	CHECK(mn::ring_pop_front_n(r, (int*)nullptr, 7) == 7);
+	mn::ring_push_back_n(r, values + 10, 10);
+	CHECK(r.count == 13);
+	CHECK(r.cap == 16);
+	for (size_t i = 0; i < r.count; ++i)
+		CHECK(r[i] == int(i + 7));
+
+	// growing keeps the capacity a power of two and keeps the order
+	mn::ring_push_front(r, 6);
+	mn::ring_push_back_n(r, values + 20, 80);
+	CHECK(r.count == 94);
+	CHECK(r.cap == 128);
+	for (size_t i = 0; i < r.count; ++i)
+		CHECK(r[i] == int(i + 6));
+
+	int out[100] = {};
+	CHECK(mn::ring_pop_front_n(r, out, 50) == 50);
+	for (int i = 0; i < 50; ++i)
+		CHECK(out[i] == i + 6);
+	CHECK(mn::ring_pop_front_n(r, out, 100) == 44);
+	for (int i = 0; i < 44; ++i)
+		CHECK(out[i] == i + 56);
+	CHECK(mn::ring_empty(r));
+	CHECK(mn::ring_pop_front_n(r, out, 10) == 0);
+}
+
+TEST_CASE("spsc ring")
+{
+	SUBCASE("single thread")
+	{
+		auto r = mn::spsc_ring_new<int>(6);
+		mn_defer{mn::spsc_ring_free(r);};
+		CHECK(r->cap == 8);
+
+		int values[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+		CHECK(mn::spsc_ring_try_push_n(r, values, 5) == 5);
+
+		int out[10] = {};
+		CHECK(mn::spsc_ring_try_pop_n(r, out, 3) == 3);
+		CHECK((out[0] == 0 && out[1] == 1 && out[2] == 2));
+
+		// the push wraps around and is cut at the capacity
+		CHECK(mn::spsc_ring_try_push_n(r, values + 5, 5) == 5);
+		CHECK(mn::spsc_ring_try_push(r, 10) == true);
+		CHECK(mn::spsc_ring_try_push(r, 11) == false);
+		CHECK(mn::spsc_ring_count(r) == 8);
+
+		CHECK(mn::spsc_ring_try_pop_n(r, out, 10) == 8);
+		for (int i = 0; i < 8; ++i)
+			CHECK(out[i] == i + 3);
+
+		int value = 0;
+		CHECK(mn::spsc_ring_try_pop(r, value) == false);
+		mn::spsc_ring_close(r);
+		CHECK(mn::spsc_ring_push(r, 1) == false);
+		CHECK(mn::spsc_ring_pop(r, value) == false);
+	}
+
+	SUBCASE("producer consumer")
+	{
+		constexpr size_t COUNT = 1000000;
+		auto r = mn::spsc_ring_new<size_t>(64);
+		mn_defer{mn::spsc_ring_free(r);};
+
+		auto producer = mn::thread_new([](void* arg) {
+			auto r = (mn::Spsc_Ring<size_t>)arg;
+			size_t batch[16];
+			for (size_t i = 0; i < COUNT;)
+			{
+				// mix the blocking single push with the batch push
+				if (i % 1000 < 500)
+				{
+					mn::spsc_ring_push(r, i++);
+				}
+				else
+				{
+					size_t count = COUNT - i < 16 ? COUNT - i : 16;
+					for (size_t j = 0; j < count; ++j)
+						batch[j] = i + j;
+					mn::spsc_ring_push_n(r, batch, count);
+					i += count;
+				}
+			}
+			mn::spsc_ring_close(r);
+		}, r, "spsc producer");
+
+		// mix the blocking single pop with the batch pop
+		size_t expected = 0;
+		bool in_order = true;
+		size_t value = 0;
+		size_t batch[10];
+		while (true)
+		{
+			if (expected % 2 == 0)
+			{
+				if (mn::spsc_ring_pop(r, value) == false)
+					break;
+				in_order &= value == expected++;
+			}
+			else
+			{
+				auto count = mn::spsc_ring_pop_n(r, batch, 10);
+				if (count == 0)
+					break;
+				for (size_t i = 0; i < count; ++i)
+					in_order &= batch[i] == expected++;
+			}
+		}
+		mn::thread_join(producer);
+		mn::thread_free(producer);
+
+		CHECK(in_order);
+		CHECK(expected == COUNT);
+	}
+}
+
+TEST_CASE("leak allocator grouped report")
+{
+	auto leak = mn::alloc_construct<mn::memory::Leak>();
+	leak->report_on_destruct = false;
+
+	mn::Block blocks[8];
+	for (auto& block: blocks)
+		block = mn::alloc_from(leak, 32, alignof(int));
+
+	auto threads = mn::buf_new<mn::Thread>();
+	for (size_t i = 0; i < 4; ++i)
+	{
+		mn::buf_push(threads, mn::thread_new([](void* arg) {
+			auto self = (mn::Allocator)arg;
+			for (size_t j = 0; j < 1000; ++j)
+				mn::free_from(self, mn::alloc_from(self, j + 1, alignof(char)));
+		}, leak));
+	}
+	for (auto thread: threads)
+	{
+		mn::thread_join(thread);
+		mn::thread_free(thread);
+	}
+	mn::buf_free(threads);
+
+	auto out = mn::memory_stream_new();
+	CHECK(leak->report_grouped_to(out) == 8);
+	CHECK(mn::str_find(out->str, "Leaks count: 8, Leaks size(bytes): 256", 0) != SIZE_MAX);
+	mn::memory_stream_free(out);
+
+	// the report is written after the locks are released so the stream can allocate from the leak allocator itself
+	auto leak_out = mn::memory_stream_new(leak);
+	// the 8 leaked blocks and the stream itself
+	CHECK(leak->report_grouped_to(leak_out) == 9);
+	CHECK(leak_out->str.count > 0);
+	mn::memory_stream_free(leak_out);
+
+	for (auto& block: blocks)
+		mn::free_from(leak, block);
+
+	out = mn::memory_stream_new();
+	CHECK(leak->report_grouped_to(out) == 0);
+	CHECK(out->str.count == 0);
+	mn::memory_stream_free(out);
+
+	mn::allocator_free(leak);
+}
+
 TEST_CASE("Rune")
 {
 	CHECK(mn::rune_upper('a') == 'A');
@@ -766,6 +1892,108 @@ TEST_CASE("Deque")
 
 		mn::deque_free(nums);
 	}
+
+	SUBCASE("deque segments")
+	{
+		auto nums = mn::deque_new<int>();
+		CHECK((nums.bucket_size & nums.bucket_mask) == 0);
+		for (int i = 0; i < 3000; ++i)
+			mn::deque_push_back(nums, i);
+		for (int i = 1; i <= 3000; ++i)
+			mn::deque_push_front(nums, -i);
+
+		int expected = -3000;
+		size_t segments_count = 0;
+		for (auto segment: mn::deque_segments(nums))
+		{
+			CHECK(segment.count > 0);
+			CHECK(segment.count <= nums.bucket_size);
+			for (auto value: segment)
+				CHECK(value == expected++);
+			++segments_count;
+		}
+		CHECK(expected == 3000);
+		CHECK(segments_count <= nums.bucket_count);
+
+		auto segment = mn::deque_segment(nums, 5000);
+		CHECK(segment[0] == 2000);
+		CHECK(&segment[0] == &nums[5000]);
+
+		const auto& cnums = nums;
+		size_t total = 0;
+		for (auto segment: mn::deque_segments(cnums))
+			total += segment.count;
+		CHECK(total == 6000);
+
+		mn::deque_free(nums);
+	}
+
+	SUBCASE("deque bulk push and pop")
+	{
+		auto values = mn::buf_new<int>();
+		for (int i = 0; i < 5000; ++i)
+			mn::buf_push(values, i);
+
+		auto nums = mn::deque_new<int>();
+		mn::deque_push_back_n(nums, values.ptr, 2500);
+		mn::deque_push_front_n(nums, values.ptr + 2500, 2500);
+		CHECK(nums.count == 5000);
+		for (int i = 0; i < 2500; ++i)
+		{
+			CHECK(nums[i] == i + 2500);
+			CHECK(nums[i + 2500] == i);
+		}
+
+		int out[3000];
+		CHECK(mn::deque_pop_front_n(nums, out, 3000) == 3000);
+		for (int i = 0; i < 2500; ++i)
+			CHECK(out[i] == i + 2500);
+		for (int i = 2500; i < 3000; ++i)
+			CHECK(out[i] == i - 2500);
+		CHECK(mn::deque_front(nums) == 500);
+
+		CHECK(mn::deque_pop_back_n(nums, out, 1000) == 1000);
+		for (int i = 0; i < 1000; ++i)
+			CHECK(out[i] == i + 1500);
+		CHECK(mn::deque_back(nums) == 1499);
+
+		CHECK(mn::deque_pop_back_n(nums, (int*)nullptr, 100000) == 1000);
+		CHECK(nums.count == 0);
+
+		mn::deque_push_back_n(nums, values);
+		for (size_t i = 0; i < values.count; ++i)
+			CHECK(nums[i] == values[i]);
+
+		mn::deque_free(nums);
+		mn::buf_free(values);
+	}
+
+	SUBCASE("drained deque reuses its buckets")
+	{
+		auto nums = mn::deque_new<int>();
+		for (int i = 0; i < 10000; ++i)
+		{
+			mn::deque_push_front(nums, i);
+			mn::deque_pop_back(nums);
+		}
+		CHECK(nums.bucket_count <= 2);
+
+		for (int i = 0; i < 10000; ++i)
+		{
+			mn::deque_push_front(nums, i);
+			mn::deque_pop_front(nums);
+		}
+		CHECK(nums.bucket_count <= 2);
+
+		for (int i = 0; i < 10000; ++i)
+		{
+			mn::deque_push_back(nums, i);
+			mn::deque_pop_front(nums);
+		}
+		CHECK(nums.bucket_count <= 2);
+
+		mn::deque_free(nums);
+	}
 }
 
 mn::Result<int> my_div(int a, int b)
@@ -816,6 +2044,203 @@ TEST_CASE("Result error code")
 	}
 }
 
+TEST_CASE("buf sort")
+{
+	uint32_t x = TEST_RANDOM_SEED;
+	auto next = [&x] { return test_random_next(x); };
+
+	auto nums = mn::buf_new<int>();
+	mn_defer{mn::buf_free(nums);};
+
+	// random, few unique values, sorted, and reverse sorted inputs
+	for (int pattern = 0; pattern < 4; ++pattern)
+	{
+		mn::buf_clear(nums);
+		for (int i = 0; i < 10000; ++i)
+		{
+			if (pattern == 0)
+				mn::buf_push(nums, int(next()));
+			else if (pattern == 1)
+				mn::buf_push(nums, int(next() % 4));
+			else if (pattern == 2)
+				mn::buf_push(nums, i);
+			else
+				mn::buf_push(nums, -i);
+		}
+		mn::buf_sort(nums);
+		CHECK(mn::buf_is_sorted(nums));
+	}
+
+	mn::buf_sort(nums, [](int a, int b) { return a > b; });
+	CHECK(mn::buf_is_sorted(nums, [](int a, int b) { return a > b; }));
+
+	mn::buf_clear(nums);
+	for (int i = 0; i < 10000; ++i)
+		mn::buf_push(nums, int(next()));
+	mn::buf_radix_sort(nums);
+	CHECK(mn::buf_is_sorted(nums));
+
+	auto floats = mn::buf_new<float>();
+	mn_defer{mn::buf_free(floats);};
+	for (int i = 0; i < 1000; ++i)
+		mn::buf_push(floats, float(int(next() % 2001) - 1000) / 8.0f);
+	mn::buf_push(floats, -0.0f);
+	mn::buf_push(floats, 0.0f);
+	mn::buf_radix_sort(floats);
+	CHECK(mn::buf_is_sorted(floats));
+
+	// the keys of every integer type map to a single radix key regardless of the platform's fixed width typedefs
+	auto radix_sort_check = [&](auto zero) {
+		using T = decltype(zero);
+		auto values = mn::buf_new<T>();
+		mn_defer{mn::buf_free(values);};
+		for (int i = 0; i < 1000; ++i)
+			mn::buf_push(values, T(int32_t(next())));
+		mn::buf_radix_sort(values);
+		return mn::buf_is_sorted(values);
+	};
+	CHECK(radix_sort_check(char(0)));
+	CHECK(radix_sort_check((signed char)0));
+	CHECK(radix_sort_check(short(0)));
+	CHECK(radix_sort_check(0L));
+	CHECK(radix_sort_check(0LL));
+	CHECK(radix_sort_check(0UL));
+	CHECK(radix_sort_check(0ULL));
+	CHECK(radix_sort_check(size_t(0)));
+	CHECK(radix_sort_check(0.0));
+
+	// radix sort is stable so equal keys keep their order
+	struct Person { int age; int id; };
+	auto people = mn::buf_new<Person>();
+	mn_defer{mn::buf_free(people);};
+	for (int i = 0; i < 1000; ++i)
+		mn::buf_push(people, Person{int(next() % 50), i});
+	mn::buf_radix_sort(people, [](const Person& p) { return p.age; });
+	for (size_t i = 1; i < people.count; ++i)
+	{
+		CHECK(people[i - 1].age <= people[i].age);
+		if (people[i - 1].age == people[i].age)
+			CHECK(people[i - 1].id < people[i].id);
+	}
+
+	mn::Fabric_Settings settings{};
+	settings.workers_count = 4;
+	auto f = mn::fabric_new(settings);
+	mn_defer{mn::fabric_free(f);};
+
+	mn::buf_clear(nums);
+	for (int i = 0; i < 1000003; ++i)
+		mn::buf_push(nums, int(next()));
+	auto sum_before = 0LL;
+	for (auto num: nums)
+		sum_before += num;
+	mn::buf_sort_parallel(f, nums);
+	CHECK(mn::buf_is_sorted(nums));
+	auto sum_after = 0LL;
+	for (auto num: nums)
+		sum_after += num;
+	CHECK(sum_before == sum_after);
+}
+
+TEST_CASE("heap")
+{
+	SUBCASE("binary heap")
+	{
+		auto heap = mn::heap_new<int>();
+		mn_defer{mn::heap_free(heap);};
+
+		for (int i: {5, 3, 8, 1, 9, 2, 7})
+			mn::heap_push(heap, i);
+		CHECK(mn::heap_count(heap) == 7);
+		CHECK(mn::heap_top(heap) == 1);
+
+		int expected[] = {1, 2, 3, 5, 7, 8, 9};
+		for (auto num: expected)
+			CHECK(mn::heap_pop(heap) == num);
+		CHECK(mn::heap_empty(heap));
+	}
+
+	SUBCASE("max heap")
+	{
+		struct Greater
+		{
+			bool operator()(int a, int b) const { return a > b; }
+		};
+
+		auto heap = mn::heap4_new<int, Greater>();
+		mn_defer{mn::heap_free(heap);};
+
+		for (int i = 0; i < 100; ++i)
+			mn::heap_push(heap, (i * 37) % 100);
+		for (int i = 99; i >= 0; --i)
+			CHECK(mn::heap_pop(heap) == i);
+	}
+
+	SUBCASE("handles")
+	{
+		auto heap = mn::heap4_new<int>();
+		mn_defer{mn::heap_free(heap);};
+
+		mn::Heap_Handle handles[10];
+		for (int i = 0; i < 10; ++i)
+			handles[i] = mn::heap_push_handle(heap, (i + 1) * 10);
+
+		mn::heap_decrease_key(heap, handles[7], 5);
+		CHECK(mn::heap_top(heap) == 5);
+		CHECK(mn::heap_top_handle(heap).id == handles[7].id);
+
+		mn::heap_update(heap, handles[7], 1000);
+		CHECK(mn::heap_top(heap) == 10);
+		CHECK(mn::heap_get(heap, handles[7]) == 1000);
+
+		CHECK(mn::heap_remove(heap, handles[0]) == 10);
+		CHECK(mn::heap_remove(heap, handles[4]) == 50);
+		CHECK(mn::heap_count(heap) == 8);
+
+		// removed handles are reused by the next push
+		auto handle = mn::heap_push_handle(heap, 15);
+		mn::heap_push(heap, 25);
+		CHECK((handle.id == handles[0].id || handle.id == handles[4].id));
+		CHECK(mn::heap_get(heap, handle) == 15);
+
+		int expected[] = {15, 20, 25, 30, 40, 60, 70, 90, 100, 1000};
+		for (auto num: expected)
+			CHECK(mn::heap_pop(heap) == num);
+	}
+
+	SUBCASE("from buf")
+	{
+		uint64_t x = 0x9E3779B97F4A7C15ULL;
+		auto nums = mn::buf_new<int>();
+		mn_defer{mn::buf_free(nums);};
+		for (int i = 0; i < 1000; ++i)
+		{
+			x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+			mn::buf_push(nums, int(x % 500));
+		}
+
+		auto heap = mn::heap_from_buf<int, mn::Heap_Less<int>, 4>(nums);
+		mn_defer{mn::heap_free(heap);};
+		CHECK(mn::heap_count(heap) == nums.count);
+
+		auto handle = mn::heap_push_handle(heap, 1000);
+		mn::heap_decrease_key(heap, handle, -1);
+		CHECK(mn::heap_top_handle(heap).id == handle.id);
+		CHECK(mn::heap_pop(heap) == -1);
+
+		mn::buf_sort(nums);
+
+		auto prev = mn::heap_pop(heap);
+		CHECK(prev >= nums[0]);
+		while (mn::heap_empty(heap) == false)
+		{
+			auto num = mn::heap_pop(heap);
+			CHECK(prev <= num);
+			prev = num;
+		}
+	}
+}
+
 TEST_CASE("fabric simple creation")
 {
 	mn::Fabric_Settings settings{};
@@ -844,6 +2269,107 @@ TEST_CASE("fabric simple function")
 	mn::fabric_free(f);
 }
 
+TEST_CASE("fabric task scratch")
+{
+	mn::Fabric_Settings settings{};
+	settings.workers_count = 1;
+	settings.scratch_retained_memory_cap = 8 * 1024 * 1024;
+	auto f = mn::fabric_new(settings);
+
+	size_t used_mem[4] = {};
+	size_t spare_mem[4] = {};
+	for (size_t i = 0; i < 4; ++i)
+	{
+		mn::Auto_Waitgroup g;
+		g.add(1);
+		go(f, [&, i] {
+			auto tmp = mn::memory::tmp();
+			used_mem[i] = tmp->used_mem;
+			spare_mem[i] = tmp->spare_mem;
+			for (size_t j = 0; j < 16; ++j)
+				mn::alloc_from(tmp, 512 * 1024, alignof(int));
+			g.done();
+		});
+		g.wait();
+	}
+
+	// each task starts with an empty scratch and reuses the pages retained from the previous one
+	for (size_t i = 0; i < 4; ++i)
+		CHECK(used_mem[i] == 0);
+	CHECK(spare_mem[1] > 0);
+	CHECK(spare_mem[1] <= 8 * 1024 * 1024);
+	CHECK(spare_mem[2] == spare_mem[1]);
+	CHECK(spare_mem[3] == spare_mem[1]);
+
+	mn::fabric_free(f);
+
+	// with the retention turned off each task starts with no spare pages
+	settings.scratch_retained_memory_cap = mn::FABRIC_SCRATCH_RETAIN_NOTHING;
+	f = mn::fabric_new(settings);
+	for (size_t i = 0; i < 2; ++i)
+	{
+		mn::Auto_Waitgroup g;
+		g.add(1);
+		go(f, [&, i] {
+			auto tmp = mn::memory::tmp();
+			spare_mem[i] = tmp->spare_mem;
+			for (size_t j = 0; j < 16; ++j)
+				mn::alloc_from(tmp, 512 * 1024, alignof(int));
+			g.done();
+		});
+		g.wait();
+	}
+	CHECK(spare_mem[0] == 0);
+	CHECK(spare_mem[1] == 0);
+
+	mn::fabric_free(f);
+
+	auto arena = mn::allocator_arena_new(1024);
+	// each node holds a single allocation of 4096 bytes + alignment - 1, only 2 of them fit in the spare memory cap
+	size_t node_size = 4096 + alignof(int) - 1;
+	arena->spare_mem_cap = 2 * node_size + 1;
+	auto checkpoint = mn::allocator_arena_checkpoint(arena);
+	for (size_t i = 0; i < 4; ++i)
+		mn::alloc_from(arena, 4096, alignof(int));
+	mn::allocator_arena_restore(arena, checkpoint);
+	CHECK(arena->total_mem == 0);
+	CHECK(arena->spare_mem == 2 * node_size);
+	mn::alloc_from(arena, 4096, alignof(int));
+	CHECK(arena->spare_mem == node_size);
+	mn::allocator_free(arena);
+}
+
+TEST_CASE("fabric worker hooks scratch")
+{
+	mn::Fabric_Settings settings{};
+	settings.workers_count = 1;
+	settings.on_worker_start = mn::Task<void()>::make([] {
+		mn::alloc_from(mn::memory::tmp(), 1024 * 1024, alignof(int));
+	});
+	settings.after_each_job = mn::Task<void()>::make([] {
+		mn::alloc_from(mn::memory::tmp(), 1024 * 1024, alignof(int));
+	});
+	auto f = mn::fabric_new(settings);
+
+	size_t used_mem[4] = {};
+	for (size_t i = 0; i < 4; ++i)
+	{
+		mn::Auto_Waitgroup g;
+		g.add(1);
+		go(f, [&, i] {
+			used_mem[i] = mn::memory::tmp()->used_mem;
+			g.done();
+		});
+		g.wait();
+	}
+
+	// the tmp memory of the worker hooks is reclaimed before the next job runs
+	for (size_t i = 0; i < 4; ++i)
+		CHECK(used_mem[i] == 0);
+
+	mn::fabric_free(f);
+}
+
 TEST_CASE("unbuffered channel with multiple workers")
 {
 	mn::Fabric_Settings settings{};
@@ -1055,6 +2581,152 @@ TEST_CASE("future")
 	mn::fabric_free(f);
 }
 
+TEST_CASE("arena destructors")
+{
+	struct Destruct_Counter
+	{
+		int* order;
+		int* count;
+		int id;
+
+		~Destruct_Counter()
+		{
+			order[(*count)++] = id;
+		}
+	};
+
+	auto arena = mn::allocator_arena_new(64);
+
+	int order[8] = {};
+	int count = 0;
+	mn::arena_construct<Destruct_Counter>(arena, Destruct_Counter{order, &count, 1});
+	auto checkpoint = mn::allocator_arena_checkpoint(arena);
+	mn::arena_construct<Destruct_Counter>(arena, Destruct_Counter{order, &count, 2});
+	mn::arena_construct<Destruct_Counter>(arena, Destruct_Counter{order, &count, 3});
+	// the temporaries passed above are destructed as well
+	CHECK(count == 3);
+	count = 0;
+
+	mn::allocator_arena_restore(arena, checkpoint);
+	CHECK(count == 2);
+	CHECK(order[0] == 3);
+	CHECK(order[1] == 2);
+
+	mn::allocator_arena_clear_all(arena);
+	CHECK(count == 3);
+	CHECK(order[2] == 1);
+
+	{
+		mn::Arena_Scope scope{arena};
+		auto name = mn::arena_construct<mn::Str>(arena, mn::str_from_c("request name which is long enough"));
+		auto nums = mn::arena_construct<mn::Buf<mn::Str>>(arena, mn::buf_with_allocator<mn::Str>(mn::memory::clib()));
+		mn::buf_push(*nums, mn::str_with_allocator(mn::memory::clib()));
+		mn::str_push(nums->ptr[0], *name);
+		CHECK(nums->ptr[0] == "request name which is long enough");
+		CHECK(mn::allocator_arena_owns(arena, name));
+		// alignment is respected
+		auto d = mn::arena_construct<double>(arena, 1.0);
+		CHECK(uintptr_t(d) % alignof(double) == 0);
+	}
+	CHECK(arena->used_mem == 0);
+
+	mn::allocator_free(arena);
+}
+
+TEST_CASE("allocator realloc")
+{
+	auto arena = mn::allocator_arena_new(64 * 1024);
+
+	// the top allocation of the arena grows in place
+	auto nums = mn::buf_with_allocator<int>(arena);
+	for (int i = 0; i < 512; ++i)
+		mn::buf_push(nums, i);
+	auto first_ptr = nums.ptr;
+	for (int i = 512; i < 900; ++i)
+		mn::buf_push(nums, i);
+	CHECK(nums.ptr == first_ptr);
+	for (int i = 0; i < 900; ++i)
+		CHECK(nums[i] == i);
+
+	// anything but the top allocation can't be resized
+	auto block = mn::alloc_from(arena, 64, alignof(int));
+	mn::alloc_from(arena, 64, alignof(int));
+	CHECK(arena->realloc(block, 128, alignof(int)).ptr == nullptr);
+	mn::allocator_arena_clear_all(arena);
+
+	// ring keeps its order when it's resized while wrapped around
+	auto ring = mn::ring_with_allocator<int>(arena);
+	for (int i = 0; i < 8; ++i)
+		mn::ring_push_back(ring, i);
+	mn::ring_pop_front(ring);
+	mn::ring_pop_front(ring);
+	mn::ring_push_back(ring, 8);
+	mn::ring_push_back(ring, 9);
+	mn::ring_push_front(ring, 1);
+	for (int i = 10; i < 20; ++i)
+		mn::ring_push_back(ring, i);
+	CHECK(ring.count == 19);
+	for (int i = 0; i < 19; ++i)
+		CHECK(ring[i] == i + 1);
+
+	mn::allocator_free(arena);
+
+	auto str = mn::str_with_allocator(mn::memory::clib());
+	for (int i = 0; i < 1000; ++i)
+		mn::str_push(str, "abc");
+	CHECK(str.count == 3000);
+	CHECK(mn::str_suffix(str, "abcabc"));
+	mn::str_free(str);
+
+	auto page = mn::alloc_from(mn::memory::virtual_mem(), 4096, alignof(int));
+	::memset(page.ptr, 0xAB, page.size);
+	auto resized_page = mn::memory::virtual_mem()->realloc(page, 1024 * 1024, alignof(int));
+	if (resized_page.ptr)
+	{
+		CHECK(((uint8_t*)resized_page.ptr)[4095] == 0xAB);
+		page = resized_page;
+	}
+	mn::free_from(mn::memory::virtual_mem(), page);
+}
+
+TEST_CASE("allocator stack growth")
+{
+	auto base = mn::allocator_top();
+
+	auto arenas = mn::buf_new<mn::memory::Arena*>();
+	for (size_t i = 0; i < mn::Context::ALLOCATOR_INLINE_CAPACITY * 3; ++i)
+		mn::buf_push(arenas, mn::allocator_arena_new(1024));
+
+	for (auto arena: arenas)
+	{
+		mn::allocator_push(arena);
+		CHECK(mn::allocator_top() == arena);
+	}
+
+	auto str = mn::str_from_c("allocated from the top arena");
+	CHECK(str.allocator == mn::buf_top(arenas));
+
+	for (size_t i = arenas.count; i > 0; --i)
+	{
+		CHECK(mn::allocator_top() == arenas[i - 1]);
+		mn::allocator_pop();
+	}
+	CHECK(mn::allocator_top() == base);
+
+	mn::Context other;
+	mn::context_init(&other);
+	auto old = mn::context_local(&other);
+	mn::allocator_push(arenas[0]);
+	CHECK(mn::allocator_top() == arenas[0]);
+	mn::context_local(old);
+	CHECK(mn::allocator_top() == base);
+	mn::context_free(&other);
+
+	for (auto arena: arenas)
+		mn::allocator_free(arena);
+	mn::buf_free(arenas);
+}
+
 TEST_CASE("buddy")
 {
 	auto buddy = mn::allocator_buddy_new();
@@ -1069,6 +2741,199 @@ TEST_CASE("buddy")
 	mn::allocator_free(buddy);
 }
 
+TEST_CASE("concurrent buddy")
+{
+	auto buddy = mn::allocator_concurrent_buddy_new();
+	auto nums = mn::buf_with_allocator<int>(buddy);
+	for(int i = 0; i < 1000; ++i)
+		mn::buf_push(nums, i);
+	auto test = mn::alloc_from(buddy, 1024*1024 - 16, alignof(int));
+	CHECK(test.ptr == nullptr);
+	for(int i = 0; i < 1000; ++i)
+		CHECK(nums[i] == i);
+	mn::buf_free(nums);
+
+	// after everything is freed the blocks should merge back into a single block which spans the whole heap
+	auto whole = mn::alloc_from(buddy, 1024*1024 - 8, alignof(int));
+	CHECK(whole.ptr != nullptr);
+	mn::free_from(buddy, whole);
+
+	auto threads = mn::buf_new<mn::Thread>();
+	for (size_t i = 0; i < 4; ++i)
+	{
+		mn::buf_push(threads, mn::thread_new([](void* arg) {
+			auto self = (mn::Allocator)arg;
+			mn::Block blocks[64];
+			for (size_t j = 0; j < 100; ++j)
+			{
+				for (size_t k = 0; k < 64; ++k)
+				{
+					blocks[k] = mn::alloc_from(self, (k + 1) * 8, alignof(char));
+					::memset(blocks[k].ptr, int(k), blocks[k].size);
+				}
+				for (size_t k = 0; k < 64; ++k)
+				{
+					CHECK(((uint8_t*)blocks[k].ptr)[blocks[k].size - 1] == k);
+					mn::free_from(self, blocks[k]);
+				}
+			}
+		}, buddy));
+	}
+	for (auto thread: threads)
+	{
+		mn::thread_join(thread);
+		mn::thread_free(thread);
+	}
+	mn::buf_free(threads);
+
+	whole = mn::alloc_from(buddy, 1024*1024 - 8, alignof(int));
+	CHECK(whole.ptr != nullptr);
+	mn::free_from(buddy, whole);
+
+	mn::allocator_free(buddy);
+}
+
+TEST_CASE("concurrent buddy drain")
+{
+	// each free merges the heap back into the top block and each alloc splits it again, so the orders are empty for
+	// a moment while another thread is splitting or merging, which shouldn't be reported as out of memory
+	struct Shared
+	{
+		mn::memory::Concurrent_Buddy* buddy;
+		std::atomic<size_t> failed_count;
+	};
+
+	Shared shared{};
+	shared.buddy = mn::allocator_concurrent_buddy_new();
+	CHECK((uintptr_t(shared.buddy->orders) & 63) == 0);
+
+	auto threads = mn::buf_new<mn::Thread>();
+	for (size_t i = 0; i < 2; ++i)
+	{
+		mn::buf_push(threads, mn::thread_new([](void* arg) {
+			auto self = (Shared*)arg;
+			for (size_t j = 0; j < 100000; ++j)
+			{
+				auto block = mn::alloc_from(self->buddy, 64, alignof(char));
+				if (block.ptr == nullptr)
+				{
+					self->failed_count.fetch_add(1);
+					continue;
+				}
+				mn::free_from(self->buddy, block);
+			}
+		}, &shared));
+	}
+	for (auto thread: threads)
+	{
+		mn::thread_join(thread);
+		mn::thread_free(thread);
+	}
+	mn::buf_free(threads);
+
+	CHECK(shared.failed_count == 0);
+	mn::allocator_free(shared.buddy);
+}
+
+TEST_CASE("stats allocator")
+{
+	auto stats = mn::allocator_stats_new("unittest");
+	CHECK((uintptr_t(stats->shards) & 63) == 0);
+
+	auto a = mn::alloc_from(stats, 16, alignof(int));
+	auto b = mn::alloc_from(stats, 100, alignof(int));
+	auto c = mn::alloc_from(stats, 4096, alignof(int));
+
+	auto counters = mn::allocator_stats_snapshot(stats);
+	CHECK(counters.live_bytes == 16 + 100 + 4096);
+	CHECK(counters.peak_bytes == 16 + 100 + 4096);
+	CHECK(counters.alloc_count == 3);
+	CHECK(counters.free_count == 0);
+	CHECK(counters.size_classes[4] == 1);
+	CHECK(counters.size_classes[7] == 1);
+	CHECK(counters.size_classes[12] == 1);
+
+	mn::free_from(stats, b);
+	mn::free_from(stats, c);
+
+	counters = mn::allocator_stats_snapshot(stats);
+	CHECK(counters.live_bytes == 16);
+	CHECK(counters.peak_bytes == 16 + 100 + 4096);
+	CHECK(counters.allocated_bytes == 16 + 100 + 4096);
+	CHECK(counters.free_count == 2);
+
+	auto threads = mn::buf_new<mn::Thread>();
+	for (size_t i = 0; i < 4; ++i)
+	{
+		mn::buf_push(threads, mn::thread_new([](void* arg) {
+			auto self = (mn::Allocator)arg;
+			for (size_t j = 0; j < 1000; ++j)
+			{
+				auto block = mn::alloc_from(self, j + 1, alignof(char));
+				mn::free_from(self, block);
+			}
+		}, stats));
+	}
+	for (auto thread: threads)
+	{
+		mn::thread_join(thread);
+		mn::thread_free(thread);
+	}
+	mn::buf_free(threads);
+
+	counters = mn::allocator_stats_snapshot(stats);
+	CHECK(counters.live_bytes == 16);
+	CHECK(counters.alloc_count == 3 + 4000);
+	CHECK(counters.free_count == 2 + 4000);
+
+	auto out = mn::memory_stream_new();
+	mn::allocator_stats_dump(stats, out);
+	CHECK(mn::str_prefix(out->str, "Allocator 'unittest': live 16 bytes"));
+	mn::memory_stream_free(out);
+
+	mn::free_from(stats, a);
+	mn::allocator_free(stats);
+}
+
+TEST_CASE("heap profiler")
+{
+	// sample every allocation
+	auto profiler = mn::heap_profiler_new(1);
+	mn::heap_profiler_start(profiler);
+
+	mn::Block blocks[10];
+	for (auto& block: blocks)
+		block = mn::alloc_from(mn::memory::clib(), 64, alignof(int));
+	for (size_t i = 0; i < 5; ++i)
+		mn::free_from(mn::memory::clib(), blocks[i]);
+
+	mn::heap_profiler_stop(profiler);
+
+	auto summary = mn::heap_profiler_summary(profiler);
+	CHECK(summary.sample_count >= 10);
+	CHECK(summary.unique_callstacks >= 1);
+	CHECK(summary.alloc_bytes >= 10 * 64);
+	CHECK(summary.inuse_bytes >= 5 * 64);
+	CHECK(summary.inuse_bytes < summary.alloc_bytes);
+
+	auto out = mn::memory_stream_new();
+	mn::heap_profiler_dump_pprof(profiler, out);
+	CHECK(mn::str_prefix(out->str, "heap profile:"));
+	mn::memory_stream_free(out);
+
+	out = mn::memory_stream_new();
+	mn::heap_profiler_dump_collapsed(profiler, out);
+	CHECK(out->str.count > 0);
+	mn::memory_stream_free(out);
+
+	mn::heap_profiler_clear(profiler);
+	CHECK(mn::heap_profiler_summary(profiler).sample_count == 0);
+
+	for (size_t i = 5; i < 10; ++i)
+		mn::free_from(mn::memory::clib(), blocks[i]);
+	mn::heap_profiler_free(profiler);
+}
+
 TEST_CASE("fabric simple timer")
 {
 	mn::Fabric_Settings settings{};
@@ -1910,6 +3775,20 @@ TEST_CASE("msgpack: map")
 	CHECK(out_simple.values[0].value == 1);
 }
 
+TEST_CASE("msgpack: ordered map")
+{
+	auto simple = mn::ordered_map_with_allocator<mn::Str, int>(mn::memory::tmp());
+	mn::ordered_map_insert(simple, "b"_mnstr, 2);
+	mn::ordered_map_insert(simple, "a"_mnstr, 1);
+
+	CHECK(msgpack_encode_test(simple) == "[82, a1, 61, 1, a1, 62, 2]");
+
+	auto out_simple = msgpack_decode_test<mn::Ordered_Map<mn::Str, int>>({0x82, 0xa1, 0x62, 0x2, 0xa1, 0x61, 0x1});
+	CHECK(out_simple.count == 2);
+	CHECK(mn::ordered_map_begin(out_simple)->key == "a");
+	CHECK(mn::ordered_map_begin(out_simple)->value == 1);
+}
+
 struct Person
 {
 	mn::Str name;